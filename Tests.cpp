@@ -1,11 +1,42 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include "turingmachine/machines/RegularTuringMachine.h"
 #include "turingmachine/factory/TuringMachineFactory.h"
 #include "turingmachine/tapevisualizer/TapeVisualizer.h"
+#include "turingmachine/tapevisualizer/SpaceTimeDiagram.h"
+#include "turingmachine/compiled/CompiledMachine.h"
+#include "turingmachine/tape/TapeCodec.h"
+#include "turingmachine/machines/RegularExecution.h"
+#include "turingmachine/generator/WorkloadGenerator.h"
+#include "turingmachine/multitape/MultitapeTuringMachine.h"
+#include "turingmachine/trace/Trace.h"
+#include "turingmachine/stats/LatencySummary.h"
+#include "turingmachine/async/AsyncExecutor.h"
+#include "turingmachine/async/MachineScheduler.h"
+#include "turingmachine/memo/PrefixMemo.h"
+#include "turingmachine/cache/CachedTuringMachine.h"
+#include "turingmachine/machines/PipelineTuringMachine.h"
+#include "turingmachine/machines/GraphTuringMachine.h"
+#include "turingmachine/registry/ProgramRegistry.h"
+#include "turingmachine/machines/CompositionTuringMachine.h"
+#include "turingmachine/compiled/MachineFuser.h"
+#include "turingmachine/machines/IterationTuringMachine.h"
+#if !defined(_WIN32)
+#include "turingmachine/server/MachineServer.h"
+#include "turingmachine/server/MachineClient.h"
+#endif
 
 
 std::string readFirstLine(const std::string& filename) {
@@ -17,6 +48,27 @@ std::string readFirstLine(const std::string& filename) {
     return firstLine;
 }
 
+/// Reads one character at a time and, like std::cin on a pipe, cannot put any back.
+class UnbufferedInput : public std::streambuf {
+public:
+    explicit UnbufferedInput(std::string text) : text(std::move(text)) {}
+
+protected:
+    int_type underflow() override {
+        if (position == text.size()) {
+            return traits_type::eof();
+        }
+        current = text[position++];
+        setg(&current, &current, &current + 1);
+        return traits_type::to_int_type(current);
+    }
+
+private:
+    std::string text;
+    std::size_t position = 0;
+    char current = 0;
+};
+
 TEST_CASE("Testing Regular Turing Machine") {
     auto* factory = new TuringMachineFactory();
     auto tm = factory->getMachine("../testFiles/input/basic_regular.txt");
@@ -77,6 +129,1297 @@ TEST_CASE("Testing Loop Turing Machine") {
     delete factory;
 }
 
+TEST_CASE("Testing Binary Machine Format") {
+    CompiledMachine::convertTextToBinary("../testFiles/input/regular.txt", "../testFiles/output/regular.tmb");
+    REQUIRE(CompiledMachine::isBinaryFile("../testFiles/output/regular.tmb"));
+
+    auto* factory = new TuringMachineFactory();
+    auto tm = factory->getMachine("../testFiles/output/regular.tmb");
+    tm->run("../testFiles/output/regular_binary_output.txt");
+
+    std::string expectedOutput = ">1001 ";
+    REQUIRE(readFirstLine("../testFiles/output/regular_binary_output.txt") == expectedOutput);
+    delete factory;
+
+    // A header pointing outside the image is rejected when it is loaded; the tables are used in
+    // place, so transitions and names pointing outside it read as missing instead.
+    using ImageHeader = CompiledMachine::ImageHeader;
+    std::ifstream imageFile("../testFiles/output/regular.tmb", std::ios::binary);
+    const std::string image((std::istreambuf_iterator<char>(imageFile)), std::istreambuf_iterator<char>());
+    ImageHeader header{};
+    std::memcpy(&header, image.data(), sizeof(header));
+    auto loadCorrupted = [&image](std::size_t offset, std::uint32_t value) {
+        std::string corrupted = image;
+        std::memcpy(&corrupted[offset], &value, sizeof(value));
+        std::ofstream("../testFiles/output/corrupted.tmb", std::ios::binary) << corrupted;
+        return CompiledMachine::load("../testFiles/output/corrupted.tmb");
+    };
+    REQUIRE_NOTHROW(loadCorrupted(offsetof(ImageHeader, initialState), 0));
+    REQUIRE_THROWS_WITH_AS(loadCorrupted(offsetof(ImageHeader, initialState), header.stateCount),
+                           doctest::Contains("Corrupted"), std::runtime_error);
+    REQUIRE_THROWS_WITH_AS(loadCorrupted(offsetof(ImageHeader, stateCount), header.stateCount + 1),
+                           doctest::Contains("Corrupted"), std::runtime_error);
+
+    auto program = CompiledMachine::load("../testFiles/output/regular.tmb");
+    const std::size_t first = program->transitionIndex(program->lookup(program->getInitialState(), '0'));
+    auto badTarget = loadCorrupted(header.transitions.offset + first * sizeof(CompiledTransition), header.stateCount + 5);
+    REQUIRE(badTarget->describeTransition(first) == "0{s}->none");
+    REQUIRE(badTarget->decompile().transitions.size() + 1 == program->decompile().transitions.size());
+    RegularTuringMachine badTargetMachine(badTarget);
+    badTargetMachine.setInput(">0");
+    REQUIRE(badTargetMachine.advance() == TuringMachine::Status::NoTransition);
+
+    auto badNames = loadCorrupted(header.stateNameOffsets.offset + sizeof(std::uint32_t), 0x7FFFFFFF);
+    REQUIRE(badNames->getStateName(0).empty());
+    REQUIRE(badNames->getStateName(1).empty());
+    REQUIRE_FALSE(badNames->getStateName(2).empty());
+    std::filesystem::remove("../testFiles/output/corrupted.tmb");
+}
+
+TEST_CASE("Testing Machine Cache in Factory") {
+    TuringMachineFactory factory;
+    auto first = factory.getMachine("../testFiles/input/composition2.txt");
+    first->run("../testFiles/output/composition_output_factory.txt");
+    auto second = factory.getMachine("../testFiles/input/composition2.txt");
+    REQUIRE(factory.getCacheSize() == 1);
+
+    second->run("../testFiles/output/composition_output_factory.txt");
+    REQUIRE(readFirstLine("../testFiles/output/composition_output_factory.txt") == ">1001 ");
+
+    std::ofstream machineFile("../testFiles/output/cached_regular.txt");
+    machineFile << "REGULAR\n0{start}->1{start}R\n1{start}->0{halt}S\n1\nhalt\n>01\n";
+    machineFile.close();
+    factory.getMachine("../testFiles/output/cached_regular.txt")->run("../testFiles/output/cached_regular_output.txt");
+    REQUIRE(readFirstLine("../testFiles/output/cached_regular_output.txt") == ">10");
+
+    machineFile.open("../testFiles/output/cached_regular.txt");
+    machineFile << "REGULAR\n0{start}->1{start}R\n1{start}->1{halt}S\n {start}-> {halt}S\n1\nhalt\n>01\n";
+    machineFile.close();
+    factory.getMachine("../testFiles/output/cached_regular.txt")->run("../testFiles/output/cached_regular_output.txt");
+    REQUIRE(readFirstLine("../testFiles/output/cached_regular_output.txt") == ">11");
+    REQUIRE(factory.getCacheSize() == 2);
+}
+
+TEST_CASE("Testing Concurrent Executions of a Shared Program") {
+    std::ifstream machineFile("../testFiles/input/regular.txt");
+    std::string machineType;
+    std::getline(machineFile, machineType);
+    RegularTuringMachine machine;
+    machine.init(machineFile);
+
+    std::vector<std::string> results(4);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        workers.emplace_back([&machine, &results, i]() {
+            RegularExecution execution = machine.createExecution();
+            execution.run();
+            results[i] = execution.getTape().toString();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const auto& result : results) {
+        CHECK(result == ">1001 ");
+    }
+    REQUIRE(machine.getTape() == ">0110");
+
+    RegularExecution limited = machine.createExecution();
+    REQUIRE(limited.run(3) == RegularExecution::Status::Running);
+    REQUIRE(limited.getStepCount() == 3);
+    REQUIRE(limited.run() == RegularExecution::Status::Halted);
+    REQUIRE(limited.getTape().toString() == ">1001 ");
+}
+
+TEST_CASE("Testing Pooled Doubly Linked List") {
+    DoublyLinkedList<std::string> list;
+    for (int i = 0; i < 1000; ++i) {
+        list.push_back(std::to_string(i));
+    }
+    std::size_t capacity = list.getPool()->capacity();
+    REQUIRE(capacity >= 1000);
+
+    list.free();
+    REQUIRE(list.empty());
+    for (int i = 0; i < 1000; ++i) {
+        list.push_front(std::to_string(i));
+    }
+    REQUIRE(list.getPool()->capacity() == capacity);
+    REQUIRE(list.front() == "999");
+    REQUIRE(list.back() == "0");
+
+    DoublyLinkedList<std::string> shared(list.getPool());
+    shared.push_back("shared");
+    shared.free();
+    REQUIRE(list.back() == "0");
+    REQUIRE(shared.empty());
+}
+
+TEST_CASE("Testing Move, Swap and Splice of Tapes") {
+    DoublyLinkedList<char> first;
+    DoublyLinkedList<char> second;
+    for (char symbol : std::string("abc")) {
+        first.push_back(symbol);
+    }
+    for (char symbol : std::string("xyz")) {
+        second.push_back(symbol);
+    }
+
+    auto middle = first.begin();
+    ++middle;
+    first.splice(middle, second, second.begin(), second.last());
+    REQUIRE(first.front() == 'a');
+    REQUIRE(*(++first.begin()) == 'x');
+    REQUIRE(second.front() == 'z');
+    REQUIRE(second.back() == 'z');
+
+    first.swap(second);
+    REQUIRE(first.front() == 'z');
+    REQUIRE(second.back() == 'c');
+
+    DoublyLinkedList<char> moved(std::move(second));
+    REQUIRE(second.empty());
+    REQUIRE(moved.front() == 'a');
+    moved.free();
+    second.push_back('q');
+    REQUIRE(second.front() == 'q');
+
+    Tape tape(">0110", 3);
+    Tape target(std::move(tape));
+    REQUIRE(target.getHeadPosition() == 3);
+    REQUIRE(target.read() == '1');
+    REQUIRE(tape.empty());
+    target.moveRight();
+    target.moveRight();
+    REQUIRE(target.toString() == ">0110 ");
+
+    // The head crosses the blocks the cells are stored in both ways, and copies keep its cell.
+    const std::size_t count = 2 * Tape::BLOCK_SIZE + 10;
+    std::string expected;
+    Tape blocks("a");
+    for (std::size_t i = 0; i < count; ++i) {
+        expected += static_cast<char>('a' + i % 26);
+        blocks.write(expected.back());
+        blocks.moveRight();
+    }
+    REQUIRE(blocks.toString() == expected + " ");
+    REQUIRE(blocks.getHeadPosition() == count);
+    std::string backwards;
+    for (std::size_t i = 0; i < count; ++i) {
+        blocks.moveLeft();
+        backwards += blocks.read();
+    }
+    REQUIRE(std::string(backwards.rbegin(), backwards.rend()) == expected);
+    blocks.setHeadPosition(Tape::BLOCK_SIZE);
+    Tape copy(blocks);
+    copy.moveLeft();
+    REQUIRE(copy.read() == expected[Tape::BLOCK_SIZE - 1]);
+    REQUIRE(blocks.read() == expected[Tape::BLOCK_SIZE]);
+    copy.setHeadPosition(count + 5);
+    REQUIRE(copy.read() == Tape::BLANK);
+    REQUIRE(copy.size() == count + 6);
+}
+
+TEST_CASE("Testing Streaming Tape Input") {
+    std::istringstream lines(">0110\r\n>1\n");
+    Tape tape;
+    tape.load(lines, 1);
+    REQUIRE(tape.toString() == ">0110");
+    REQUIRE(tape.read() == '0');
+    tape.load(lines, 3);
+    REQUIRE(tape.toString() == ">1  ");
+    REQUIRE(tape.getHeadPosition() == 3);
+    tape.load(lines);
+    REQUIRE(tape.empty());
+
+    // Lines just under, at and well past the size of one read.
+    const std::string fileName = "../testFiles/output/streamed_tape.txt";
+    for (std::size_t length : {(std::size_t{1} << 20) - 1, std::size_t{1} << 20, (std::size_t{3} << 20) + 5}) {
+        std::string contents(length, '1');
+        contents.front() = '>';
+        contents.back() = '0';
+        {
+            std::ofstream file(fileName);
+            file << contents << "\nnext line";
+        }
+        Tape mapped;
+        mapped.loadFile(fileName, 1);
+        REQUIRE(mapped.size() == length);
+        REQUIRE(mapped.getHeadPosition() == 1);
+        REQUIRE(mapped.toString() == contents);
+
+        std::ifstream file(fileName);
+        Tape streamed;
+        streamed.load(file);
+        REQUIRE(streamed.toString() == contents);
+        std::string rest;
+        std::getline(file, rest);
+        REQUIRE(rest == "next line");
+    }
+
+    TuringMachineFactory factory;
+    auto reference = factory.getMachine("../testFiles/input/regular.txt");
+    reference->setInput(">0110");
+    reference->advance();
+
+    auto machine = factory.getMachine("../testFiles/input/regular.txt");
+    auto* regular = dynamic_cast<RegularTuringMachine*>(machine.get());
+    REQUIRE(regular != nullptr);
+    {
+        std::ofstream file(fileName);
+        file << ">0110\n";
+    }
+    regular->setInputFile(fileName);
+    regular->advance();
+    REQUIRE(regular->getOutput() == reference->getOutput());
+    REQUIRE(regular->getStepCount() == reference->getStepCount());
+
+    std::istringstream input(">0110");
+    regular->setInput(input);
+    regular->advance();
+    REQUIRE(regular->getOutput() == reference->getOutput());
+    std::filesystem::remove(fileName);
+    REQUIRE_THROWS_AS(regular->setInputFile(fileName), std::runtime_error);
+}
+
+TEST_CASE("Testing Lazily Mapped Tapes") {
+    const std::size_t block = TapeSource::BLOCK_SIZE;
+    const std::string fileName = "../testFiles/output/mapped_tape.txt";
+    std::string contents;
+    for (std::size_t i = 0; i < 3 * block + 100; ++i) {
+        contents += static_cast<char>('a' + i % 26);
+    }
+    {
+        std::ofstream file(fileName);
+        file << contents << '\n';
+    }
+
+    Tape tape;
+    tape.map(TapeSource::map(fileName), block + 5);
+    REQUIRE(tape.size() == contents.size());
+    REQUIRE(tape.loadedSize() == block);
+    REQUIRE(tape.read() == contents[block + 5]);
+    REQUIRE(tape.toString() == contents);
+    for (int i = 0; i < 6; ++i) {
+        tape.moveLeft();
+    }
+    REQUIRE(tape.getHeadPosition() == block - 1);
+    REQUIRE(tape.loadedSize() == 2 * block);
+    tape.write('#');
+    contents[block - 1] = '#';
+    REQUIRE(tape.toString() == contents);
+    // Visits stop at the limit, in the loaded cells and in the rest of the source alike.
+    for (std::size_t limit : {std::size_t(5), 2 * block + 10}) {
+        std::string visited;
+        tape.forEachChunk([&visited](const char* cells, std::size_t count) { visited.append(cells, count); }, limit);
+        REQUIRE(visited == contents.substr(0, limit));
+    }
+
+    Tape copy(tape);
+    copy.write('$');
+    REQUIRE(tape.toString() == contents);
+    REQUIRE(copy.loadedSize() == 2 * block);
+
+    tape.setHeadPosition(contents.size() - 1);
+    tape.moveRight();
+    REQUIRE(tape.read() == Tape::BLANK);
+    REQUIRE(tape.toString() == contents + " ");
+    tape.setHeadPosition(0);
+    REQUIRE(tape.loadedSize() == tape.size());
+
+    // A machine halting near the start of a long tape loads only the first block.
+    {
+        std::ofstream file(fileName);
+        file << ">0110 " << std::string(3 * block, '1') << '\n';
+    }
+    TuringMachineFactory factory;
+    auto machine = factory.getMachine("../testFiles/input/regular.txt");
+    auto* regular = dynamic_cast<RegularTuringMachine*>(machine.get());
+    REQUIRE(regular != nullptr);
+    regular->mapInputFile(fileName);
+    REQUIRE(regular->advance() == TuringMachine::Status::Halted);
+    REQUIRE(regular->getExecution().getTape().loadedSize() == block);
+    auto reference = factory.getMachine("../testFiles/input/regular.txt");
+    reference->setInput(">0110 " + std::string(3 * block, '1'));
+    reference->advance();
+    REQUIRE(regular->getOutput() == reference->getOutput());
+    REQUIRE(regular->getStepCount() == reference->getStepCount());
+
+    WorkloadGenerator::Parameters parameters;
+    parameters.tapeLength = 3 * block;
+    auto workload = WorkloadGenerator::generate(WorkloadGenerator::Kind::MultiTape, parameters);
+    WorkloadGenerator::writeFile("../testFiles/output/generated_workload.txt", workload);
+    auto multiTape = factory.getMachine("../testFiles/output/generated_workload.txt");
+    {
+        std::ofstream file(fileName);
+        file << multiTape->getOutput() << '\n';
+    }
+    auto mapped = multiTape->clone();
+    dynamic_cast<MultiTapeTuringMachine&>(*mapped).mapInputFile(fileName);
+    REQUIRE(mapped->getOutput() == multiTape->getOutput());
+    REQUIRE(mapped->advance(workload.expectedSteps / 2) == TuringMachine::Status::Running);
+    auto resumed = mapped->clone();
+    REQUIRE(multiTape->advance() == TuringMachine::Status::Halted);
+    REQUIRE(mapped->advance() == TuringMachine::Status::Halted);
+    REQUIRE(resumed->advance() == TuringMachine::Status::Halted);
+    REQUIRE(mapped->getOutput() == multiTape->getOutput());
+    REQUIRE(resumed->getOutput() == multiTape->getOutput());
+    REQUIRE(mapped->getStepCount() == workload.expectedSteps);
+    std::filesystem::remove(fileName);
+}
+
+TEST_CASE("Testing Compressed Tapes") {
+    const std::string contents = ">" + std::string(10000, '1') + std::string(50000, Tape::BLANK) + "01";
+    const Tape tape(contents, 1);
+    const std::string fileName = "../testFiles/output/compressed_tape.bin";
+
+    for (auto format : {TapeCodec::Format::Raw, TapeCodec::Format::Rle, TapeCodec::Format::Deflate}) {
+        if (!TapeCodec::isAvailable(format)) {
+            REQUIRE_THROWS_AS(TapeCodec::write(tape, std::cout, format), std::invalid_argument);
+            continue;
+        }
+        REQUIRE(TapeCodec::parseFormat(TapeCodec::formatName(format)) == format);
+        std::ostringstream encoded;
+        TapeCodec::write(tape, encoded, format);
+        if (format != TapeCodec::Format::Raw) {
+            REQUIRE(encoded.str().size() < 100);
+        }
+
+        std::istringstream in(encoded.str());
+        Tape decoded;
+        TapeCodec::read(in, decoded, 3);
+        REQUIRE(decoded.toString() == contents);
+        REQUIRE(decoded.getHeadPosition() == 3);
+
+        {
+            std::ofstream file(fileName, std::ios::binary);
+            file << encoded.str();
+        }
+        Tape loaded;
+        TapeCodec::readFile(fileName, loaded, 1);
+        REQUIRE(loaded.toString() == contents);
+    }
+    REQUIRE_THROWS_AS(TapeCodec::parseFormat("zip"), std::invalid_argument);
+
+    // RLE runs continue across the chunks the tape is encoded in.
+    std::ostringstream runs;
+    TapeCodec::write(Tape(std::string(200000, 'a')), runs, TapeCodec::Format::Rle);
+    REQUIRE(runs.str() == std::string("\x89TMR\xC0\x9A\x0C" "a", 8));
+
+    std::istringstream truncated(std::string("\x89TMR\x85", 5));
+    Tape broken;
+    REQUIRE_THROWS_AS(TapeCodec::read(truncated, broken), std::runtime_error);
+    std::istringstream unknown(std::string("\x89TMQ", 4));
+    REQUIRE_THROWS_AS(TapeCodec::read(unknown, broken), std::runtime_error);
+
+    // A compressed input tape runs like the raw one.
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        TapeCodec::write(Tape(">0110"), file, TapeCodec::Format::Rle);
+    }
+    TuringMachineFactory factory;
+    auto machine = factory.getMachine("../testFiles/input/regular.txt");
+    auto* regular = dynamic_cast<RegularTuringMachine*>(machine.get());
+    REQUIRE(regular != nullptr);
+    regular->setInputFile(fileName);
+    regular->advance();
+    auto reference = factory.getMachine("../testFiles/input/regular.txt");
+    reference->setInput(">0110");
+    reference->advance();
+    REQUIRE(regular->getOutput() == reference->getOutput());
+    REQUIRE(regular->getStepCount() == reference->getStepCount());
+    std::filesystem::remove(fileName);
+}
+
+TEST_CASE("Testing Step-Limited Execution") {
+    TuringMachineFactory factory;
+    std::vector<std::pair<std::string, std::string>> machines = {
+            {"../testFiles/input/regular.txt", ">1001 "},
+            {"../testFiles/input/composition.txt", ">BBB BB"},
+            {"../testFiles/input/composition2.txt", ">1001 "},
+            {"../testFiles/input/conditional.txt", ">1 10"},
+            {"../testFiles/input/loop.txt", ">01010 "}};
+    for (const auto& [fileName, expectedOutput] : machines) {
+        auto whole = factory.getMachine(fileName);
+        REQUIRE(whole->advance() != TuringMachine::Status::Running);
+
+        // One step at a time ends in the same configuration.
+        auto stepped = factory.getMachine(fileName);
+        std::uint64_t calls = 0;
+        TuringMachine::Status status;
+        do {
+            status = stepped->advance(1);
+            REQUIRE(stepped->getStepCount() <= ++calls);
+        } while (status == TuringMachine::Status::Running);
+        REQUIRE(whole->getOutput() == expectedOutput);
+        REQUIRE(stepped->getOutput() == expectedOutput);
+        REQUIRE(stepped->getStepCount() == whole->getStepCount());
+
+        // run() is advance() followed by writing the tape, also when the machine runs again.
+        auto ran = factory.getMachine(fileName);
+        const std::string initialTape = ran->getOutput();
+        for (int i = 0; i < 2; ++i) {
+            ran->run("../testFiles/output/step_limited_output.txt");
+            REQUIRE(readFirstLine("../testFiles/output/step_limited_output.txt") == expectedOutput);
+            REQUIRE(ran->getStepCount() == whole->getStepCount());
+            ran->setInput(initialTape);
+        }
+    }
+    std::filesystem::remove("../testFiles/output/step_limited_output.txt");
+
+    auto regular = factory.getMachine("../testFiles/input/regular.txt");
+    regular->setInput(">0110");
+    regular->advance();
+    regular->setInput(">0110");
+    regular->advance();
+    auto reference = factory.getMachine("../testFiles/input/regular.txt");
+    reference->advance();
+    REQUIRE(regular->getOutput() == reference->getOutput());
+    REQUIRE(regular->getStepCount() == reference->getStepCount());
+
+    WorkloadGenerator::Parameters parameters;
+    parameters.tapeLength = 5;
+    for (auto kind : {WorkloadGenerator::Kind::Composition, WorkloadGenerator::Kind::Loop,
+                      WorkloadGenerator::Kind::Conditional, WorkloadGenerator::Kind::MultiTape}) {
+        auto workload = WorkloadGenerator::generate(kind, parameters);
+        WorkloadGenerator::writeFile("../testFiles/output/generated_workload.txt", workload);
+        auto machine = factory.getMachine("../testFiles/output/generated_workload.txt");
+        REQUIRE(machine->advance(workload.expectedSteps - 1) == TuringMachine::Status::Running);
+        REQUIRE(machine->advance() == TuringMachine::Status::Halted);
+        REQUIRE(machine->getStepCount() == workload.expectedSteps);
+    }
+}
+
+TEST_CASE("Testing Workload Generator") {
+    WorkloadGenerator::Parameters parameters;
+    parameters.states = 5;
+    parameters.alphabetSize = 3;
+    parameters.tapeLength = 6;
+    parameters.steps = 2000;
+
+    for (auto kind : {WorkloadGenerator::Kind::Regular, WorkloadGenerator::Kind::BinaryCounter,
+                      WorkloadGenerator::Kind::UnaryMultiplication, WorkloadGenerator::Kind::Palindrome,
+                      WorkloadGenerator::Kind::BusyBeaver}) {
+        WorkloadGenerator::Parameters sized = parameters;
+        if (kind == WorkloadGenerator::Kind::BusyBeaver) {
+            sized.states = 4;
+            sized.tapeLength = 16;
+        }
+        auto workload = WorkloadGenerator::generate(kind, sized);
+        std::istringstream description(workload.description);
+        std::string machineType;
+        std::getline(description, machineType);
+        REQUIRE(machineType == "REGULAR");
+
+        RegularTuringMachine machine;
+        machine.init(description);
+        RegularExecution execution = machine.createExecution();
+        REQUIRE(execution.run() == RegularExecution::Status::Halted);
+        REQUIRE(workload.exact);
+        REQUIRE(execution.getStepCount() == workload.expectedSteps);
+        REQUIRE((kind == WorkloadGenerator::Kind::BusyBeaver || workload.expectedSteps >= parameters.steps));
+    }
+
+    parameters.states = 3;
+    parameters.steps = 200;
+    auto conditional = WorkloadGenerator::generate(WorkloadGenerator::Kind::Conditional, parameters);
+    WorkloadGenerator::writeFile("../testFiles/output/generated_conditional.txt", conditional);
+    TuringMachineFactory factory;
+    factory.getMachine("../testFiles/output/generated_conditional.txt")->run("../testFiles/output/generated_conditional_output.txt");
+    REQUIRE(readFirstLine("../testFiles/output/generated_conditional_output.txt") == ">+++++++122200 ");
+    REQUIRE(conditional.expectedSteps == 239);
+
+    REQUIRE(WorkloadGenerator::parseKind("busy-beaver") == WorkloadGenerator::Kind::BusyBeaver);
+    REQUIRE_THROWS_AS(WorkloadGenerator::parseKind("quantum"), std::invalid_argument);
+}
+
+TEST_CASE("Testing Execution Statistics") {
+    WorkloadGenerator::Parameters parameters;
+    parameters.tapeLength = 3;
+    auto counter = WorkloadGenerator::generate(WorkloadGenerator::Kind::BinaryCounter, parameters);
+    std::istringstream counterDescription(counter.description.substr(counter.description.find('\n') + 1));
+    RegularTuringMachine regular;
+    regular.enableStats();
+    regular.init(counterDescription);
+    regular.run("../testFiles/output/stats_counter_output.txt");
+
+    const std::optional<ExecutionStats> stats = regular.getStats();
+    REQUIRE(stats.has_value());
+    REQUIRE(stats->steps == counter.expectedSteps);
+    REQUIRE(stats->headTravel == counter.expectedSteps - 1);
+    REQUIRE(stats->minHeadOffset == -1);
+    REQUIRE(stats->maxHeadOffset == 3);
+    REQUIRE(stats->tapeGrowth == 1);
+    std::uint64_t stateSteps = 0;
+    for (std::uint64_t hits : stats->stateHits) {
+        stateSteps += hits;
+    }
+    REQUIRE(stateSteps == counter.expectedSteps);
+    REQUIRE(regular.getProgram()->describeTransition(stats->hottestTransitions(1).front()) == " {right}-> {carry}L");
+
+    std::ostringstream json;
+    regular.writeStats(json, 3);
+    REQUIRE(json.str().find("\"steps\": 30") != std::string::npos);
+
+    parameters.tapeLength = 4;
+    auto sweep = WorkloadGenerator::generate(WorkloadGenerator::Kind::MultiTape, parameters);
+    std::istringstream sweepDescription(sweep.description.substr(sweep.description.find('\n') + 1));
+    MultiTapeTuringMachine multiTape;
+    multiTape.init(sweepDescription);
+    multiTape.enableStats();
+    multiTape.run("../testFiles/output/stats_multitape_output.txt");
+    REQUIRE(multiTape.getStats()->steps == sweep.expectedSteps);
+    REQUIRE(multiTape.getStats()->headTravel == 9);
+    REQUIRE(multiTape.getStats()->maxHeadOffset == 5);
+}
+
+TEST_CASE("Testing Trace Export") {
+    WorkloadGenerator::Parameters parameters;
+    parameters.tapeLength = 3;
+    auto counter = WorkloadGenerator::generate(WorkloadGenerator::Kind::BinaryCounter, parameters);
+    std::istringstream counterDescription(counter.description.substr(counter.description.find('\n') + 1));
+
+    Trace::clear();
+    Trace::setSampleInterval(1);
+    Trace::start();
+    RegularTuringMachine regular;
+    regular.init(counterDescription);
+    regular.run("../testFiles/output/trace_counter_output.txt");
+    Trace::stop();
+    Trace::setSampleInterval(65536);
+
+    std::ostringstream json;
+    Trace::writeChromeJson(json);
+    Trace::clear();
+    REQUIRE(json.str().find("\"traceEvents\":[") != std::string::npos);
+    if (Trace::isCompiledIn()) {
+        REQUIRE(json.str().find("\"name\":\"parse\",\"cat\":\"turing_machine\",\"ph\":\"X\"") != std::string::npos);
+        REQUIRE(json.str().find("\"name\":\"run\"") != std::string::npos);
+        REQUIRE(json.str().find("\"name\":\"output\"") != std::string::npos);
+        REQUIRE(json.str().find("\"ph\":\"C\"") != std::string::npos);
+    } else {
+        REQUIRE(json.str().find("\"ph\"") == std::string::npos);
+    }
+}
+
+TEST_CASE("Testing Asynchronous Execution") {
+    WorkloadGenerator::Parameters parameters;
+    parameters.tapeLength = 8;
+    auto counter = WorkloadGenerator::generate(WorkloadGenerator::Kind::BinaryCounter, parameters);
+    WorkloadGenerator::writeFile("../testFiles/output/async_counter.txt", counter);
+    TuringMachineFactory factory;
+
+    // One event loop, driven by the test, multiplexes all the machines in slices.
+    AsyncExecutor loop(0);
+    const std::size_t machines = 100;
+    std::vector<std::shared_ptr<AsyncExecution>> executions;
+    std::vector<std::uint64_t> slices(machines, 0);
+    std::size_t completed = 0;
+    std::size_t finishedBeforeAllStarted = 0;
+    for (std::size_t i = 0; i < machines; ++i) {
+        AsyncOptions options;
+        options.sliceSteps = 100;
+        options.onProgress = [&slices, i](const ExecutionProgress& progress) {
+            ++slices[i];
+            REQUIRE(progress.steps == slices[i] * 100);
+        };
+        options.onComplete = [&](const AsyncResult&) {
+            ++completed;
+            // Every machine but the cancelled one needs several slices.
+            if (std::count(slices.begin(), slices.end(), 0) > 1) {
+                ++finishedBeforeAllStarted;
+            }
+        };
+        if (i == 1) {
+            options.maxSteps = 250;
+        }
+        executions.push_back(loop.launch(factory.getMachine("../testFiles/output/async_counter.txt"), options));
+    }
+    executions[2]->cancel();
+    REQUIRE(loop.getActiveCount() == machines);
+
+    loop.runUntilIdle();
+    REQUIRE(loop.getActiveCount() == 0);
+    REQUIRE(completed == machines);
+    REQUIRE(finishedBeforeAllStarted <= 1); // Only the cancelled one ends before every machine had a slice.
+
+    AsyncResult limited = executions[1]->wait();
+    REQUIRE(limited.status == TuringMachine::Status::Running);
+    REQUIRE(limited.steps == 250);
+    REQUIRE(executions[2]->wait().cancelled);
+    REQUIRE(executions[2]->getProgress().steps == 0);
+    for (std::size_t i = 3; i < machines; ++i) {
+        AsyncResult result = executions[i]->getFuture().get();
+        REQUIRE(result.status == TuringMachine::Status::Halted);
+        REQUIRE(result.steps == counter.expectedSteps);
+        REQUIRE(executions[i]->getProgress().tapeSize == 10);
+        REQUIRE(executions[i]->getMachine().getOutput() == ">00000000 ");
+    }
+
+    // The same with loop threads, waiting on the futures.
+    AsyncExecutor threaded(2);
+    auto first = threaded.launch(factory.getMachine("../testFiles/output/async_counter.txt"));
+    AsyncOptions smallSlices;
+    smallSlices.sliceSteps = 7;
+    auto second = threaded.launch(factory.getMachine("../testFiles/output/async_counter.txt"), smallSlices);
+    REQUIRE(first->wait().steps == counter.expectedSteps);
+    REQUIRE(second->wait().steps == counter.expectedSteps);
+}
+
+TEST_CASE("Testing Machine Scheduler") {
+    WorkloadGenerator::Parameters parameters;
+    parameters.tapeLength = 12;
+    auto longCounter = WorkloadGenerator::generate(WorkloadGenerator::Kind::BinaryCounter, parameters);
+    WorkloadGenerator::writeFile("../testFiles/output/scheduler_counter.txt", longCounter);
+    parameters.tapeLength = 8;
+    auto shortCounter = WorkloadGenerator::generate(WorkloadGenerator::Kind::BinaryCounter, parameters);
+    TuringMachineFactory factory;
+    auto longMachine = [&factory]() { return factory.getMachine("../testFiles/output/scheduler_counter.txt"); };
+    auto shortMachine = [&factory]() { return factory.getMachine("../testFiles/output/async_counter.txt"); };
+
+    // Long machines submitted first do not hold up the short ones behind them.
+    MachineScheduler::Options options;
+    options.quantum = 64;
+    std::vector<std::string> order;
+    auto record = [&order](const std::string& name) {
+        AsyncOptions job;
+        job.onComplete = [&order, name](const AsyncResult&) { order.push_back(name); };
+        return job;
+    };
+    {
+        MachineScheduler scheduler(options);
+        for (int i = 0; i < 3; ++i) {
+            scheduler.submit(longMachine(), 0, record("long"));
+        }
+        std::vector<std::shared_ptr<AsyncExecution>> shorts;
+        for (int i = 0; i < 20; ++i) {
+            shorts.push_back(scheduler.submit(shortMachine(), 0, record("short")));
+        }
+        AsyncOptions budget;
+        budget.maxSteps = 100;
+        auto limited = scheduler.submit(longMachine(), 0, budget);
+        scheduler.runUntilIdle();
+
+        REQUIRE(order.size() == 23);
+        REQUIRE(std::find(order.begin(), order.end(), "long") - order.begin() == 20);
+        for (auto& execution : shorts) {
+            REQUIRE(execution->wait().steps == shortCounter.expectedSteps);
+        }
+        AsyncResult result = limited->wait();
+        REQUIRE(result.status == TuringMachine::Status::Running);
+        REQUIRE(result.steps == 100);
+
+        SchedulerMetrics metrics = scheduler.getMetrics();
+        REQUIRE(metrics.submitted == 24);
+        REQUIRE(metrics.completed == 24);
+        REQUIRE(metrics.cancelled == 0);
+        REQUIRE(metrics.queued == 0);
+        REQUIRE(metrics.steps == 3 * longCounter.expectedSteps + 20 * shortCounter.expectedSteps + 100);
+        REQUIRE(metrics.queueLatency.count == 24);
+        REQUIRE(metrics.turnaround.count == 24);
+        REQUIRE(metrics.sliceWait.count == metrics.slices - 24);
+        REQUIRE(metrics.stepsPerSecond > 0);
+    }
+
+    // Without aging a higher priority always goes first...
+    options.agingInterval = std::chrono::hours(1);
+    order.clear();
+    {
+        MachineScheduler scheduler(options);
+        scheduler.submit(shortMachine(), 0, record("low"));
+        scheduler.submit(longMachine(), 5, record("high"));
+        scheduler.runUntilIdle();
+        REQUIRE(order == std::vector<std::string>{"high", "low"});
+    }
+
+    // ...while with aging the waiting job catches up after five intervals.
+    options.agingInterval = std::chrono::microseconds(1);
+    order.clear();
+    {
+        MachineScheduler scheduler(options);
+        scheduler.submit(shortMachine(), 0, record("low"));
+        scheduler.submit(longMachine(), 5, record("high"));
+        scheduler.runUntilIdle();
+        REQUIRE(order == std::vector<std::string>{"low", "high"});
+    }
+
+    // A fixed worker pool, and jobs still queued when the scheduler goes away are cancelled.
+    options.workers = 4;
+    std::vector<std::shared_ptr<AsyncExecution>> executions;
+    {
+        MachineScheduler scheduler(options);
+        for (int i = 0; i < 40; ++i) {
+            executions.push_back(scheduler.submit(i % 4 == 0 ? longMachine() : shortMachine(), i % 3));
+        }
+        for (std::size_t i = 0; i < executions.size(); ++i) {
+            AsyncResult result = executions[i]->wait();
+            REQUIRE(result.status == TuringMachine::Status::Halted);
+            REQUIRE(result.steps == (i % 4 == 0 ? longCounter.expectedSteps : shortCounter.expectedSteps));
+        }
+        REQUIRE(scheduler.getMetrics().completed == 40);
+
+        for (int i = 0; i < 8; ++i) {
+            AsyncOptions forever;
+            forever.maxSteps = TuringMachine::UNLIMITED;
+            executions.push_back(scheduler.submit(longMachine(), 0, forever));
+        }
+    }
+    for (std::size_t i = 40; i < executions.size(); ++i) {
+        REQUIRE(executions[i]->isDone());
+    }
+}
+
+TEST_CASE("Testing Prefix Memoisation") {
+    // Every run must match a plain run of the same machine, cached or not.
+    auto check = [](PrefixMemo& memo, RegularTuringMachine& plain, const std::string& input, std::uint64_t maxSteps) {
+        PrefixMemo::Result result = memo.run(input, maxSteps);
+        plain.setInput(input);
+        REQUIRE(result.status == plain.advance(maxSteps));
+        REQUIRE(result.steps == plain.getStepCount());
+        REQUIRE(result.tape == plain.getOutput());
+        REQUIRE(result.head == static_cast<std::size_t>(plain.getCurrentPosition()));
+        return result;
+    };
+
+    // A left-to-right scan over a shared header resumes at the end of the header.
+    TuringMachineFactory factory;
+    auto scannerMachine = factory.getMachine("../testFiles/input/regular.txt");
+    auto& scanner = dynamic_cast<RegularTuringMachine&>(*scannerMachine);
+    PrefixMemo memo(scanner.getProgram(), PrefixMemo::Options{16});
+    std::srand(7);
+    auto bits = [](std::size_t count) {
+        std::string text;
+        for (std::size_t i = 0; i < count; ++i) {
+            text += static_cast<char>('0' + std::rand() % 2);
+        }
+        return text;
+    };
+    const std::string header = ">" + bits(400);
+    check(memo, scanner, header + bits(40), TuringMachine::UNLIMITED);
+    REQUIRE(memo.getStats().snapshots == 27);
+    for (int i = 0; i < 20; ++i) {
+        PrefixMemo::Result result = check(memo, scanner, header + bits(std::rand() % 60), TuringMachine::UNLIMITED);
+        REQUIRE(result.skippedSteps >= 2 * 384);
+    }
+    PrefixMemo::Stats stats = memo.getStats();
+    REQUIRE(stats.runs == 21);
+    REQUIRE(stats.resumed == 20);
+    REQUIRE(stats.replayed == 0);
+
+    // A run that halts inside the input is replayed from the cache as a whole.
+    const std::string early = header + " " + bits(100);
+    check(memo, scanner, early, TuringMachine::UNLIMITED);
+    REQUIRE(check(memo, scanner, early, TuringMachine::UNLIMITED).skippedSteps == 2 * 400 + 1);
+    REQUIRE(memo.getStats().replayed == 1);
+
+    // Step limits below and above the cached configurations.
+    check(memo, scanner, header, 100);
+    check(memo, scanner, header + "01", 500);
+    check(memo, scanner, early, 800);
+
+    // A machine that moves back and forth over the whole tape.
+    auto counterMachine = factory.getMachine("../testFiles/output/async_counter.txt");
+    auto& counter = dynamic_cast<RegularTuringMachine&>(*counterMachine);
+    PrefixMemo counterMemo(counter.getProgram(), PrefixMemo::Options{4});
+    const std::string counterHeader = ">" + bits(8);
+    for (int i = 0; i < 30; ++i) {
+        check(counterMemo, counter, counterHeader + bits(std::rand() % 4), 2000 + std::rand() % 2000);
+    }
+    REQUIRE(counterMemo.getStats().resumed > 0);
+
+    counterMemo.clear();
+    REQUIRE(counterMemo.getStats().snapshots == 0);
+    REQUIRE(counterMemo.getStats().bytes == 0);
+}
+
+TEST_CASE("Testing Result Cache") {
+    const std::string directory = "../testFiles/output/result_cache";
+    std::filesystem::remove_all(directory);
+    ResultCache::Options options;
+    options.capacity = 2;
+    options.directory = directory;
+    auto results = std::make_shared<ResultCache>(options);
+    TuringMachineFactory factory;
+    factory.setResultCache(results);
+
+    auto plain = TuringMachineFactory().getMachine("../testFiles/input/regular.txt");
+    plain->setInput(">0110");
+    REQUIRE(plain->advance() == TuringMachine::Status::Halted);
+
+    auto first = factory.getMachine("../testFiles/input/regular.txt");
+    first->setInput(">0110");
+    REQUIRE(first->advance() == TuringMachine::Status::Halted);
+    REQUIRE_FALSE(dynamic_cast<CachedTuringMachine&>(*first).isCachedResult());
+
+    // The same program and input again, from another machine: nothing runs.
+    auto second = factory.getMachine("../testFiles/input/regular.txt");
+    second->setInput(">0110");
+    REQUIRE(second->advance() == TuringMachine::Status::Halted);
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*second).isCachedResult());
+    REQUIRE(second->getOutput() == ">1001 ");
+    REQUIRE(second->getStepCount() == plain->getStepCount());
+    REQUIRE(second->getHeadPosition() == plain->getHeadPosition());
+    REQUIRE(second->getStateName() == "halt");
+    REQUIRE(second->clone()->getOutput() == ">1001 ");
+
+    // A result beyond the step limit is not used; unfinished runs are not cached.
+    second->setInput(">0110");
+    REQUIRE(second->advance(3) == TuringMachine::Status::Running);
+    REQUIRE(second->getStepCount() == 3);
+    ResultCache::Stats stats = results->getStats();
+    REQUIRE(stats.hits == 2);
+    REQUIRE(stats.misses == 1);
+    REQUIRE(stats.entries == 1);
+
+    // A run finished over several calls is cached too; the tape of the description is an input.
+    auto stepwise = factory.getMachine("../testFiles/input/regular.txt");
+    stepwise->setInput(">1");
+    while (stepwise->advance(1) == TuringMachine::Status::Running) {
+    }
+    second->setInput(">1");
+    REQUIRE(second->advance() == TuringMachine::Status::Halted);
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*second).isCachedResult());
+    REQUIRE(second->getOutput() == ">0 ");
+    auto described = factory.getMachine("../testFiles/input/regular.txt"); // Its tape is >0110.
+    REQUIRE(described->advance() == TuringMachine::Status::Halted);
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*described).isCachedResult());
+    REQUIRE(described->getOutput() == ">1001 ");
+
+    // Composite machines are keyed by their description.
+    auto composition = factory.getMachine("../testFiles/input/composition.txt");
+    composition->advance();
+    auto repeated = factory.getMachine("../testFiles/input/composition.txt");
+    REQUIRE(repeated->advance() == composition->advance());
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*repeated).isCachedResult());
+    REQUIRE(repeated->getOutput() == composition->getOutput());
+
+    // Three results in a cache of two: the oldest is evicted from memory but found on disk,
+    // also by another cache over the same directory.
+    stats = results->getStats();
+    REQUIRE(stats.entries == 2);
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.diskWrites == 3);
+    second->setInput(">1");
+    second->advance();
+    REQUIRE(second->getOutput() == ">0 ");
+    REQUIRE(results->getStats().diskHits == 1);
+
+    auto restarted = std::make_shared<ResultCache>(options);
+    factory.setResultCache(restarted);
+    auto reloaded = factory.getMachine("../testFiles/input/composition.txt");
+    reloaded->advance();
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*reloaded).isCachedResult());
+    REQUIRE(reloaded->getOutput() == composition->getOutput());
+    REQUIRE(restarted->getStats().diskHits == 1);
+
+    // Files that differ only in their tape run the same program.
+    const std::string otherTapeFileName = "../testFiles/output/regular_other_tape.txt";
+    std::ofstream(otherTapeFileName) << "REGULAR\n0{s}->1{q}S\n1{s}->0{q}S\n {s}-> {halt}S\n>{s}->>{s}R\n"
+                                     << "0{q}->0{s}R\n1{q}->1{s}R\n {q}-> {s}R\n>{q}->>{s}R\n1\nhalt\n>1\n";
+    auto otherTape = factory.getMachine(otherTapeFileName); // The same program as regular.txt.
+    REQUIRE(otherTape->advance() == TuringMachine::Status::Halted);
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*otherTape).isCachedResult());
+    REQUIRE(otherTape->getOutput() == ">0 ");
+    std::filesystem::remove(otherTapeFileName);
+
+    // run() is answered from the cache too, and writes the cached tape.
+    auto running = factory.getMachine("../testFiles/input/composition.txt");
+    running->run("../testFiles/output/cached_composition_output.txt");
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*running).isCachedResult());
+    REQUIRE(readFirstLine("../testFiles/output/cached_composition_output.txt") == composition->getOutput());
+    auto unseen = factory.getMachine("../testFiles/input/regular.txt");
+    unseen->setInput(">000111");
+    unseen->run("../testFiles/output/cached_composition_output.txt");
+    REQUIRE_FALSE(dynamic_cast<CachedTuringMachine&>(*unseen).isCachedResult());
+    second->setInput(">000111");
+    REQUIRE(second->advance() == TuringMachine::Status::Halted);
+    REQUIRE(dynamic_cast<CachedTuringMachine&>(*second).isCachedResult());
+    REQUIRE(second->getOutput() == readFirstLine("../testFiles/output/cached_composition_output.txt"));
+    std::filesystem::remove("../testFiles/output/cached_composition_output.txt");
+
+    // Composites are keyed by the programs of their components too, which USE lines take from other files.
+    const std::string libraryFileName = "../testFiles/output/cached_library.txt";
+    const std::string compositeFileName = "../testFiles/output/cached_composite.txt";
+    std::ofstream(libraryFileName) << "REGULAR\n0{s}->1{s}R\n1{s}->0{s}R\n {s}-> {halt}S\n1\nhalt\n>0\n";
+    std::ofstream(compositeFileName) << "COMPOSITION\nUSE cached_library.txt\nSECOND MACHINE STATES\n"
+                                     << "USE ../input/library/scan.txt\n>0110\n";
+    auto inverting = factory.getMachine(compositeFileName);
+    inverting->advance();
+    REQUIRE(inverting->getOutput() == ">1001 ");
+    std::ofstream(libraryFileName) << "REGULAR\n0{s}->0{s}R\n1{s}->1{s}R\n {s}-> {halt}S\n1\nhalt\n>0\n";
+    factory.clearCache();
+    auto copying = factory.getMachine(compositeFileName);
+    copying->advance();
+    REQUIRE_FALSE(dynamic_cast<CachedTuringMachine&>(*copying).isCachedResult());
+    REQUIRE(copying->getOutput() == ">0110 ");
+    std::filesystem::remove(libraryFileName);
+    std::filesystem::remove(compositeFileName);
+
+    factory.setResultCache(nullptr);
+    REQUIRE(dynamic_cast<CachedTuringMachine*>(factory.getMachine("../testFiles/input/regular.txt").get()) == nullptr);
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Testing Pipeline Machine") {
+    TuringMachineFactory factory;
+    auto pipeline = factory.getMachine("../testFiles/input/pipeline.txt");
+    auto& stages = dynamic_cast<PipelineTuringMachine&>(*pipeline);
+    REQUIRE(stages.getStageCount() == 5);
+    pipeline->run("../testFiles/output/pipeline_output.txt");
+    REQUIRE(readFirstLine("../testFiles/output/pipeline_output.txt") == ">01101");
+    REQUIRE(stages.getStage() == 4);
+    REQUIRE(pipeline->getStepCount() == 5 + 5 + 5 + 5 + 5);
+
+    // Stepping through the stages gives the same run.
+    pipeline->setInput(">10");
+    std::uint64_t calls = 0;
+    while (pipeline->advance(2) == TuringMachine::Status::Running) {
+        ++calls;
+    }
+    REQUIRE(calls == 7);
+    REQUIRE(pipeline->getOutput() == ">101");
+    REQUIRE(pipeline->clone()->getOutput() == ">101");
+
+    // A two-stage pipeline behaves like the composition of the same blocks.
+    std::ifstream compositionFile("../testFiles/input/composition.txt");
+    std::string compositionType;
+    std::getline(compositionFile, compositionType);
+    PipelineTuringMachine twoStages(compositionFile);
+    twoStages.run("../testFiles/output/pipeline_composition_output.txt");
+    auto composition = factory.getMachine("../testFiles/input/composition.txt");
+    composition->advance();
+    REQUIRE(readFirstLine("../testFiles/output/pipeline_composition_output.txt") == composition->getOutput());
+    REQUIRE(twoStages.getStepCount() == composition->getStepCount());
+}
+
+TEST_CASE("Testing Program Registry") {
+    ProgramRegistry& registry = ProgramRegistry::global();
+    registry.clear();
+    TuringMachineFactory factory;
+
+    // The referenced files hold the blocks of composition2.txt, so both composites share them.
+    auto inlined = factory.getMachine("../testFiles/input/composition2.txt");
+    auto referenced = factory.getMachine("../testFiles/input/composition_use.txt");
+    ProgramRegistry::Stats stats = registry.getStats();
+    REQUIRE(stats.fileLoads == 2);
+    REQUIRE(stats.deduplicated == 2);
+    REQUIRE(stats.programs == 2);
+    referenced->run("../testFiles/output/composition_use_output.txt");
+    inlined->advance();
+    REQUIRE(readFirstLine("../testFiles/output/composition_use_output.txt") == inlined->getOutput());
+
+    // Named programs, and files that have not changed, are not read again.
+    registry.define("invert", registry.load("../testFiles/input/library/invert.txt"));
+    std::istringstream named("USE invert\nSECOND MACHINE STATES\nUSE ../testFiles/input/library/scan.txt\n>01\n");
+    CompositionTuringMachine composition(named);
+    REQUIRE(composition.advance() == TuringMachine::Status::Halted);
+    REQUIRE(composition.getOutput() == ">10 ");
+    stats = registry.getStats();
+    REQUIRE(stats.fileLoads == 2);
+    REQUIRE(stats.fileHits == 2);
+    REQUIRE(stats.programs == 2);
+
+    std::istringstream composite("USE ../testFiles/input/composition.txt\nSECOND MACHINE STATES\nUSE invert\n>0\n");
+    REQUIRE_THROWS_AS(CompositionTuringMachine{composite}, std::runtime_error);
+    std::istringstream missing("USE ../testFiles/input/library/missing.txt\nSECOND MACHINE STATES\nUSE invert\n>0\n");
+    REQUIRE_THROWS_AS(CompositionTuringMachine{missing}, std::runtime_error);
+    {
+        std::ofstream circular("../testFiles/output/circular.txt");
+        circular << "REGULAR\nUSE circular.txt\n>0\n";
+    }
+    REQUIRE_THROWS_AS(registry.load("../testFiles/output/circular.txt"), std::runtime_error);
+
+    // Files named in USE lines of files are relative to the directory of the file. Cached
+    // prototypes and loaded files are checked against every file their USE lines read.
+    const std::string innerFileName = "../testFiles/output/registry_inner.txt";
+    const std::string outerFileName = "../testFiles/output/registry_outer.txt";
+    const std::string compositeFileName = "../testFiles/output/registry_composite.txt";
+    std::ofstream(innerFileName) << "REGULAR\n0{s}->1{s}R\n1{s}->0{s}R\n {s}-> {halt}S\n1\nhalt\n>0\n";
+    std::ofstream(outerFileName) << "REGULAR\nUSE registry_inner.txt\n>0\n";
+    std::ofstream(compositeFileName) << "COMPOSITION\nUSE registry_outer.txt\nSECOND MACHINE STATES\n"
+                                     << "USE ../input/library/scan.txt\n>0110\n";
+    {
+        ProgramRegistry::FileRecorder recorder;
+        registry.load(outerFileName);
+        REQUIRE(recorder.getFiles().size() == 2);
+        REQUIRE(ProgramRegistry::isCurrent(recorder.getFiles()));
+    }
+    auto nested = factory.getMachine(compositeFileName);
+    nested->advance();
+    REQUIRE(nested->getOutput() == ">1001 ");
+    const std::uint64_t loads = registry.getStats().fileLoads;
+    factory.getMachine(compositeFileName);
+    REQUIRE(registry.getStats().fileLoads == loads);
+
+    std::ofstream(innerFileName) << "REGULAR\n0{s}->0{s}R\n1{s}->1{s}R\n {s}-> {halt}S\n1\nhalt\n>0\n ";
+    auto edited = factory.getMachine(compositeFileName);
+    edited->advance();
+    REQUIRE(edited->getOutput() == ">0110 ");
+    REQUIRE(registry.getStats().fileLoads == loads + 2);
+    std::filesystem::remove(innerFileName);
+    REQUIRE_THROWS_AS(factory.getMachine(compositeFileName), std::runtime_error);
+    std::filesystem::remove(outerFileName);
+    std::filesystem::remove(compositeFileName);
+    registry.clear();
+}
+
+TEST_CASE("Testing Sub-machine Calls") {
+    TuringMachineFactory factory;
+    auto machine = factory.getMachine("../testFiles/input/submachine.txt");
+    machine->run("../testFiles/output/submachine_output.txt");
+    REQUIRE(readFirstLine("../testFiles/output/submachine_output.txt") == ">10011");
+    // The call, 10 steps of invert, back, the call, 5 steps of seek, end.
+    REQUIRE(machine->getStepCount() == 1 + 10 + 1 + 1 + 5 + 1);
+
+    // Runs can stop and be cloned inside a call.
+    auto& regular = dynamic_cast<RegularTuringMachine&>(*machine);
+    regular.setInput(">01");
+    REQUIRE(regular.advance(3) == TuringMachine::Status::Running);
+    REQUIRE(regular.getExecution().getCallDepth() == 1);
+    REQUIRE(regular.getStateName() == "flip");
+    auto copy = regular.clone();
+    REQUIRE(regular.advance() == TuringMachine::Status::Halted);
+    REQUIRE(regular.getExecution().getCallDepth() == 0);
+    REQUIRE(regular.getOutput() == ">101");
+    REQUIRE(copy->advance() == TuringMachine::Status::Halted);
+    REQUIRE(copy->getOutput() == ">101");
+    REQUIRE(regular.getProgram()->decompile().transitions.at({'0', "start"}).call == "invert");
+    REQUIRE_THROWS_AS(regular.getProgram()->save("../testFiles/output/submachine.tmb"), std::invalid_argument);
+    REQUIRE_THROWS_AS(MachineFuser::fuse(regular), std::invalid_argument);
+
+    // Sub-machines calling each other share one program per callee.
+    std::istringstream nested("0{s}->@twice{t}\n0{t}->@flip{u}\n1\nu\n>0\nSUBMACHINE twice\n0{a}->@flip{b}\n"
+                              "1{b}->@flip{c}\n1\nc\nSUBMACHINE flip\n0{f}->1{g}S\n1{f}->0{g}S\n1\ng\n");
+    RegularTuringMachine caller;
+    caller.init(nested);
+    REQUIRE(caller.advance() == TuringMachine::Status::Halted);
+    REQUIRE(caller.getOutput() == ">1");
+    REQUIRE(caller.getStepCount() == 3 + 2 + 2);
+    auto subMachines = caller.getProgram()->decompile().subMachines;
+    REQUIRE(subMachines.size() == 2);
+    REQUIRE(subMachines.at("twice")->decompile().subMachines.at("flip") == subMachines.at("flip"));
+
+    std::istringstream recursive("0{s}->@loop{t}\n1\nt\n>0\nSUBMACHINE loop\n0{a}->@loop{b}\n1\nb\n");
+    REQUIRE_THROWS_AS(RegularTuringMachine().init(recursive), std::runtime_error);
+    std::istringstream unknown("0{s}->@missing{t}\n1\nt\n>0\n");
+    REQUIRE_THROWS_AS(RegularTuringMachine().init(unknown), std::runtime_error);
+
+    // Moves of sub-machines count towards the head travel, except left moves on the first cell.
+    std::istringstream bumping("0{s}->@back{t}\n1\nt\n>0\nSUBMACHINE back\n0{a}->0{a}L\n>{a}->>{b}L\n"
+                               ">{b}->>{c}S\n1\nc\n");
+    RegularTuringMachine bumper;
+    bumper.init(bumping);
+    bumper.enableStats();
+    REQUIRE(bumper.advance() == TuringMachine::Status::Halted);
+    REQUIRE(bumper.getStepCount() == 4);
+    REQUIRE(bumper.getStats()->headTravel == 1);
+    REQUIRE(bumper.getStats()->minHeadOffset == -1);
+
+    // Lines read ahead are kept by the parser, so streams that cannot put back are read too.
+    UnbufferedInput unbuffered(nested.str());
+    std::istream unbufferedStream(&unbuffered);
+    RegularTuringMachine unbufferedCaller;
+    unbufferedCaller.init(unbufferedStream);
+    REQUIRE(unbufferedCaller.advance() == TuringMachine::Status::Halted);
+    REQUIRE(unbufferedCaller.getOutput() == ">1");
+    REQUIRE(unbufferedCaller.getProgram()->decompile().subMachines.size() == 2);
+}
+
+TEST_CASE("Testing Machine Graph") {
+    TuringMachineFactory factory;
+    auto graph = factory.getMachine("../testFiles/input/graph.txt");
+    auto& nodes = dynamic_cast<GraphTuringMachine&>(*graph);
+    REQUIRE(nodes.getNodeCount() == 3);
+
+    // flip, rewind, flip again while a 1 leads, rewind, append: the run of pipeline.txt.
+    graph->run("../testFiles/output/graph_output.txt");
+    REQUIRE(readFirstLine("../testFiles/output/graph_output.txt") == ">01101");
+    REQUIRE(nodes.getNodeName() == "append");
+    REQUIRE(graph->getStepCount() == 5 + 5 + 5 + 5 + 5);
+    REQUIRE(graph->advance() == TuringMachine::Status::Halted);
+    REQUIRE(graph->getStepCount() == 25);
+
+    // A leading 0 after the first flip goes straight to append.
+    graph->setInput(">1001");
+    REQUIRE(graph->advance(7) == TuringMachine::Status::Running);
+    auto copy = graph->clone();
+    REQUIRE(graph->advance() == TuringMachine::Status::Halted);
+    REQUIRE(graph->getOutput() == ">01101");
+    REQUIRE(graph->getStepCount() == 15);
+    REQUIRE(copy->advance() == TuringMachine::Status::Halted);
+    REQUIRE(copy->getOutput() == ">01101");
+
+    // The guarded edges fuse into dispatch states without extra steps.
+    graph->setInput(">0110");
+    RegularTuringMachine fused(MachineFuser::fuse(*graph));
+    REQUIRE(fused.advance() == TuringMachine::Status::Halted);
+    REQUIRE(graph->advance() == TuringMachine::Status::Halted);
+    REQUIRE(fused.getOutput() == graph->getOutput());
+    REQUIRE(fused.getStepCount() == graph->getStepCount());
+
+    // A node without a transition ends the graph.
+    std::istringstream stuckInput("NODE a\n0{s}->1{t}R\n1\nt\nNODE b\n0{q}->0{q}R\n1\nhalt\nEDGES\na->b\n>01\n");
+    GraphTuringMachine stuck(stuckInput);
+    REQUIRE(stuck.advance() == TuringMachine::Status::NoTransition);
+    REQUIRE(stuck.getNodeName() == "b");
+
+    // Nodes halting at once on an unchanged tape would hand over forever.
+    std::istringstream cycleInput("NODE a\n0{s}->0{s}R\n1\ns\nNODE b\n0{q}->0{q}R\n1\nq\nEDGES\na->b\nb->a\n>0\n");
+    GraphTuringMachine cycle(cycleInput);
+    REQUIRE_THROWS_AS(cycle.advance(), std::runtime_error);
+
+    std::istringstream unknownNode("NODE a\n0{s}->0{s}R\n1\ns\nEDGES\na->b\n>0\n");
+    REQUIRE_THROWS_AS(GraphTuringMachine{unknownNode}, std::runtime_error);
+    std::istringstream runningGuard("NODE a\n0{s}->0{t}R\n1\nt\nEDGES\na{s}->a\n>0\n");
+    REQUIRE_THROWS_AS(GraphTuringMachine{runningGuard}, std::runtime_error);
+}
+
+TEST_CASE("Testing Machine Fusion") {
+    TuringMachineFactory factory;
+
+    // Stages that hand over unconditionally take the same steps in one graph.
+    for (const char* fileName : {"../testFiles/input/composition.txt", "../testFiles/input/conditional.txt",
+                                 "../testFiles/input/pipeline.txt"}) {
+        auto composite = factory.getMachine(fileName);
+        RegularTuringMachine fused(MachineFuser::fuse(*composite));
+        REQUIRE(composite->advance() == TuringMachine::Status::Halted);
+        REQUIRE(fused.advance() == TuringMachine::Status::Halted);
+        REQUIRE(fused.getOutput() == composite->getOutput());
+        REQUIRE(fused.getHeadPosition() == composite->getHeadPosition());
+        REQUIRE(fused.getStepCount() == composite->getStepCount());
+    }
+
+    // The loop becomes a back edge; the discarded post-loop runs are left out.
+    auto loop = factory.getMachine("../testFiles/input/loop.txt");
+    RegularTuringMachine fusedLoop(MachineFuser::fuse(*loop));
+    REQUIRE(loop->advance() == TuringMachine::Status::Halted);
+    REQUIRE(fusedLoop.advance() == TuringMachine::Status::Halted);
+    REQUIRE(fusedLoop.getOutput() == loop->getOutput());
+    REQUIRE(fusedLoop.getStepCount() == 8);
+    REQUIRE(fusedLoop.getStepCount() == loop->getStepCount());
+    fusedLoop.run("../testFiles/output/fused_loop_output.txt");
+    REQUIRE(readFirstLine("../testFiles/output/fused_loop_output.txt") == loop->getOutput());
+
+    // The fused program runs other inputs like the composite does.
+    auto pipeline = factory.getMachine("../testFiles/input/pipeline.txt");
+    RegularTuringMachine fusedPipeline(MachineFuser::fuse(*pipeline));
+    pipeline->setInput(">1001");
+    fusedPipeline.setInput(">1001");
+    pipeline->advance();
+    fusedPipeline.advance();
+    REQUIRE(fusedPipeline.getOutput() == pipeline->getOutput());
+
+    // A stage that halts at once on the loop symbol would spin without taking a step.
+    std::istringstream spinning("0{s}->0{s}R\n1\ns\nPOST LOOP MACHINE STATES\n0{q}->0{halt}S\n1\nhalt\n>0\n0\n");
+    IterationLoopTuringMachine spin(spinning);
+    REQUIRE_THROWS_AS(MachineFuser::fuse(spin), std::invalid_argument);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("Testing Machine Server") {
+    MachineServer server("../testFiles/output/server.sock", 4);
+    server.start();
+    REQUIRE_THROWS_AS(MachineServer("../testFiles/output/server.sock").start(), std::runtime_error);
+
+    // Load generator: pipelined requests from several connections at once.
+    const std::size_t connections = 4;
+    const std::size_t requestsPerConnection = 50;
+    std::vector<std::vector<std::uint64_t>> roundTrips(connections);
+    std::atomic<std::size_t> failures{0};
+    std::vector<std::thread> clients;
+    for (std::size_t c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c]() {
+            MachineClient client("../testFiles/output/server.sock");
+            MachineRequest request;
+            request.machineFile = "../testFiles/input/regular.txt";
+            for (std::size_t i = 0; i < requestsPerConnection; i += 5) {
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t j = i; j < i + 5; ++j) {
+                    request.id = j;
+                    request.tape = j % 2 == 0 ? ">0110" : ">1111";
+                    client.send(request);
+                }
+                for (std::size_t j = 0; j < 5; ++j) {
+                    MachineResponse response = client.receive();
+                    if (!response.ok || response.status != TuringMachine::Status::Halted
+                        || response.tape != (response.id % 2 == 0 ? ">1001 " : ">0000 ")) {
+                        ++failures;
+                    }
+                }
+                roundTrips[c].push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count()));
+            }
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    REQUIRE(failures == 0);
+    REQUIRE(server.getRequestCount() == connections * requestsPerConnection);
+    REQUIRE(server.getCacheSize() == 1);
+
+    std::vector<std::uint64_t> latencies;
+    for (const auto& trips : roundTrips) {
+        latencies.insert(latencies.end(), trips.begin(), trips.end());
+    }
+    LatencySummary latency = LatencySummary::of(latencies);
+    REQUIRE(latency.count == connections * requestsPerConnection / 5);
+    REQUIRE(latency.p50 <= latency.p99);
+    REQUIRE(latency.p99 <= latency.max);
+
+    MachineClient client("../testFiles/output/server.sock");
+    REQUIRE(client.ping());
+    MachineRequest request;
+    request.id = 7;
+    request.machineFile = "../testFiles/input/loop.txt";
+    request.maxSteps = 3;
+    MachineResponse limited = client.run(request);
+    REQUIRE(limited.ok);
+    REQUIRE(limited.status == TuringMachine::Status::Running);
+    REQUIRE(limited.steps == 3);
+
+    request.machineFile = "../testFiles/nonexistent/loop.txt";
+    MachineResponse missing = client.run(request);
+    REQUIRE(!missing.ok);
+    REQUIRE(missing.id == 7);
+    REQUIRE(missing.tape == "Unable to open file: ../testFiles/nonexistent/loop.txt");
+
+    // A machine that never stops is cancelled by stop() instead of holding it up.
+    {
+        std::ofstream forever("../testFiles/output/server_forever.txt");
+        forever << "REGULAR\n0{s}->0{s}S\n1\nhalt\n>0\n";
+    }
+    request.machineFile = "../testFiles/output/server_forever.txt";
+    request.maxSteps = 0;
+    client.send(request);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    server.stop();
+    REQUIRE(server.getRequestCount() == connections * requestsPerConnection + 3);
+    try {
+        MachineResponse cancelled = client.receive();
+        REQUIRE(!cancelled.ok);
+        REQUIRE(cancelled.tape == "Request cancelled: the server is stopping");
+    } catch (const std::runtime_error&) {
+        // The connection may close before the cancellation is written back.
+    }
+    REQUIRE_THROWS_AS(client.receive(), std::runtime_error);
+    std::filesystem::remove("../testFiles/output/server_forever.txt");
+    REQUIRE_THROWS_AS(MachineClient("../testFiles/output/server.sock"), std::runtime_error);
+
+    std::vector<std::uint64_t> ranks;
+    for (std::uint64_t i = 100; i >= 1; --i) {
+        ranks.push_back(i);
+    }
+    LatencySummary summary = LatencySummary::of(ranks);
+    REQUIRE(summary.p50 == 50);
+    REQUIRE(summary.p90 == 90);
+    REQUIRE(summary.p99 == 99);
+    REQUIRE(summary.max == 100);
+}
+#endif
+
 TEST_CASE("Testing Turing Machine with Wrong File Path") {
     TuringMachineFactory* factory = new TuringMachineFactory();
     CHECK_THROWS_WITH_AS(factory->getMachine("../testFiles/nonexistent/loop.txt"),
@@ -116,3 +1459,161 @@ TEST_CASE("Testing Tape Visualization with Graphviz") {
     CHECK(outputFile.good());
     outputFile.close();
 }
+
+TEST_CASE("Testing Windowed Graphviz Rendering") {
+    const std::string tapeFilePath = "../testFiles/tape/long_tape.txt";
+    const std::string outputFilePath = "../testFiles/tape/long_tape_graphviz.dot";
+    const std::string contents = ">" + std::string(1000, '1') + "00000" + std::string(1000, ' ');
+    {
+        std::ofstream tapeFile(tapeFilePath);
+        tapeFile << contents << "\nnot part of the tape";
+    }
+    auto readAll = [](const std::string& fileName) {
+        std::ifstream file(fileName);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+
+    // Without options every cell is a node, as before.
+    TapeVisualizer(tapeFilePath).generateGraphvizFile(outputFilePath);
+    std::string whole = readAll(outputFilePath);
+    REQUIRE(whole.find("node2005 [label=\" \"];") != std::string::npos);
+    REQUIRE(whole.find("node2006") == std::string::npos);
+    REQUIRE(whole.find("not part") == std::string::npos);
+
+    TapeVisualizer::Options options;
+    options.head = 1003;
+    options.window = 10;
+    options.minRun = 3;
+    Tape tape(contents, 1003);
+    std::ostringstream fromTape;
+    TapeVisualizer::writeGraphviz(tape, fromTape, options);
+    TapeVisualizer(tapeFilePath).generateGraphvizFile(outputFilePath, options);
+    REQUIRE(readAll(outputFilePath) == fromTape.str());
+    REQUIRE(fromTape.str() == "digraph G {\n"
+                              "    rankdir=LR;\n"
+                              "    node [shape=record];\n"
+                              "    edge [color=white, arrowsize=0.01];\n"
+                              "    node0 [label=\"\u2026 993 cells\", shape=plaintext];\n"
+                              "    node1 [label=\"1 \u00d78\"];\n"
+                              "    node0 -> node1;\n"
+                              "    node2 [label=\"0\"];\n"
+                              "    node1 -> node2;\n"
+                              "    node3 [label=\"0\"];\n"
+                              "    node2 -> node3;\n"
+                              "    node4 [label=\"0\", style=filled, fillcolor=lightblue];\n"
+                              "    node3 -> node4;\n"
+                              "    node5 [label=\"0\"];\n"
+                              "    node4 -> node5;\n"
+                              "    node6 [label=\"0\"];\n"
+                              "    node5 -> node6;\n"
+                              "    node7 [label=\"  \u00d78\"];\n"
+                              "    node6 -> node7;\n"
+                              "    node8 [label=\"\u2026 992 cells\", shape=plaintext];\n"
+                              "    node7 -> node8;\n"
+                              "}\n");
+
+    // Whole tape, runs merged: a handful of nodes however long the runs are.
+    options = TapeVisualizer::Options{};
+    options.minRun = 2;
+    std::ostringstream merged;
+    TapeVisualizer::writeGraphviz(Tape(contents + std::string(1000000, '1')), merged, options);
+    REQUIRE(merged.str().find("node4 [label=\"1 \u00d71000000\"];") != std::string::npos);
+    REQUIRE(merged.str().find("node5") == std::string::npos);
+    std::filesystem::remove(tapeFilePath);
+    std::filesystem::remove(outputFilePath);
+}
+
+TEST_CASE("Testing Space-Time Diagrams") {
+    WorkloadGenerator::Parameters parameters;
+    parameters.tapeLength = 4;
+    auto counter = WorkloadGenerator::generate(WorkloadGenerator::Kind::BinaryCounter, parameters);
+    const std::string description = counter.description.substr(counter.description.find('\n') + 1);
+    auto machineFor = [&description]() {
+        std::istringstream in(description);
+        auto machine = std::make_unique<RegularTuringMachine>();
+        machine->init(in);
+        return machine;
+    };
+    auto readAll = [](const std::string& fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+    const std::string imagePath = "../testFiles/output/spacetime.ppm";
+
+    auto reference = machineFor();
+    reference->advance();
+    const std::uint64_t steps = reference->getStepCount();
+
+    // One row per step, one column per cell; the first row shows the head on its starting cell.
+    SpaceTimeDiagram::Options options;
+    options.columns = 16;
+    auto machine = machineFor();
+    const std::size_t start = machine->getHeadPosition();
+    REQUIRE(SpaceTimeDiagram::record(*machine, imagePath, options) == TuringMachine::Status::Halted);
+    REQUIRE(machine->getOutput() == reference->getOutput());
+    REQUIRE_FALSE(machine->getStats().has_value());
+    std::string image = readAll(imagePath);
+    std::string header = "P6\n16 " + std::to_string(steps);
+    REQUIRE(image.compare(0, header.size(), header) == 0);
+    const std::size_t pixels = image.find("\n255\n") + 5;
+    REQUIRE(image.size() - pixels == 16 * steps * 3);
+    REQUIRE(image.substr(pixels + 3 * start, 3) == "\xd6\x27\x28");
+    REQUIRE(image.substr(pixels + 3 * 15, 3) == "\xff\xff\xff");
+
+    // Merged steps and cells shrink the image, and a step limit ends it early.
+    options.stepsPerRow = 4;
+    options.cellsPerColumn = 2;
+    options.columns = 4;
+    machine = machineFor();
+    REQUIRE(SpaceTimeDiagram::record(*machine, imagePath, options, 10) == TuringMachine::Status::Running);
+    REQUIRE(machine->getStepCount() == 10);
+    image = readAll(imagePath);
+    REQUIRE(image.compare(0, 6, "P6\n4 3") == 0);
+    REQUIRE(image.size() - (image.find("\n255\n") + 5) == 4 * 3 * 3);
+
+    // Statistics the caller enabled keep counting through the recording.
+    machine = machineFor();
+    machine->enableStats();
+    REQUIRE(SpaceTimeDiagram::record(*machine, imagePath, options, 10) == TuringMachine::Status::Running);
+    REQUIRE(machine->getStats().has_value());
+    REQUIRE(machine->getStats()->steps == 10);
+
+    // Traces only hold the head, so the rows are blank apart from it.
+    std::istringstream trace("{\"traceEvents\":[\n"
+                             "{\"name\":\"regular\",\"cat\":\"turing_machine\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":1,"
+                             "\"args\":{\"state\":0,\"head\":1}},\n"
+                             "{\"name\":\"regular\",\"cat\":\"turing_machine\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":2,"
+                             "\"args\":{\"state\":0,\"head\":3}},\n"
+                             "{\"name\":\"regular\",\"cat\":\"turing_machine\",\"ph\":\"C\",\"pid\":1,\"tid\":2,\"ts\":2,"
+                             "\"args\":{\"state\":0,\"head\":0}},\n"
+                             "{\"name\":\"regular\",\"cat\":\"turing_machine\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":3,"
+                             "\"args\":{\"state\":1,\"head\":2}}\n"
+                             "]}\n");
+    options = SpaceTimeDiagram::Options();
+    options.columns = 4;
+    options.stepsPerRow = 2;
+    REQUIRE(SpaceTimeDiagram::fromTrace(trace, imagePath, options) == 2);
+    image = readAll(imagePath);
+    REQUIRE(image.substr(image.find("\n255\n") + 5) == std::string("\xff\xff\xff\xd6\x27\x28\xd6\x27\x28\xd6\x27\x28"
+                                                                   "\xff\xff\xff\xff\xff\xff\xd6\x27\x28\xd6\x27\x28", 24));
+
+    if (SpaceTimeDiagram::isAvailable(SpaceTimeDiagram::Format::Png)) {
+        const std::string pngPath = "../testFiles/output/spacetime.png";
+        options = SpaceTimeDiagram::Options();
+        options.columns = 16;
+        options.format = SpaceTimeDiagram::formatOf(pngPath);
+        REQUIRE(options.format == SpaceTimeDiagram::Format::Png);
+        machine = machineFor();
+        SpaceTimeDiagram::record(*machine, pngPath, options);
+        image = readAll(pngPath);
+        REQUIRE(image.compare(0, 8, "\x89PNG\r\n\x1a\n") == 0);
+        REQUIRE(image.substr(16, 8) == std::string("\0\0\0\x10", 4) + std::string(1, '\0') + std::string(1, '\0')
+                                       + std::string(1, static_cast<char>(steps >> 8)) + std::string(1, static_cast<char>(steps)));
+        REQUIRE(image.compare(image.size() - 8, 4, "IEND") == 0);
+        std::filesystem::remove(pngPath);
+    } else {
+        REQUIRE_THROWS_AS(SpaceTimeDiagram("../testFiles/output/spacetime.png", {16, 1, 1, SpaceTimeDiagram::Format::Png}),
+                          std::invalid_argument);
+    }
+    std::filesystem::remove(imagePath);
+}
@@ -0,0 +1,241 @@
+#include <benchmark/benchmark.h>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include "../turingmachine/compiled/CompiledMachine.h"
+#include "../turingmachine/compiled/MachineFuser.h"
+#include "../turingmachine/machines/RegularTuringMachine.h"
+#include "../turingmachine/machines/RegularExecution.h"
+#include "../turingmachine/machines/CompositionTuringMachine.h"
+#include "../turingmachine/multitape/MultitapeTuringMachine.h"
+
+namespace {
+
+const char* const NULL_OUTPUT = "/dev/null";
+
+/// Silences the "Tape successfully written" messages for the lifetime of the scope.
+class MutedStdout {
+public:
+    MutedStdout() : previous(std::cout.rdbuf(nullptr)) {}
+    ~MutedStdout() {
+        std::cout.rdbuf(previous);
+        std::cout.clear();
+    }
+
+private:
+    std::streambuf* previous;
+};
+
+std::string symbolName(int index) {
+    static const std::string symbols = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    return std::string(1, symbols[static_cast<std::size_t>(index) % symbols.size()]);
+}
+
+/**
+ * A machine with the given number of states and symbols that sweeps right over a random tape
+ * and halts on the first blank. Every (state, symbol) pair has a transition, and the next
+ * state depends on the symbol read, so the sweep touches the whole table.
+ */
+std::string sweepingMachine(int stateCount, int symbolCount, std::size_t tapeLength) {
+    std::ostringstream text;
+    for (int state = 0; state < stateCount; ++state) {
+        for (int symbol = 0; symbol < symbolCount; ++symbol) {
+            text << symbolName(symbol) << "{q" << state << "}->" << symbolName((symbol + 1) % symbolCount)
+                 << "{q" << (state * 31 + symbol + 1) % stateCount << "}R\n";
+        }
+        text << " {q" << state << "}-> {halt}S\n";
+    }
+    text << "1\nhalt\n>";
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> symbol(0, symbolCount - 1);
+    for (std::size_t i = 0; i < tapeLength; ++i) {
+        text << symbolName(symbol(random));
+    }
+    text << "\n";
+    return text.str();
+}
+
+std::unique_ptr<RegularTuringMachine> parseRegular(const std::string& text) {
+    std::istringstream input(text);
+    auto machine = std::make_unique<RegularTuringMachine>();
+    machine->init(input);
+    return machine;
+}
+
+class RegularMachineFixture : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State& state) override {
+        machine = parseRegular(sweepingMachine(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)), TAPE_LENGTH));
+    }
+
+    void TearDown(const benchmark::State&) override {
+        machine.reset();
+    }
+
+protected:
+    static constexpr std::size_t TAPE_LENGTH = 1 << 16;
+    std::unique_ptr<RegularTuringMachine> machine;
+};
+
+}
+
+BENCHMARK_DEFINE_F(RegularMachineFixture, Run)(benchmark::State& state) {
+    std::uint64_t steps = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        RegularExecution execution = machine->createExecution();
+        state.ResumeTiming();
+        execution.run();
+        steps += execution.getStepCount();
+    }
+    state.counters["steps_per_second"] = benchmark::Counter(static_cast<double>(steps), benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(static_cast<std::int64_t>(steps));
+}
+BENCHMARK_REGISTER_F(RegularMachineFixture, Run)
+        ->ArgNames({"states", "symbols"})
+        ->ArgsProduct({{4, 64, 1024}, {2, 16, 60}})
+        ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_DEFINE_F(RegularMachineFixture, RunWithStats)(benchmark::State& state) {
+    std::uint64_t steps = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        RegularExecution execution = machine->createExecution();
+        execution.enableStats();
+        state.ResumeTiming();
+        execution.run();
+        steps += execution.getStepCount();
+    }
+    state.counters["steps_per_second"] = benchmark::Counter(static_cast<double>(steps), benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(static_cast<std::int64_t>(steps));
+}
+BENCHMARK_REGISTER_F(RegularMachineFixture, RunWithStats)
+        ->ArgNames({"states", "symbols"})
+        ->ArgsProduct({{4, 64, 1024}, {2, 16, 60}})
+        ->Unit(benchmark::kMicrosecond);
+
+static void BM_RegularMachineParse(benchmark::State& state) {
+    const int stateCount = static_cast<int>(state.range(0));
+    const std::string text = sweepingMachine(stateCount, 16, 64);
+    const std::int64_t transitions = static_cast<std::int64_t>(stateCount) * 17;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parseRegular(text));
+    }
+    state.SetItemsProcessed(state.iterations() * transitions);
+    state.counters["transitions"] = static_cast<double>(transitions);
+}
+BENCHMARK(BM_RegularMachineParse)->ArgName("states")->Arg(16)->Arg(256)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+static void BM_SetTape(benchmark::State& state) {
+    RegularTuringMachine machine;
+    const std::string tape(static_cast<std::size_t>(state.range(0)), '0');
+    for (auto _ : state) {
+        machine.setTape(tape);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetTape)->ArgName("cells")->Range(1 << 10, 1 << 22);
+
+static void BM_GetTape(benchmark::State& state) {
+    RegularTuringMachine machine;
+    machine.setTape(std::string(static_cast<std::size_t>(state.range(0)), '0'));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(machine.getTape());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetTape)->ArgName("cells")->Range(1 << 10, 1 << 22);
+
+static void BM_OutputTape(benchmark::State& state) {
+    // A machine that halts immediately, so run() measures only writing the tape.
+    auto machine = parseRegular("0{s}->0{halt}S\n1\nhalt\n>" + std::string(static_cast<std::size_t>(state.range(0)), '0') + "\n");
+    MutedStdout muted;
+    for (auto _ : state) {
+        machine->run(NULL_OUTPUT);
+    }
+    state.SetBytesProcessed(state.iterations() * (state.range(0) + 1));
+}
+BENCHMARK(BM_OutputTape)->ArgName("cells")->Range(1 << 10, 1 << 22);
+
+static void BM_MultiTapeRun(benchmark::State& state) {
+    const int stateCount = static_cast<int>(state.range(0));
+    const int symbolCount = static_cast<int>(state.range(1));
+    const std::size_t tapeLength = 1 << 14;
+
+    // Two tapes; the first head sweeps over random symbols while the second follows it.
+    std::ostringstream text;
+    text << ">b{q0}->>b{q0}RS\n";
+    for (int current = 0; current < stateCount; ++current) {
+        for (int symbol = 0; symbol < symbolCount; ++symbol) {
+            text << symbolName(symbol) << "b{q" << current << "}->" << symbolName(symbol) << "c{q"
+                 << (current + symbol + 1) % stateCount << "}RR\n";
+        }
+        text << "#b{q" << current << "}->#b{halt}SS\n";
+    }
+    text << "1\nhalt\n>";
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> symbol(0, symbolCount - 1);
+    for (std::size_t i = 0; i < tapeLength; ++i) {
+        text << symbolName(symbol(random));
+    }
+    text << "\n>" << std::string(tapeLength + 1, 'b') << "\n";
+
+    std::istringstream input(text.str());
+    MultiTapeTuringMachine prototype;
+    prototype.init(input);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto machine = prototype.clone();
+        state.ResumeTiming();
+        machine->run(NULL_OUTPUT);
+    }
+    state.counters["steps_per_second"] = benchmark::Counter(static_cast<double>(state.iterations() * (tapeLength + 2)), benchmark::Counter::kIsRate);
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * (tapeLength + 2)));
+}
+BENCHMARK(BM_MultiTapeRun)
+        ->ArgNames({"states", "symbols"})
+        ->ArgsProduct({{4, 64}, {2, 16}})
+        ->Unit(benchmark::kMicrosecond);
+
+static void BM_CompositionHandOff(benchmark::State& state) {
+    // Both stages halt immediately, so the cost is the tape hand-off between them.
+    const std::string tape = ">" + std::string(static_cast<std::size_t>(state.range(0)), '0');
+    std::istringstream input("0{s}->0{halt}S\n1\nhalt\nSECOND MACHINE STATES\n0{q}->0{halt}S\n1\nhalt\n" + tape + "\n");
+    CompositionTuringMachine prototype;
+    prototype.init(input);
+
+    MutedStdout muted;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto machine = prototype.clone();
+        state.ResumeTiming();
+        machine->run(NULL_OUTPUT);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(tape.size()));
+}
+BENCHMARK(BM_CompositionHandOff)->ArgName("cells")->Range(1 << 10, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+static void BM_FusedCompositionHandOff(benchmark::State& state) {
+    // The composition of BM_CompositionHandOff as one graph: no tape is handed over.
+    const std::string tape = ">" + std::string(static_cast<std::size_t>(state.range(0)), '0');
+    std::istringstream input("0{s}->0{halt}S\n1\nhalt\nSECOND MACHINE STATES\n0{q}->0{halt}S\n1\nhalt\n" + tape + "\n");
+    CompositionTuringMachine composition;
+    composition.init(input);
+    RegularTuringMachine prototype(MachineFuser::fuse(composition));
+
+    MutedStdout muted;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto machine = prototype.clone();
+        state.ResumeTiming();
+        machine->run(NULL_OUTPUT);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(tape.size()));
+}
+BENCHMARK(BM_FusedCompositionHandOff)->ArgName("cells")->Range(1 << 10, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
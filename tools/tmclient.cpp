@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../turingmachine/server/MachineClient.h"
+#include "../turingmachine/stats/LatencySummary.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <socket> <machine.txt> [options]\n"
+              << "Runs the machine on a tmserver and writes the final tapes one per line.\n"
+              << "Options:\n"
+              << "  --input FILE        read input tapes from FILE, one per line ('-' for stdin); may be repeated\n"
+              << "  -o, --output FILE   write the final tapes to FILE ('-' for stdout, the default)\n"
+              << "  --max-steps N       stop every run after N transitions\n"
+              << "Load generation (reports throughput and round-trip latency percentiles):\n"
+              << "  --load N            send N requests in total, cycling through the inputs\n"
+              << "  --connections N     spread them over N connections (default 1)\n"
+              << "  --pipeline N        keep N requests outstanding on each connection (default 1)" << std::endl;
+}
+
+void readInputs(std::istream& in, std::vector<std::optional<std::string>>& inputs) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            inputs.emplace_back(line);
+        }
+    }
+}
+
+struct LoadResult {
+    std::vector<std::uint64_t> roundTrips; ///< Nanoseconds from send to response.
+    std::uint64_t steps = 0;
+    std::uint64_t errors = 0;
+};
+
+/// Sends `count` requests on one connection, keeping `depth` of them in flight.
+void generateLoad(const std::string& socketPath, MachineRequest request, const std::vector<std::optional<std::string>>& inputs,
+                  std::size_t first, std::size_t count, std::size_t depth, LoadResult& result) {
+    using Clock = std::chrono::steady_clock;
+    MachineClient client(socketPath);
+    std::map<std::uint64_t, Clock::time_point> sent;
+    std::size_t next = 0;
+    std::size_t received = 0;
+    while (received < count) {
+        while (next < count && sent.size() < depth) {
+            request.id = first + next;
+            request.tape = inputs[(first + next) % inputs.size()];
+            sent.emplace(request.id, Clock::now());
+            client.send(request);
+            ++next;
+        }
+
+        MachineResponse response = client.receive();
+        auto it = sent.find(response.id);
+        if (it == sent.end()) {
+            throw std::runtime_error("Unexpected response id: " + std::to_string(response.id));
+        }
+        result.roundTrips.push_back(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - it->second).count()));
+        sent.erase(it);
+        ++received;
+        if (response.ok) {
+            result.steps += response.steps;
+        } else if (result.errors++ == 0) {
+            std::cerr << "Request " << response.id << " failed: " << response.tape << std::endl;
+        }
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::string socketPath = argv[1];
+    MachineRequest request;
+    request.machineFile = std::filesystem::absolute(argv[2]).string(); // The server has its own working directory.
+    std::vector<std::string> inputFileNames;
+    std::string outputFileName = "-";
+    std::size_t load = 0;
+    std::size_t connections = 1;
+    std::size_t pipeline = 1;
+    try {
+        for (int i = 3; i < argc; ++i) {
+            std::string option = argv[i];
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 2;
+            }
+            std::string value = argv[++i];
+            if (option == "--input") {
+                inputFileNames.push_back(value);
+            } else if (option == "-o" || option == "--output") {
+                outputFileName = value;
+            } else if (option == "--max-steps") {
+                request.maxSteps = std::stoull(value);
+            } else if (option == "--load") {
+                load = std::stoull(value);
+            } else if (option == "--connections") {
+                connections = std::max<std::size_t>(1, std::stoull(value));
+            } else if (option == "--pipeline") {
+                pipeline = std::max<std::size_t>(1, std::stoull(value));
+            } else {
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+    } catch (const std::logic_error&) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try {
+        // Without --input the machine runs on the tape of its description.
+        std::vector<std::optional<std::string>> inputs;
+        for (const auto& fileName : inputFileNames) {
+            if (fileName == "-") {
+                readInputs(std::cin, inputs);
+                continue;
+            }
+            std::ifstream file(fileName);
+            if (!file.is_open()) {
+                throw std::runtime_error("Unable to open file: " + fileName);
+            }
+            readInputs(file, inputs);
+        }
+        if (inputFileNames.empty()) {
+            inputs.emplace_back();
+        }
+
+        if (load == 0) {
+            // Pipeline every input on one connection and print the results in input order.
+            MachineClient client(socketPath);
+            for (std::size_t i = 0; i < inputs.size(); ++i) {
+                request.id = i;
+                request.tape = inputs[i];
+                client.send(request);
+            }
+            std::vector<MachineResponse> responses(inputs.size());
+            for (std::size_t i = 0; i < inputs.size(); ++i) {
+                MachineResponse response = client.receive();
+                responses.at(response.id) = std::move(response);
+            }
+
+            std::ofstream outputFile;
+            if (outputFileName != "-") {
+                outputFile.open(outputFileName);
+                if (!outputFile.is_open()) {
+                    std::cerr << "Unable to open or create file: " << outputFileName << std::endl;
+                    return 1;
+                }
+            }
+            std::ostream& out = outputFileName == "-" ? std::cout : outputFile;
+            int exitCode = 0;
+            for (const auto& response : responses) {
+                if (!response.ok) {
+                    std::cerr << "Input " << response.id + 1 << ": " << response.tape << std::endl;
+                    exitCode = 1;
+                    out << '\n';
+                    continue;
+                }
+                if (response.status != TuringMachine::Status::Halted) {
+                    std::cerr << "Input " << response.id + 1 << ": " << MachineProtocol::statusName(response.status) << std::endl;
+                    exitCode = exitCode == 0 ? 3 : exitCode;
+                }
+                out << response.tape << '\n';
+            }
+            return exitCode;
+        }
+
+        connections = std::min(connections, load);
+        std::vector<LoadResult> results(connections);
+        std::vector<std::thread> workers;
+        std::atomic<bool> failed{false};
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < connections; ++i) {
+            std::size_t first = load * i / connections;
+            std::size_t count = load * (i + 1) / connections - first;
+            workers.emplace_back([&, i, first, count]() {
+                try {
+                    generateLoad(socketPath, request, inputs, first, count, pipeline, results[i]);
+                } catch (const std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                    failed = true;
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (failed) {
+            return 1;
+        }
+
+        std::vector<std::uint64_t> roundTrips;
+        std::uint64_t steps = 0;
+        std::uint64_t errors = 0;
+        for (auto& result : results) {
+            roundTrips.insert(roundTrips.end(), result.roundTrips.begin(), result.roundTrips.end());
+            steps += result.steps;
+            errors += result.errors;
+        }
+        LatencySummary latency = LatencySummary::of(roundTrips);
+        std::cout << std::fixed << std::setprecision(1)
+                  << "requests:    " << latency.count << " on " << connections << " connections, "
+                  << pipeline << " in flight each (" << errors << " failed)\n"
+                  << "wall time:   " << seconds * 1e3 << " ms\n"
+                  << "throughput:  " << static_cast<double>(latency.count) / seconds << " requests/s, "
+                  << static_cast<double>(steps) / seconds << " steps/s\n"
+                  << "latency us:  ";
+        latency.writeMicroseconds(std::cout);
+        std::cout << std::endl;
+        return errors == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,20 @@
+#include <iostream>
+#include <exception>
+#include "../turingmachine/compiled/CompiledMachine.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <machine.txt> <machine.tmb>" << std::endl;
+        return 2;
+    }
+
+    try {
+        CompiledMachine::convertTextToBinary(argv[1], argv[2]);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Machine successfully compiled to " << argv[2] << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include "../turingmachine/generator/WorkloadGenerator.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <workload> [options]\n"
+              << "Workloads: regular, composition, loop, conditional, multitape,\n"
+              << "           binary-counter, unary-multiplication, palindrome, busy-beaver\n"
+              << "Options:\n"
+              << "  --states N     working states (busy-beaver: 2 to 5)\n"
+              << "  --alphabet N   distinct data symbols\n"
+              << "  --tape N       data cells on the tape\n"
+              << "  --steps N      target step count\n"
+              << "  --tapes N      tapes of a multitape workload\n"
+              << "  --seed N       seed for the random data\n"
+              << "  -o FILE        write the description to FILE instead of stdout" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    try {
+        WorkloadGenerator::Kind kind = WorkloadGenerator::parseKind(argv[1]);
+        WorkloadGenerator::Parameters parameters;
+        std::string outputFileName;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string option = argv[i];
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 2;
+            }
+            std::string value = argv[++i];
+            if (option == "-o") {
+                outputFileName = value;
+            } else if (option == "--states") {
+                parameters.states = std::stoull(value);
+            } else if (option == "--alphabet") {
+                parameters.alphabetSize = std::stoull(value);
+            } else if (option == "--tape") {
+                parameters.tapeLength = std::stoull(value);
+            } else if (option == "--steps") {
+                parameters.steps = std::stoull(value);
+            } else if (option == "--tapes") {
+                parameters.tapes = std::stoull(value);
+            } else if (option == "--seed") {
+                parameters.seed = static_cast<std::uint32_t>(std::stoul(value));
+            } else {
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+
+        WorkloadGenerator::Workload workload = WorkloadGenerator::generate(kind, parameters);
+        if (outputFileName.empty()) {
+            std::cout << workload.description;
+        } else {
+            WorkloadGenerator::writeFile(outputFileName, workload);
+        }
+        std::cerr << (workload.exact ? "Expected steps: " : "Estimated steps: ") << workload.expectedSteps << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
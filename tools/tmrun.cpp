@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../turingmachine/factory/TuringMachineFactory.h"
+#include "../turingmachine/machines/RegularExecution.h"
+#include "../turingmachine/machines/RegularTuringMachine.h"
+#include "../turingmachine/multitape/MultitapeTuringMachine.h"
+#include "../turingmachine/stats/LatencySummary.h"
+#include "../turingmachine/tape/TapeCodec.h"
+#include "../turingmachine/tapevisualizer/TapeVisualizer.h"
+#include "../turingmachine/tapevisualizer/SpaceTimeDiagram.h"
+#include "../turingmachine/trace/Trace.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <machine.txt> [output.txt] [options]\n"
+              << "Runs the machine on the tape of its description, or on every tape given with --input,\n"
+              << "and writes the final tapes one per line.\n"
+              << "Options:\n"
+              << "  --input FILE      read input tapes from FILE, one per line ('-' for stdin); may be repeated;\n"
+              << "                    multi-tape inputs join their tapes with '#'\n"
+              << "  --tape FILE       run on the first line of FILE, streamed straight onto the tape (REGULAR only)\n"
+              << "  --lazy-tape FILE  like --tape, but map FILE and load blocks of it only as the heads reach them\n"
+              << "                    (REGULAR and MULTITAPE)\n"
+              << "  -o, --output FILE write the final tapes to FILE ('-' for stdout, the default)\n"
+              << "  --compress FORMAT write the final tape as raw, rle or deflate (one run only); --tape and\n"
+              << "                    --lazy-tape read compressed tapes as they are\n"
+              << "  --graphviz FILE   draw the final tape of a single run as a Graphviz graph\n"
+              << "  --window N        draw only N cells on each side of the head\n"
+              << "  --collapse N      draw runs of at least N equal cells as one node\n"
+              << "  --spacetime FILE  draw a single run as a space-time image, PNG if FILE ends in .png, PPM otherwise\n"
+              << "  --columns N       width of the space-time image (default 1024)\n"
+              << "  --cells-per-column N, --steps-per-row N\n"
+              << "                    merge cells and steps into one pixel of the space-time image (default 1)\n"
+              << "  --max-steps N     stop every run after N transitions\n"
+              << "  --threads N       run the inputs on N threads (default 1)\n"
+              << "  --bench N         run every input N times and report steps/sec and latency percentiles\n"
+              << "  --stats FILE      collect execution statistics and write them as JSON to FILE ('-' for stdout)\n"
+              << "  --top N           list only the N hottest transitions in the statistics\n"
+              << "  --trace FILE      write a Chrome trace of parsing, running and output to FILE\n"
+              << "  --sample N        sample the state and head every N steps while tracing (default 65536)\n"
+              << "Exits with 3 if a run hit the step limit or had no transition to take." << std::endl;
+}
+
+void readInputs(std::istream& in, std::vector<std::string>& inputs) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            inputs.push_back(line);
+        }
+    }
+}
+
+/// One execution of the machine on one input.
+struct Run {
+    std::size_t input;
+    std::unique_ptr<TuringMachine> machine;
+    TuringMachine::Status status = TuringMachine::Status::Running;
+    std::uint64_t steps = 0;
+    std::uint64_t nanoseconds = 0;
+};
+
+void writeBenchReport(std::ostream& out, const std::vector<Run>& runs, std::uint64_t wallNanoseconds, std::size_t threads) {
+    std::vector<std::uint64_t> latencies;
+    std::uint64_t steps = 0;
+    for (const Run& run : runs) {
+        latencies.push_back(run.nanoseconds);
+        steps += run.steps;
+    }
+    LatencySummary latency = LatencySummary::of(latencies);
+
+    const double seconds = static_cast<double>(wallNanoseconds) / 1e9;
+    out << std::fixed << std::setprecision(1)
+        << "runs:        " << runs.size() << " on " << threads << (threads == 1 ? " thread\n" : " threads\n")
+        << "steps:       " << steps << '\n'
+        << "wall time:   " << seconds * 1e3 << " ms\n"
+        << "throughput:  " << (seconds > 0 ? static_cast<double>(steps) / seconds : 0.0) << " steps/s, "
+        << (seconds > 0 ? static_cast<double>(runs.size()) / seconds : 0.0) << " runs/s\n"
+        << "latency us:  ";
+    latency.writeMicroseconds(out);
+    out << std::endl;
+}
+
+void writeStats(std::ostream& out, const std::vector<Run>& runs, std::size_t top) {
+    if (runs.size() == 1) {
+        if (auto* regular = dynamic_cast<const RegularTuringMachine*>(runs.front().machine.get())) {
+            regular->writeStats(out, top);
+        } else if (auto* multiTape = dynamic_cast<const MultiTapeTuringMachine*>(runs.front().machine.get())) {
+            multiTape->writeStats(out, top);
+        }
+        return;
+    }
+
+    // One object per input, in input order.
+    out << "[\n";
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        if (auto* regular = dynamic_cast<const RegularTuringMachine*>(runs[i].machine.get())) {
+            regular->writeStats(out, top);
+        } else if (auto* multiTape = dynamic_cast<const MultiTapeTuringMachine*>(runs[i].machine.get())) {
+            multiTape->writeStats(out, top);
+        }
+        if (i + 1 < runs.size()) {
+            out << ",\n";
+        }
+    }
+    out << "]\n";
+}
+
+/// Opens FILE for writing, or returns std::cout for "-".
+std::ostream* openOutput(const std::string& fileName, std::ofstream& file) {
+    if (fileName == "-") {
+        return &std::cout;
+    }
+    file.open(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Unable to open or create file: " << fileName << std::endl;
+        return nullptr;
+    }
+    return &file;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::string machineFileName = argv[1];
+    std::string outputFileName;
+    std::vector<std::string> inputFileNames;
+    std::string tapeFileName;
+    bool lazyTape = false;
+    TapeCodec::Format outputFormat = TapeCodec::Format::Raw;
+    std::string graphvizFileName;
+    TapeVisualizer::Options graphvizOptions;
+    std::string spaceTimeFileName;
+    SpaceTimeDiagram::Options spaceTimeOptions;
+    std::uint64_t maxSteps = TuringMachine::UNLIMITED;
+    std::size_t threads = 1;
+    std::size_t repetitions = 0;
+    std::string statsFileName;
+    std::size_t top = 0;
+    std::string traceFileName;
+
+    int first = 2;
+    if (argc > 2 && argv[2][0] != '-') {
+        outputFileName = argv[2];
+        first = 3;
+    }
+    try {
+        for (int i = first; i < argc; ++i) {
+            std::string option = argv[i];
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 2;
+            }
+            std::string value = argv[++i];
+            if (option == "--input") {
+                inputFileNames.push_back(value);
+            } else if (option == "--tape" || option == "--lazy-tape") {
+                tapeFileName = value;
+                lazyTape = option == "--lazy-tape";
+            } else if (option == "-o" || option == "--output") {
+                outputFileName = value;
+            } else if (option == "--compress") {
+                outputFormat = TapeCodec::parseFormat(value);
+            } else if (option == "--graphviz") {
+                graphvizFileName = value;
+            } else if (option == "--window") {
+                graphvizOptions.window = std::stoull(value);
+            } else if (option == "--collapse") {
+                graphvizOptions.minRun = std::stoull(value);
+            } else if (option == "--spacetime") {
+                spaceTimeFileName = value;
+                spaceTimeOptions.format = SpaceTimeDiagram::formatOf(value);
+            } else if (option == "--columns") {
+                spaceTimeOptions.columns = std::stoull(value);
+            } else if (option == "--cells-per-column") {
+                spaceTimeOptions.cellsPerColumn = std::stoull(value);
+            } else if (option == "--steps-per-row") {
+                spaceTimeOptions.stepsPerRow = std::stoull(value);
+            } else if (option == "--max-steps") {
+                maxSteps = std::stoull(value);
+            } else if (option == "--threads") {
+                threads = std::max<std::size_t>(1, std::stoull(value));
+            } else if (option == "--bench") {
+                repetitions = std::stoull(value);
+            } else if (option == "--stats") {
+                statsFileName = value;
+            } else if (option == "--top") {
+                top = std::stoull(value);
+            } else if (option == "--trace") {
+                traceFileName = value;
+            } else if (option == "--sample") {
+                Trace::setSampleInterval(std::stoull(value));
+            } else {
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+    } catch (const std::logic_error&) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (!tapeFileName.empty() && !inputFileNames.empty()) {
+        std::cerr << "--tape or --lazy-tape cannot be combined with --input" << std::endl;
+        return 2;
+    }
+    if (!TapeCodec::isAvailable(outputFormat)) {
+        std::cerr << "This build cannot write " << TapeCodec::formatName(outputFormat) << " tapes" << std::endl;
+        return 2;
+    }
+    if ((outputFormat != TapeCodec::Format::Raw || !graphvizFileName.empty()) && !inputFileNames.empty()) {
+        std::cerr << "--compress and --graphviz write a single tape and cannot be combined with --input" << std::endl;
+        return 2;
+    }
+    if (!spaceTimeFileName.empty() && (!inputFileNames.empty() || repetitions != 0 || !statsFileName.empty())) {
+        std::cerr << "--spacetime draws a single run and cannot be combined with --input, --bench or --stats" << std::endl;
+        return 2;
+    }
+    if (!SpaceTimeDiagram::isAvailable(spaceTimeOptions.format)) {
+        std::cerr << "This build cannot write PNG images; use a .ppm file" << std::endl;
+        return 2;
+    }
+    if (outputFileName.empty() && repetitions == 0) {
+        outputFileName = "-";
+    }
+
+    if (!traceFileName.empty()) {
+        if (!Trace::isCompiledIn()) {
+            std::cerr << "Tracing is not compiled in; rebuild with -DTM_ENABLE_TRACING=ON" << std::endl;
+            traceFileName.clear();
+        }
+        Trace::start();
+    }
+
+    try {
+        TuringMachineFactory factory;
+        auto prototype = factory.getMachine(machineFileName);
+
+        if (!statsFileName.empty()) {
+            if (auto* regular = dynamic_cast<RegularTuringMachine*>(prototype.get())) {
+                regular->enableStats();
+            } else if (auto* multiTape = dynamic_cast<MultiTapeTuringMachine*>(prototype.get())) {
+                multiTape->enableStats();
+            } else {
+                std::cerr << "Statistics are only collected for REGULAR and MULTITAPE machines" << std::endl;
+                statsFileName.clear();
+            }
+        }
+
+        if (!tapeFileName.empty() && !dynamic_cast<RegularTuringMachine*>(prototype.get())
+            && !(lazyTape && dynamic_cast<MultiTapeTuringMachine*>(prototype.get()))) {
+            throw std::runtime_error(lazyTape ? "Mapped tapes are only supported for REGULAR and MULTITAPE machines"
+                                              : "Streamed tapes are only supported for REGULAR machines");
+        }
+
+        // Without --input the machine runs once on the tape of its description.
+        std::vector<std::optional<std::string>> inputs;
+        for (const auto& fileName : inputFileNames) {
+            std::vector<std::string> tapes;
+            if (fileName == "-") {
+                readInputs(std::cin, tapes);
+            } else {
+                std::ifstream file(fileName);
+                if (!file.is_open()) {
+                    throw std::runtime_error("Unable to open file: " + fileName);
+                }
+                readInputs(file, tapes);
+            }
+            inputs.insert(inputs.end(), tapes.begin(), tapes.end());
+        }
+        if (inputFileNames.empty()) {
+            inputs.emplace_back();
+        }
+
+        std::vector<Run> runs;
+        const std::size_t rounds = std::max<std::size_t>(repetitions, 1);
+        runs.reserve(inputs.size() * rounds);
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (std::size_t input = 0; input < inputs.size(); ++input) {
+                runs.push_back(Run{input, nullptr});
+            }
+        }
+
+        // Workers take runs in order; each run gets its own clone of the parsed machine.
+        std::atomic<std::size_t> next{0};
+        std::atomic<bool> failed{false};
+        auto work = [&]() {
+            try {
+                for (std::size_t i = next++; i < runs.size() && !failed; i = next++) {
+                    Run& run = runs[i];
+                    run.machine = prototype->clone();
+                    if (inputs[run.input]) {
+                        run.machine->setInput(*inputs[run.input]);
+                    } else if (!tapeFileName.empty()) {
+                        if (auto* multiTape = dynamic_cast<MultiTapeTuringMachine*>(run.machine.get())) {
+                            multiTape->mapInputFile(tapeFileName);
+                        } else if (lazyTape) {
+                            static_cast<RegularTuringMachine&>(*run.machine).mapInputFile(tapeFileName);
+                        } else {
+                            static_cast<RegularTuringMachine&>(*run.machine).setInputFile(tapeFileName);
+                        }
+                    }
+                    auto start = std::chrono::steady_clock::now();
+                    run.status = spaceTimeFileName.empty()
+                                 ? run.machine->advance(maxSteps)
+                                 : SpaceTimeDiagram::record(*run.machine, spaceTimeFileName, spaceTimeOptions, maxSteps);
+                    run.nanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count());
+                    run.steps = run.machine->getStepCount();
+                    if (i + inputs.size() < runs.size()) {
+                        run.machine.reset(); // Only the last round is written out.
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                failed = true;
+            }
+        };
+
+        threads = std::min(threads, runs.size());
+        auto wallStart = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i < threads; ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        auto wallNanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - wallStart).count());
+        if (failed) {
+            return 1;
+        }
+
+        if (repetitions != 0) {
+            writeBenchReport(std::cout, runs, wallNanoseconds, threads);
+        }
+        // Results come from the last round; earlier rounds only count for the benchmark.
+        std::vector<Run> results(std::make_move_iterator(runs.end() - static_cast<std::ptrdiff_t>(inputs.size())),
+                                 std::make_move_iterator(runs.end()));
+
+        int exitCode = 0;
+        for (const Run& run : results) {
+            if (run.status == TuringMachine::Status::Running) {
+                std::cerr << "Input " << run.input + 1 << ": step limit of " << maxSteps << " reached" << std::endl;
+                exitCode = 3;
+            } else if (run.status == TuringMachine::Status::NoTransition) {
+                std::cerr << "Input " << run.input + 1 << ": machine reached invalid state" << std::endl;
+                exitCode = 3;
+            }
+        }
+
+        {
+            TM_TRACE_SCOPE("output");
+            std::ofstream outputFile;
+            if (!outputFileName.empty() && outputFormat != TapeCodec::Format::Raw) {
+                std::ostream* out = openOutput(outputFileName, outputFile);
+                if (!out) {
+                    return 1;
+                }
+                const TuringMachine& machine = *results.front().machine;
+                if (auto* regular = dynamic_cast<const RegularTuringMachine*>(&machine)) {
+                    TapeCodec::write(regular->getExecution().getTape(), *out, outputFormat);
+                } else {
+                    TapeCodec::write(Tape(machine.getOutput()), *out, outputFormat);
+                }
+                out->flush();
+            } else if (!outputFileName.empty()) {
+                std::ostream* out = openOutput(outputFileName, outputFile);
+                if (!out) {
+                    return 1;
+                }
+                for (const Run& run : results) {
+                    *out << run.machine->getOutput() << '\n';
+                }
+                out->flush();
+            }
+        }
+
+        if (!graphvizFileName.empty()) {
+            std::ofstream graphvizFile;
+            std::ostream* out = openOutput(graphvizFileName, graphvizFile);
+            if (!out) {
+                return 1;
+            }
+            const TuringMachine& machine = *results.front().machine;
+            if (auto* regular = dynamic_cast<const RegularTuringMachine*>(&machine)) {
+                TapeVisualizer::writeGraphviz(regular->getExecution().getTape(), *out, graphvizOptions);
+            } else {
+                TapeVisualizer::writeGraphviz(Tape(machine.getOutput(), machine.getHeadPosition()), *out, graphvizOptions);
+            }
+        }
+
+        if (!statsFileName.empty()) {
+            std::ofstream statsFile;
+            std::ostream* out = openOutput(statsFileName, statsFile);
+            if (!out) {
+                return 1;
+            }
+            writeStats(*out, results, top);
+        }
+
+        if (!traceFileName.empty()) {
+            Trace::stop();
+            std::ofstream traceFile(traceFileName);
+            if (!traceFile.is_open()) {
+                std::cerr << "Unable to open or create file: " << traceFileName << std::endl;
+                return 1;
+            }
+            Trace::writeChromeJson(traceFile);
+        }
+        return exitCode;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,73 @@
+#include <csignal>
+#include <exception>
+#include <iostream>
+#include <string>
+#include "../turingmachine/server/MachineServer.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <socket> [options]\n"
+              << "Runs machines for tmclient requests until interrupted.\n"
+              << "Options:\n"
+              << "  --threads N     worker threads (default: one per core)\n"
+              << "  --max-steps N   cap the steps of every request" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::string socketPath = argv[1];
+    std::size_t threads = 0;
+    std::uint64_t stepLimit = 0;
+    try {
+        for (int i = 2; i < argc; ++i) {
+            std::string option = argv[i];
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 2;
+            }
+            std::string value = argv[++i];
+            if (option == "--threads") {
+                threads = std::stoull(value);
+            } else if (option == "--max-steps") {
+                stepLimit = std::stoull(value);
+            } else {
+                printUsage(argv[0]);
+                return 2;
+            }
+        }
+    } catch (const std::logic_error&) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // Block the stop signals before any thread starts, so only sigwait() below receives them.
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    try {
+        MachineServer server(socketPath, threads);
+        server.setStepLimit(stepLimit);
+        server.start();
+        std::cerr << "Listening on " << socketPath << std::endl;
+
+        int signal = 0;
+        sigwait(&stopSignals, &signal);
+        server.stop();
+        std::cerr << "Served " << server.getRequestCount() << " requests for "
+                  << server.getCacheSize() << " cached machines" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
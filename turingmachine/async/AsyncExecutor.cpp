@@ -0,0 +1,155 @@
+#include <algorithm>
+#include "AsyncExecutor.h"
+
+AsyncExecution::AsyncExecution(std::unique_ptr<TuringMachine> machine, AsyncOptions options)
+        : machine(std::move(machine)), options(std::move(options)), future(promise.get_future().share()) {
+    startSteps = this->machine->getStepCount();
+    tapeSize.store(this->machine->getTapeSize(), std::memory_order_relaxed);
+    if (this->options.sliceSteps == 0) {
+        this->options.sliceSteps = 1;
+    }
+}
+
+ExecutionProgress AsyncExecution::getProgress() const {
+    ExecutionProgress progress;
+    progress.steps = steps.load(std::memory_order_relaxed);
+    progress.tapeSize = tapeSize.load(std::memory_order_relaxed);
+    return progress;
+}
+
+bool AsyncExecution::runSlice() {
+    AsyncResult result;
+    if (cancelled.load(std::memory_order_relaxed)) {
+        result.cancelled = true;
+        result.steps = steps.load(std::memory_order_relaxed);
+        finish(result);
+        return false;
+    }
+
+    try {
+        const std::uint64_t taken = steps.load(std::memory_order_relaxed);
+        const std::uint64_t slice = std::min(options.sliceSteps, options.maxSteps - taken);
+        result.status = machine->advance(slice);
+
+        ExecutionProgress progress;
+        progress.steps = machine->getStepCount() - startSteps;
+        progress.tapeSize = machine->getTapeSize();
+        steps.store(progress.steps, std::memory_order_relaxed);
+        tapeSize.store(progress.tapeSize, std::memory_order_relaxed);
+
+        if (result.status == TuringMachine::Status::Running && progress.steps < options.maxSteps) {
+            if (options.onProgress) {
+                options.onProgress(progress);
+            }
+            return true;
+        }
+        result.steps = progress.steps;
+    } catch (...) {
+        done.store(true, std::memory_order_release);
+        promise.set_exception(std::current_exception());
+        return false;
+    }
+    finish(result);
+    return false;
+}
+
+void AsyncExecution::finish(const AsyncResult& result) {
+    if (options.onComplete) {
+        options.onComplete(result);
+    }
+    done.store(true, std::memory_order_release);
+    promise.set_value(result);
+}
+
+AsyncExecutor::AsyncExecutor(std::size_t threadCount) {
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&AsyncExecutor::loop, this);
+    }
+}
+
+AsyncExecutor::~AsyncExecutor() {
+    std::deque<std::shared_ptr<AsyncExecution>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        abandoned.swap(queue);
+    }
+    ready.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // Each abandoned execution runs one more "slice", which only reports the cancellation.
+    for (auto& execution : abandoned) {
+        execution->cancel();
+        execution->runSlice();
+    }
+}
+
+std::shared_ptr<AsyncExecution> AsyncExecutor::launch(std::unique_ptr<TuringMachine> machine, AsyncOptions options) {
+    auto execution = std::make_shared<AsyncExecution>(std::move(machine), std::move(options));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++active;
+        queue.push_back(execution);
+    }
+    ready.notify_one();
+    return execution;
+}
+
+bool AsyncExecutor::poll() {
+    std::shared_ptr<AsyncExecution> execution = next(false);
+    if (!execution) {
+        return false;
+    }
+    requeue(execution->runSlice() ? std::move(execution) : nullptr);
+    return true;
+}
+
+void AsyncExecutor::runUntilIdle() {
+    while (poll()) {
+    }
+}
+
+std::size_t AsyncExecutor::getActiveCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return active;
+}
+
+std::shared_ptr<AsyncExecution> AsyncExecutor::next(bool block) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (block) {
+        ready.wait(lock, [this] { return stopping || !queue.empty(); });
+    }
+    if (queue.empty() || stopping) {
+        return nullptr;
+    }
+    std::shared_ptr<AsyncExecution> execution = std::move(queue.front());
+    queue.pop_front();
+    return execution;
+}
+
+void AsyncExecutor::requeue(std::shared_ptr<AsyncExecution> execution) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!execution) {
+            --active;
+            return;
+        }
+        if (stopping) {
+            // The destructor already took the queue; report the cancellation here instead.
+            --active;
+        } else {
+            queue.push_back(std::move(execution));
+            ready.notify_one();
+            return;
+        }
+    }
+    execution->cancel();
+    execution->runSlice();
+}
+
+void AsyncExecutor::loop() {
+    while (std::shared_ptr<AsyncExecution> execution = next(true)) {
+        requeue(execution->runSlice() ? std::move(execution) : nullptr);
+    }
+}
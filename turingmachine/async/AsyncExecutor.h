@@ -0,0 +1,134 @@
+/**
+ * @file AsyncExecutor.h
+ * @brief Runs many machines concurrently in time slices on a small number of threads.
+ *
+ * C++17 has no coroutines, so an asynchronous execution is a future plus callbacks. A
+ * launched machine is advanced a slice of steps at a time and then goes to the back of the
+ * executor's run queue, so one event loop shares its thread fairly between thousands of
+ * long-running machines instead of blocking in run().
+ */
+#ifndef TURING_MACHINE_ASYNCEXECUTOR_H
+#define TURING_MACHINE_ASYNCEXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../machines/TuringMachine.h"
+
+/// Snapshot of a running execution, published after every slice.
+struct ExecutionProgress {
+    std::uint64_t steps = 0;    ///< Steps taken since the launch.
+    std::size_t tapeSize = 0;   ///< Cells on the tape.
+};
+
+struct AsyncResult {
+    TuringMachine::Status status = TuringMachine::Status::Running; ///< Running when the step budget ran out.
+    bool cancelled = false;
+    std::uint64_t steps = 0;    ///< Steps taken since the launch.
+};
+
+struct AsyncOptions {
+    std::uint64_t sliceSteps = 1 << 16;             ///< Steps per time slice.
+    std::uint64_t maxSteps = TuringMachine::UNLIMITED; ///< Step budget of the whole execution.
+    /// Called on the executor thread after every slice that did not finish the execution.
+    std::function<void(const ExecutionProgress&)> onProgress;
+    /// Called on the executor thread once, when the execution finishes or is cancelled;
+    /// an exception thrown by the machine only reaches the future.
+    std::function<void(const AsyncResult&)> onComplete;
+};
+
+/**
+ * @class AsyncExecution
+ * @brief Handle of one launched machine. It is safe to use from any thread.
+ */
+class AsyncExecution {
+public:
+    AsyncExecution(std::unique_ptr<TuringMachine> machine, AsyncOptions options);
+
+    /// Asks the execution to stop; it does so before its next slice.
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    bool isDone() const { return done.load(std::memory_order_acquire); }
+
+    ExecutionProgress getProgress() const;
+
+    /// Becomes ready when the execution ends; holds the exception if advancing the machine threw.
+    std::shared_future<AsyncResult> getFuture() const { return future; }
+
+    /// Blocks until the execution ends and returns its result.
+    AsyncResult wait() const { return future.get(); }
+
+    /// The machine, with its final tape; only to be used once isDone() is true.
+    TuringMachine& getMachine() { return *machine; }
+
+private:
+    friend class AsyncExecutor;
+    friend class MachineScheduler;
+
+    /// Runs one slice; returns true when the execution needs another one.
+    bool runSlice();
+    void finish(const AsyncResult& result);
+
+    std::unique_ptr<TuringMachine> machine;
+    AsyncOptions options;
+    std::uint64_t startSteps;        ///< Step count of the machine at launch.
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> steps{0};
+    std::atomic<std::size_t> tapeSize{0};
+    std::promise<AsyncResult> promise;
+    std::shared_future<AsyncResult> future;
+};
+
+/**
+ * @class AsyncExecutor
+ * @brief A round-robin run queue of executions, driven by its own threads or by the caller.
+ */
+class AsyncExecutor {
+public:
+    /**
+     * Starts `threads` event-loop threads. With 0 threads nothing runs until the caller drives
+     * the queue with poll() or runUntilIdle(), which fits an existing event loop.
+     */
+    explicit AsyncExecutor(std::size_t threads = 1);
+
+    /// Cancels the executions still queued and waits for the slices being run.
+    ~AsyncExecutor();
+
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+
+    /// Queues a machine; it continues from its current configuration.
+    std::shared_ptr<AsyncExecution> launch(std::unique_ptr<TuringMachine> machine, AsyncOptions options = {});
+
+    /// Runs one slice of the execution at the front of the queue; false when the queue is empty.
+    bool poll();
+
+    /// Polls until every launched execution has finished.
+    void runUntilIdle();
+
+    /// Executions launched and not yet finished.
+    std::size_t getActiveCount() const;
+
+private:
+    std::shared_ptr<AsyncExecution> next(bool block);
+    void requeue(std::shared_ptr<AsyncExecution> execution);
+    void loop();
+
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::shared_ptr<AsyncExecution>> queue;
+    std::size_t active = 0;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+};
+
+#endif //TURING_MACHINE_ASYNCEXECUTOR_H
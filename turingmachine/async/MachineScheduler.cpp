@@ -0,0 +1,194 @@
+#include <algorithm>
+#include "MachineScheduler.h"
+
+namespace {
+
+constexpr std::size_t LATENCY_WINDOW = 4096;
+
+std::uint64_t nanosecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+}
+
+void MachineScheduler::LatencyWindow::add(std::uint64_t nanoseconds) {
+    if (samples.size() < LATENCY_WINDOW) {
+        samples.push_back(nanoseconds);
+    } else {
+        samples[next] = nanoseconds;
+        next = (next + 1) % LATENCY_WINDOW;
+    }
+}
+
+LatencySummary MachineScheduler::LatencyWindow::summarize() const {
+    std::vector<std::uint64_t> copy = samples;
+    return LatencySummary::of(copy);
+}
+
+MachineScheduler::MachineScheduler(Options options) : options(options), created(Clock::now()) {
+    if (this->options.quantum == 0) {
+        this->options.quantum = 1;
+    }
+    for (std::size_t i = 0; i < options.workers; ++i) {
+        workers.emplace_back(&MachineScheduler::work, this);
+    }
+}
+
+MachineScheduler::~MachineScheduler() {
+    std::vector<QueueEntry> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        abandoned.swap(queue);
+    }
+    ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& entry : abandoned) {
+        entry.job->execution->cancel();
+        entry.job->execution->runSlice();
+    }
+}
+
+std::shared_ptr<AsyncExecution> MachineScheduler::submit(std::unique_ptr<TuringMachine> machine, int priority, AsyncOptions jobOptions) {
+    auto job = std::make_shared<Job>();
+    jobOptions.sliceSteps = options.quantum;
+    // Account for the end before the user callback and the future see it, so the metrics are
+    // up to date for anyone woken by them.
+    jobOptions.onComplete = [this, ended = job.get(), onComplete = std::move(jobOptions.onComplete)](const AsyncResult& result) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            turnaround.add(nanosecondsBetween(ended->submitted, Clock::now()));
+            ++(result.cancelled ? metrics.cancelled : metrics.completed);
+        }
+        if (onComplete) {
+            onComplete(result);
+        }
+    };
+    job->execution = std::make_shared<AsyncExecution>(std::move(machine), std::move(jobOptions));
+    job->priority = priority;
+    job->submitted = Clock::now();
+
+    std::shared_ptr<AsyncExecution> execution = job->execution;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++metrics.submitted;
+        enqueue(std::move(job), Clock::now());
+    }
+    ready.notify_one();
+    return execution;
+}
+
+void MachineScheduler::enqueue(std::shared_ptr<Job> job, Clock::time_point now) {
+    // Waiting one aging interval is worth one priority level. Comparing effective priorities
+    // at any later moment then gives the same order as comparing these keys.
+    job->enqueued = now;
+    double key = static_cast<double>(now.time_since_epoch().count())
+                 - static_cast<double>(job->priority) * static_cast<double>(
+                         std::chrono::duration_cast<Clock::duration>(options.agingInterval).count());
+    queue.push_back(QueueEntry{key, sequence++, std::move(job)});
+    std::push_heap(queue.begin(), queue.end(), [](const QueueEntry& a, const QueueEntry& b) {
+        return a.key != b.key ? a.key > b.key : a.sequence > b.sequence;
+    });
+    ++metrics.queued;
+}
+
+std::shared_ptr<MachineScheduler::Job> MachineScheduler::take(bool block) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (block) {
+        ready.wait(lock, [this] { return stopping || !queue.empty(); });
+    }
+    if (stopping || queue.empty()) {
+        return nullptr;
+    }
+
+    std::pop_heap(queue.begin(), queue.end(), [](const QueueEntry& a, const QueueEntry& b) {
+        return a.key != b.key ? a.key > b.key : a.sequence > b.sequence;
+    });
+    std::shared_ptr<Job> job = std::move(queue.back().job);
+    queue.pop_back();
+    --metrics.queued;
+    ++metrics.running;
+
+    Clock::time_point now = Clock::now();
+    if (job->started) {
+        sliceWait.add(nanosecondsBetween(job->enqueued, now));
+    } else {
+        queueLatency.add(nanosecondsBetween(job->submitted, now));
+        job->started = true;
+    }
+    return job;
+}
+
+void MachineScheduler::runQuantum(const std::shared_ptr<Job>& job) {
+    AsyncExecution& execution = *job->execution;
+    const std::uint64_t before = execution.getProgress().steps;
+    const bool more = execution.runSlice();
+    const std::uint64_t taken = execution.getProgress().steps - before;
+
+    Clock::time_point now = Clock::now();
+    bool abandoned = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        --metrics.running;
+        ++metrics.slices;
+        metrics.steps += taken;
+        if (more) {
+            abandoned = stopping;
+            if (!abandoned) {
+                enqueue(job, now);
+            }
+        } else {
+            try {
+                execution.getFuture().get();
+            } catch (...) {
+                turnaround.add(nanosecondsBetween(job->submitted, now));
+                ++metrics.failed;
+            }
+            return;
+        }
+    }
+    if (abandoned) {
+        // The destructor already took the queue; report the cancellation here instead.
+        execution.cancel();
+        execution.runSlice();
+    } else {
+        ready.notify_one();
+    }
+}
+
+bool MachineScheduler::poll() {
+    std::shared_ptr<Job> job = take(false);
+    if (!job) {
+        return false;
+    }
+    runQuantum(job);
+    return true;
+}
+
+void MachineScheduler::runUntilIdle() {
+    while (poll()) {
+    }
+}
+
+void MachineScheduler::work() {
+    while (std::shared_ptr<Job> job = take(true)) {
+        runQuantum(job);
+    }
+}
+
+SchedulerMetrics MachineScheduler::getMetrics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    SchedulerMetrics snapshot = metrics;
+    snapshot.elapsedSeconds = std::chrono::duration<double>(Clock::now() - created).count();
+    if (snapshot.elapsedSeconds > 0) {
+        snapshot.stepsPerSecond = static_cast<double>(snapshot.steps) / snapshot.elapsedSeconds;
+        snapshot.jobsPerSecond = static_cast<double>(snapshot.completed + snapshot.cancelled + snapshot.failed)
+                                 / snapshot.elapsedSeconds;
+    }
+    snapshot.queueLatency = queueLatency.summarize();
+    snapshot.sliceWait = sliceWait.summarize();
+    snapshot.turnaround = turnaround.summarize();
+    return snapshot;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file MachineScheduler.h
+ * @brief Priority scheduler sharing a fixed worker pool between many machine executions.
+ */
+#ifndef TURING_MACHINE_MACHINESCHEDULER_H
+#define TURING_MACHINE_MACHINESCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AsyncExecutor.h"
+#include "../stats/LatencySummary.h"
+
+/// Counters of a MachineScheduler since it was created.
+struct SchedulerMetrics {
+    std::uint64_t submitted = 0;
+    std::uint64_t completed = 0;     ///< Jobs that halted, got stuck or used up their budget.
+    std::uint64_t cancelled = 0;
+    std::uint64_t failed = 0;        ///< Jobs whose machine threw.
+    std::uint64_t slices = 0;
+    std::uint64_t steps = 0;
+    std::size_t queued = 0;          ///< Jobs waiting for a worker.
+    std::size_t running = 0;         ///< Jobs being run by a worker.
+    double elapsedSeconds = 0;
+    double stepsPerSecond = 0;
+    double jobsPerSecond = 0;        ///< Completed, cancelled and failed jobs per second.
+    LatencySummary queueLatency;     ///< Submission to first slice, nanoseconds.
+    LatencySummary sliceWait;        ///< End of a slice to the start of the job's next one, nanoseconds.
+    LatencySummary turnaround;       ///< Submission to the end of the job, nanoseconds.
+};
+
+/**
+ * @class MachineScheduler
+ * @brief Runs jobs for a quantum of steps at a time, highest effective priority first.
+ *
+ * A job's effective priority is its priority plus one level for every agingInterval it has
+ * waited in the queue, so low-priority jobs are delayed but never starved. After each
+ * quantum a job goes back to the queue, so long machines cannot hold a worker while short
+ * ones wait. Jobs are AsyncExecutions: they report progress, can be cancelled and finish
+ * through their futures. Latency percentiles cover the most recent samples only.
+ */
+class MachineScheduler {
+public:
+    struct Options {
+        std::size_t workers = 0;                 ///< Worker threads; 0 leaves the driving to poll().
+        std::uint64_t quantum = 1 << 14;         ///< Steps a job runs before it is re-queued.
+        std::chrono::nanoseconds agingInterval = std::chrono::milliseconds(10); ///< Wait worth one priority level.
+    };
+
+    explicit MachineScheduler(Options options);
+    ~MachineScheduler();
+
+    MachineScheduler(const MachineScheduler&) = delete;
+    MachineScheduler& operator=(const MachineScheduler&) = delete;
+
+    /**
+     * Queues a machine; higher priorities run first. options.maxSteps is the job's step
+     * budget; options.sliceSteps is replaced by the scheduler's quantum.
+     */
+    std::shared_ptr<AsyncExecution> submit(std::unique_ptr<TuringMachine> machine, int priority = 0, AsyncOptions options = {});
+
+    /// Runs one quantum of the most urgent job on the calling thread; false when none is queued.
+    bool poll();
+
+    /// Polls until no job is left.
+    void runUntilIdle();
+
+    SchedulerMetrics getMetrics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::shared_ptr<AsyncExecution> execution;
+        int priority;
+        Clock::time_point submitted;
+        Clock::time_point enqueued;
+        bool started = false;
+    };
+
+    struct QueueEntry {
+        double key;             ///< Enqueue time minus the priority's worth of waiting; smallest runs first.
+        std::uint64_t sequence; ///< Keeps equal keys in FIFO order.
+        std::shared_ptr<Job> job;
+    };
+
+    /// Fixed-size window of the latest latency samples.
+    struct LatencyWindow {
+        std::vector<std::uint64_t> samples;
+        std::size_t next = 0;
+        void add(std::uint64_t nanoseconds);
+        LatencySummary summarize() const;
+    };
+
+    void enqueue(std::shared_ptr<Job> job, Clock::time_point now);
+    std::shared_ptr<Job> take(bool block);
+    void runQuantum(const std::shared_ptr<Job>& job);
+    void work();
+
+    Options options;
+    Clock::time_point created;
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<QueueEntry> queue; ///< Binary heap ordered by key.
+    std::uint64_t sequence = 0;
+    bool stopping = false;
+    SchedulerMetrics metrics;
+    LatencyWindow queueLatency;
+    LatencyWindow sliceWait;
+    LatencyWindow turnaround;
+    std::vector<std::thread> workers;
+};
+
+#endif //TURING_MACHINE_MACHINESCHEDULER_H
@@ -0,0 +1,124 @@
+#include "CachedTuringMachine.h"
+
+#include <fstream>
+#include <iostream>
+#include "../trace/Trace.h"
+
+CachedTuringMachine::CachedTuringMachine(std::unique_ptr<TuringMachine> machine, std::shared_ptr<ResultCache> cache, Hash128 program)
+        : inner(std::move(machine)), cache(std::move(cache)), program(program) {
+    // The tape of the description is the input until another one is set.
+    input = hash128(inner->getOutput());
+}
+
+CachedTuringMachine::CachedTuringMachine(std::unique_ptr<TuringMachine> machine, std::shared_ptr<ResultCache> cache, Hash128 program, Hash128 input)
+        : inner(std::move(machine)), cache(std::move(cache)), program(program), input(input) {
+}
+
+void CachedTuringMachine::init(std::istream& inputStream) {
+    // A new description is a new program, which the hash no longer identifies.
+    pendingInput.reset();
+    result.reset();
+    inner->init(inputStream);
+    input.reset();
+}
+
+void CachedTuringMachine::run(const std::string& outputFileName) {
+    // The run goes through advance(), so it is answered from the cache or added to it.
+    if (advance() == Status::NoTransition) {
+        std::cerr << "Machine reached invalid state: " << getStateName() << std::endl;
+    }
+
+    TM_TRACE_SCOPE("output");
+    std::ofstream outFile(outputFileName, std::ios::out);
+    if (outFile.is_open()) {
+        outFile << getOutput();
+        std::cout << "Tape successfully written to " << outputFileName << std::endl;
+    } else {
+        std::cerr << "Unable to open or create file: " << outputFileName << std::endl;
+    }
+}
+
+CachedTuringMachine::CachedTuringMachine(const CachedTuringMachine& other)
+        : inner(other.inner->clone()), cache(other.cache), program(other.program), input(other.input),
+          pendingInput(other.pendingInput), result(other.result), started(other.started) {
+}
+
+std::unique_ptr<TuringMachine> CachedTuringMachine::clone() const {
+    return std::unique_ptr<TuringMachine>(new CachedTuringMachine(*this));
+}
+
+void CachedTuringMachine::setInput(const std::string& tape) {
+    pendingInput = tape;
+    input = hash128(tape);
+    result.reset();
+    started = false;
+}
+
+TuringMachine::Status CachedTuringMachine::advance(std::uint64_t maxSteps) {
+    if (result) {
+        return result->status;
+    }
+
+    const bool fresh = !started;
+    started = true;
+    if (fresh && input) {
+        std::optional<CachedResult> cached = cache->find(ResultKey{program, *input});
+        if (cached && cached->steps <= maxSteps) {
+            result = std::move(cached);
+            return result->status;
+        }
+    }
+
+    TuringMachine& running = machine();
+    if (fresh && running.getStepCount() != 0) {
+        input.reset(); // Continuing an earlier run, not starting one from the input.
+    }
+    const Status status = running.advance(maxSteps);
+    if (status != Status::Running && input) {
+        CachedResult finished;
+        finished.status = status;
+        finished.steps = running.getStepCount();
+        finished.head = running.getHeadPosition();
+        finished.state = running.getStateName();
+        finished.tape = running.getOutput();
+        cache->insert(ResultKey{program, *input}, finished);
+        input.reset(); // Later calls only repeat the end.
+    }
+    return status;
+}
+
+std::string CachedTuringMachine::getOutput() const {
+    return result ? result->tape : machine().getOutput();
+}
+
+std::size_t CachedTuringMachine::getTapeSize() const {
+    return result ? result->tape.size() : machine().getTapeSize();
+}
+
+std::uint64_t CachedTuringMachine::getStepCount() const {
+    return result ? result->steps : machine().getStepCount();
+}
+
+std::size_t CachedTuringMachine::getHeadPosition() const {
+    return result ? result->head : machine().getHeadPosition();
+}
+
+std::string CachedTuringMachine::getStateName() const {
+    return result ? result->state : machine().getStateName();
+}
+
+void CachedTuringMachine::forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const {
+    inner->forEachProgram(visit);
+}
+
+TuringMachine& CachedTuringMachine::getMachine() {
+    return machine();
+}
+
+TuringMachine& CachedTuringMachine::machine() const {
+    if (pendingInput) {
+        inner->setInput(*pendingInput);
+        pendingInput.reset();
+    }
+    return *inner;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file CachedTuringMachine.h
+ * @brief A machine that answers repeated runs from a ResultCache.
+ */
+#ifndef TURING_MACHINE_CACHEDTURINGMACHINE_H
+#define TURING_MACHINE_CACHEDTURINGMACHINE_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include "ResultCache.h"
+
+/**
+ * @class CachedTuringMachine
+ * @brief Wraps a machine and short-circuits advance() for runs whose result is cached.
+ *
+ * A run is looked up when advance() is first called after the machine was created or given
+ * an input; on a hit the wrapped machine is not even given the input. Runs that end, in
+ * however many advance() calls, are added to the cache. run() is advance() followed by
+ * writing the final tape, so it is answered from the cache as well.
+ */
+class CachedTuringMachine : public TuringMachine {
+public:
+    /// `program` identifies what the machine computes; `machine` must be in its initial configuration.
+    CachedTuringMachine(std::unique_ptr<TuringMachine> machine, std::shared_ptr<ResultCache> cache, Hash128 program);
+    /// As above, with the hash of the machine's current tape already known.
+    CachedTuringMachine(std::unique_ptr<TuringMachine> machine, std::shared_ptr<ResultCache> cache, Hash128 program, Hash128 input);
+
+    void init(std::istream& inputStream) override;
+    void run(const std::string& outputFileName) override;
+    std::unique_ptr<TuringMachine> clone() const override;
+    void setInput(const std::string& tape) override;
+    Status advance(std::uint64_t maxSteps = UNLIMITED) override;
+    std::string getOutput() const override;
+    std::size_t getTapeSize() const override;
+    std::uint64_t getStepCount() const override;
+    std::size_t getHeadPosition() const override;
+    std::string getStateName() const override;
+    void forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const override;
+
+    /// Whether the current run was answered from the cache.
+    bool isCachedResult() const { return result.has_value(); }
+
+    TuringMachine& getMachine();
+
+private:
+    CachedTuringMachine(const CachedTuringMachine& other);
+
+    /// Gives the wrapped machine the input it has not been given yet.
+    TuringMachine& machine() const;
+
+    std::unique_ptr<TuringMachine> inner;
+    std::shared_ptr<ResultCache> cache;
+    Hash128 program;
+    std::optional<Hash128> input;          ///< Hash of the input the run started from; unset once unknown.
+    mutable std::optional<std::string> pendingInput; ///< Input not yet handed to the wrapped machine.
+    std::optional<CachedResult> result;    ///< The cached result being reported instead of the machine.
+    bool started = false;                  ///< Whether advance() was called for the current input.
+};
+
+#endif //TURING_MACHINE_CACHEDTURINGMACHINE_H
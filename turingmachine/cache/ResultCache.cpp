@@ -0,0 +1,157 @@
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "ResultCache.h"
+
+namespace {
+
+constexpr const char* FILE_TYPE = "TMRESULT";
+constexpr int FORMAT_VERSION = 1;
+
+std::size_t resultBytes(const CachedResult& result) {
+    return result.tape.size() + result.state.size() + sizeof(CachedResult);
+}
+
+}
+
+ResultCache::ResultCache() : ResultCache(Options()) {
+}
+
+ResultCache::ResultCache(Options options) : options(std::move(options)) {
+    if (!this->options.directory.empty()) {
+        std::filesystem::create_directories(this->options.directory);
+    }
+}
+
+std::optional<CachedResult> ResultCache::find(const ResultKey& key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            ++stats.hits;
+            return it->second->second;
+        }
+        if (options.directory.empty()) {
+            ++stats.misses;
+            return std::nullopt;
+        }
+    }
+
+    // The file is read without holding the lock; another thread may promote it meanwhile.
+    std::optional<CachedResult> result = readFile(key);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!result) {
+        ++stats.misses;
+        return std::nullopt;
+    }
+    ++stats.diskHits;
+    if (index.find(key) == index.end()) {
+        store(key, *result);
+    }
+    return result;
+}
+
+void ResultCache::insert(const ResultKey& key, const CachedResult& result) {
+    bool written = !options.directory.empty() && writeFile(key, result);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (written) {
+        ++stats.diskWrites;
+    }
+    auto it = index.find(key);
+    if (it != index.end()) {
+        // A deterministic run has one result; only refresh its recency.
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    store(key, result);
+}
+
+void ResultCache::store(const ResultKey& key, const CachedResult& result) {
+    const std::size_t size = resultBytes(result);
+    if (options.capacity == 0 || size > options.maxBytes) {
+        return;
+    }
+    entries.emplace_front(key, result);
+    index.emplace(key, entries.begin());
+    bytes += size;
+    while (entries.size() > options.capacity || bytes > options.maxBytes) {
+        bytes -= resultBytes(entries.back().second);
+        index.erase(entries.back().first);
+        entries.pop_back();
+        ++stats.evictions;
+    }
+}
+
+ResultCache::Stats ResultCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats snapshot = stats;
+    snapshot.entries = entries.size();
+    snapshot.bytes = bytes;
+    return snapshot;
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    bytes = 0;
+}
+
+std::string ResultCache::filePath(const ResultKey& key) const {
+    return (std::filesystem::path(options.directory) / (key.program.toHex() + "-" + key.input.toHex() + ".result")).string();
+}
+
+// File format: a header line "TMRESULT <version> <status> <steps> <head> <state size> <tape size>",
+// followed by the state name and the tape.
+std::optional<CachedResult> ResultCache::readFile(const ResultKey& key) const {
+    std::ifstream file(filePath(key), std::ios::binary);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    std::string type;
+    int version = 0;
+    int status = 0;
+    std::size_t stateSize = 0;
+    std::size_t tapeSize = 0;
+    CachedResult result;
+    if (!(file >> type >> version >> status >> result.steps >> result.head >> stateSize >> tapeSize)
+        || type != FILE_TYPE || version != FORMAT_VERSION || file.get() != '\n'
+        || (status != static_cast<int>(TuringMachine::Status::Halted) && status != static_cast<int>(TuringMachine::Status::NoTransition))) {
+        return std::nullopt;
+    }
+    result.status = static_cast<TuringMachine::Status>(status);
+    result.state.resize(stateSize);
+    result.tape.resize(tapeSize);
+    if (!file.read(result.state.data(), static_cast<std::streamsize>(stateSize))
+        || !file.read(result.tape.data(), static_cast<std::streamsize>(tapeSize))) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+bool ResultCache::writeFile(const ResultKey& key, const CachedResult& result) const {
+    // Written under a temporary name and renamed, so a reader never sees a partial file. Two
+    // writers of one key write the same bytes, so sharing a temporary name is harmless.
+    const std::string path = filePath(key);
+    const std::string temporary = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << FILE_TYPE << ' ' << FORMAT_VERSION << ' ' << static_cast<int>(result.status) << ' ' << result.steps << ' '
+             << result.head << ' ' << result.state.size() << ' ' << result.tape.size() << '\n'
+             << result.state << result.tape;
+        if (!file.flush()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
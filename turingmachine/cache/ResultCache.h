@@ -0,0 +1,95 @@
+/**
+ * @file ResultCache.h
+ * @brief Bounded cache of finished runs, keyed by program and input.
+ */
+#ifndef TURING_MACHINE_RESULTCACHE_H
+#define TURING_MACHINE_RESULTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "../hash/Hash.h"
+#include "../machines/TuringMachine.h"
+
+/// Identifies a run: the program and the input tape it started from.
+struct ResultKey {
+    Hash128 program;
+    Hash128 input;
+
+    bool operator==(const ResultKey& other) const { return program == other.program && input == other.input; }
+};
+
+/// Everything a finished run reports.
+struct CachedResult {
+    TuringMachine::Status status = TuringMachine::Status::Halted; ///< Halted or NoTransition.
+    std::uint64_t steps = 0;
+    std::size_t head = 0;
+    std::string state;
+    std::string tape;
+};
+
+/**
+ * @class ResultCache
+ * @brief An LRU cache of CachedResults with an optional on-disk tier.
+ *
+ * The memory tier holds at most `capacity` results and `maxBytes` of tapes and state names,
+ * evicting the least recently used. With a directory, every inserted result is also written
+ * there, one file per key, and a memory miss falls back to it, so results survive evictions
+ * and restarts and can be shared between processes. Safe to use from several threads.
+ */
+class ResultCache {
+public:
+    struct Options {
+        std::size_t capacity = 1024;
+        std::size_t maxBytes = 64 << 20;
+        std::string directory;          ///< On-disk tier; empty for memory only.
+    };
+
+    struct Stats {
+        std::uint64_t hits = 0;         ///< Lookups answered from memory.
+        std::uint64_t diskHits = 0;     ///< Lookups answered from the disk tier.
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;    ///< Results dropped from memory.
+        std::uint64_t diskWrites = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    ResultCache();
+    explicit ResultCache(Options options);
+
+    std::optional<CachedResult> find(const ResultKey& key);
+    void insert(const ResultKey& key, const CachedResult& result);
+
+    Stats getStats() const;
+
+    /// Empties the memory tier; the disk tier is kept.
+    void clear();
+
+private:
+    struct KeyHash {
+        std::size_t operator()(const ResultKey& key) const {
+            return static_cast<std::size_t>(key.program.low ^ (key.input.low * 0x9e3779b97f4a7c15ull));
+        }
+    };
+
+    using Entry = std::pair<ResultKey, CachedResult>;
+
+    std::string filePath(const ResultKey& key) const;
+    std::optional<CachedResult> readFile(const ResultKey& key) const;
+    bool writeFile(const ResultKey& key, const CachedResult& result) const;
+    void store(const ResultKey& key, const CachedResult& result);
+
+    Options options;
+    mutable std::mutex mutex;
+    std::list<Entry> entries; ///< Most recently used first.
+    std::unordered_map<ResultKey, std::list<Entry>::iterator, KeyHash> index;
+    std::size_t bytes = 0;
+    Stats stats;
+};
+
+#endif //TURING_MACHINE_RESULTCACHE_H
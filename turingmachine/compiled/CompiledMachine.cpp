@@ -0,0 +1,371 @@
+#include "CompiledMachine.h"
+#include "../trace/Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char IMAGE_MAGIC[16] = {'T', 'M', 'B', 'I', 'N', 'A', 'R', 'Y', '\n'};
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+constexpr std::size_t SYMBOL_COUNT = 256;
+
+std::uint64_t alignUp(std::uint64_t value) {
+    return (value + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+bool sectionFits(const CompiledMachine::Section& section, std::uint64_t imageSize) {
+    return section.offset % 8 == 0 && section.offset <= imageSize && section.size <= imageSize - section.offset;
+}
+
+}
+
+CompiledMachine::~CompiledMachine() {
+#if !defined(_WIN32)
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+#endif
+}
+
+std::shared_ptr<const CompiledMachine> CompiledMachine::compile(const Description& description) {
+    TM_TRACE_SCOPE("compile");
+    const auto& states = description.states;
+    const auto& haltingStates = description.haltingStates;
+    const auto& transitions = description.transitions;
+    const auto& alphabet = description.alphabet;
+    const auto& tape = description.tape;
+    std::set<std::string> names(states);
+    names.insert(haltingStates.begin(), haltingStates.end());
+    std::set<char> symbols(alphabet);
+    for (const auto& transition : transitions) {
+        names.insert(transition.first.currentState);
+        names.insert(transition.second.newState);
+        symbols.insert(transition.first.currentSymbol);
+        symbols.insert(transition.second.newSymbol);
+    }
+    std::vector<std::string> stateTable(names.begin(), names.end());
+    std::string alphabetTable(symbols.begin(), symbols.end());
+
+    // Only the sub-machines that are called are kept, indexed in name order.
+    std::map<std::string, std::shared_ptr<const CompiledMachine>> called;
+    for (const auto& transition : transitions) {
+        if (transition.second.command != 'C') {
+            continue;
+        }
+        const std::string& call = transition.second.call;
+        auto subMachine = description.subMachines.find(call);
+        if (subMachine == description.subMachines.end() || !subMachine->second) {
+            throw std::invalid_argument("Unknown sub-machine: " + call);
+        }
+        called.insert(*subMachine);
+    }
+    if (called.size() > std::numeric_limits<std::uint16_t>::max()) {
+        throw std::invalid_argument("Too many sub-machines");
+    }
+    auto calleeId = [&called](const std::string& call) {
+        return static_cast<std::uint16_t>(std::distance(called.begin(), called.find(call)));
+    };
+
+    auto stateId = [&stateTable](const std::string& name) {
+        auto it = std::lower_bound(stateTable.begin(), stateTable.end(), name);
+        return it != stateTable.end() && *it == name ? static_cast<std::uint32_t>(it - stateTable.begin()) : NO_STATE;
+    };
+
+    std::uint64_t nameBytes = 0;
+    for (const auto& name : stateTable) {
+        nameBytes += name.size();
+    }
+
+    const auto stateCount = static_cast<std::uint32_t>(stateTable.size());
+    const auto columnCount = static_cast<std::uint32_t>(alphabetTable.size() + 1);
+
+    ImageHeader header{};
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = FORMAT_VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.stateCount = stateCount;
+    header.columnCount = columnCount;
+    header.initialState = stateId(description.initialState);
+    header.initialHead = description.initialHead;
+
+    std::uint64_t offset = alignUp(sizeof(ImageHeader));
+    auto place = [&offset](Section& section, std::uint64_t size) {
+        section.offset = offset;
+        section.size = size;
+        offset = alignUp(offset + size);
+    };
+    place(header.symbolColumns, SYMBOL_COUNT * sizeof(std::uint16_t));
+    place(header.alphabet, alphabetTable.size());
+    place(header.transitions, static_cast<std::uint64_t>(stateCount) * columnCount * sizeof(CompiledTransition));
+    place(header.haltingBits, ((static_cast<std::uint64_t>(stateCount) + 63) / 64) * sizeof(std::uint64_t));
+    place(header.stateNameOffsets, (static_cast<std::uint64_t>(stateCount) + 1) * sizeof(std::uint32_t));
+    place(header.stateNames, nameBytes);
+    place(header.tape, tape.size());
+    header.imageSize = offset;
+
+    std::shared_ptr<CompiledMachine> machine(new CompiledMachine());
+    machine->ownedImage.assign(header.imageSize / sizeof(std::uint64_t), 0);
+    char* base = reinterpret_cast<char*>(machine->ownedImage.data());
+    std::memcpy(base, &header, sizeof(header));
+
+    auto* symbolColumns = reinterpret_cast<std::uint16_t*>(base + header.symbolColumns.offset);
+    std::fill(symbolColumns, symbolColumns + SYMBOL_COUNT, static_cast<std::uint16_t>(columnCount - 1));
+    for (std::size_t i = 0; i < alphabetTable.size(); ++i) {
+        symbolColumns[static_cast<unsigned char>(alphabetTable[i])] = static_cast<std::uint16_t>(i);
+    }
+    std::memcpy(base + header.alphabet.offset, alphabetTable.data(), alphabetTable.size());
+
+    auto* table = reinterpret_cast<CompiledTransition*>(base + header.transitions.offset);
+    std::fill(table, table + static_cast<std::size_t>(stateCount) * columnCount, CompiledTransition{NO_STATE, ' ', 'S', 0});
+    for (const auto& transition : transitions) {
+        std::size_t cell = static_cast<std::size_t>(stateId(transition.first.currentState)) * columnCount
+                           + symbolColumns[static_cast<unsigned char>(transition.first.currentSymbol)];
+        const RegularTuringMachine::TransitionValue& value = transition.second;
+        // A call leaves the cell as it is.
+        const bool call = value.command == 'C';
+        table[cell] = CompiledTransition{stateId(value.newState), call ? transition.first.currentSymbol : value.newSymbol,
+                                         value.command, call ? calleeId(value.call) : std::uint16_t{0}};
+    }
+
+    auto* haltingBits = reinterpret_cast<std::uint64_t*>(base + header.haltingBits.offset);
+    for (const auto& state : haltingStates) {
+        std::uint32_t id = stateId(state);
+        haltingBits[id >> 6] |= std::uint64_t{1} << (id & 63);
+    }
+
+    auto* nameOffsets = reinterpret_cast<std::uint32_t*>(base + header.stateNameOffsets.offset);
+    char* nameData = base + header.stateNames.offset;
+    std::uint32_t nameOffset = 0;
+    for (std::uint32_t i = 0; i < stateCount; ++i) {
+        nameOffsets[i] = nameOffset;
+        std::memcpy(nameData + nameOffset, stateTable[i].data(), stateTable[i].size());
+        nameOffset += static_cast<std::uint32_t>(stateTable[i].size());
+    }
+    nameOffsets[stateCount] = nameOffset;
+
+    std::memcpy(base + header.tape.offset, tape.data(), tape.size());
+
+    machine->bind(base, header.imageSize);
+    for (const auto& [name, callee] : called) {
+        machine->calleeNames.push_back(name);
+        machine->callees.push_back(callee);
+    }
+    return machine;
+}
+
+std::shared_ptr<const CompiledMachine> CompiledMachine::load(const std::string& fileName) {
+    TM_TRACE_SCOPE("load");
+    std::shared_ptr<CompiledMachine> machine(new CompiledMachine());
+#if defined(_WIN32)
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    machine->ownedImage.assign((bytes.size() + 7) / 8, 0);
+    std::memcpy(machine->ownedImage.data(), bytes.data(), bytes.size());
+    machine->bind(machine->ownedImage.data(), bytes.size());
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(ImageHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid binary machine file: " + fileName);
+    }
+    void* mapping = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Unable to map file: " + fileName);
+    }
+    machine->mapping = mapping;
+    machine->mappingSize = static_cast<std::size_t>(info.st_size);
+    try {
+        machine->bind(mapping, machine->mappingSize);
+    } catch (const std::exception& e) {
+        throw std::runtime_error(std::string(e.what()) + ": " + fileName);
+    }
+#endif
+    return machine;
+}
+
+void CompiledMachine::bind(const void* data, std::size_t size) {
+    if (size < sizeof(ImageHeader)) {
+        throw std::runtime_error("Invalid binary machine file");
+    }
+    const auto* header = static_cast<const ImageHeader*>(data);
+    if (std::memcmp(header->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0 || header->byteOrderMark != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Invalid binary machine file");
+    }
+    if (header->version != FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported binary machine format version " + std::to_string(header->version));
+    }
+
+    const std::uint64_t stateCount64 = header->stateCount;
+    bool valid = header->imageSize <= size
+                 && header->columnCount >= 1 && header->columnCount <= SYMBOL_COUNT + 1
+                 && (header->initialState < header->stateCount || header->initialState == NO_STATE)
+                 && sectionFits(header->symbolColumns, header->imageSize)
+                 && sectionFits(header->alphabet, header->imageSize)
+                 && sectionFits(header->transitions, header->imageSize)
+                 && sectionFits(header->haltingBits, header->imageSize)
+                 && sectionFits(header->stateNameOffsets, header->imageSize)
+                 && sectionFits(header->stateNames, header->imageSize)
+                 && sectionFits(header->tape, header->imageSize)
+                 && header->symbolColumns.size == SYMBOL_COUNT * sizeof(std::uint16_t)
+                 && header->alphabet.size == header->columnCount - 1
+                 && header->transitions.size == stateCount64 * header->columnCount * sizeof(CompiledTransition)
+                 && header->haltingBits.size == ((stateCount64 + 63) / 64) * sizeof(std::uint64_t)
+                 && header->stateNameOffsets.size == (stateCount64 + 1) * sizeof(std::uint32_t);
+    if (!valid) {
+        throw std::runtime_error("Corrupted binary machine file");
+    }
+
+    // Only the symbol columns are checked here, since every lookup goes through them. Transition
+    // targets and state names are checked where they are used, so the rest of a mapped image is
+    // not read until it is needed.
+    const char* base = static_cast<const char*>(data);
+    const auto* columns = reinterpret_cast<const std::uint16_t*>(base + header->symbolColumns.offset);
+    if (std::any_of(columns, columns + SYMBOL_COUNT, [header](std::uint16_t column) { return column >= header->columnCount; })) {
+        throw std::runtime_error("Corrupted binary machine file");
+    }
+
+    image = data;
+    imageSize = header->imageSize;
+    stateCount = header->stateCount;
+    columnCount = header->columnCount;
+    initialState = header->initialState;
+    initialHead = header->initialHead;
+    symbolColumns = columns;
+    alphabet = base + header->alphabet.offset;
+    transitions = reinterpret_cast<const CompiledTransition*>(base + header->transitions.offset);
+    haltingBits = reinterpret_cast<const std::uint64_t*>(base + header->haltingBits.offset);
+    stateNameOffsets = reinterpret_cast<const std::uint32_t*>(base + header->stateNameOffsets.offset);
+    stateNames = base + header->stateNames.offset;
+    stateNamesSize = header->stateNames.size;
+    tape = base + header->tape.offset;
+    tapeSize = header->tape.size;
+}
+
+CompiledMachine::Description CompiledMachine::decompile() const {
+    Description description;
+    for (std::uint32_t state = 0; state < stateCount; ++state) {
+        std::string name(getStateName(state));
+        description.states.insert(name);
+        if (isHalting(state)) {
+            description.haltingStates.insert(name);
+        }
+        for (std::uint32_t column = 0; column + 1 < columnCount; ++column) {
+            const CompiledTransition& transition = transitions[static_cast<std::size_t>(state) * columnCount + column];
+            if (transition.newState < stateCount) {
+                RegularTuringMachine::TransitionKey key{alphabet[column], name};
+                RegularTuringMachine::TransitionValue value{
+                        transition.newSymbol, std::string(getStateName(transition.newState)), transition.command};
+                if (transition.command == 'C' && transition.callee < calleeNames.size()) {
+                    value.call = calleeNames[transition.callee];
+                }
+                description.transitions[key] = value;
+            }
+        }
+    }
+    description.alphabet.insert(alphabet, alphabet + (columnCount - 1));
+    description.initialState = std::string(getStateName(initialState));
+    description.tape = std::string(getInitialTape());
+    description.initialHead = initialHead;
+    for (std::size_t i = 0; i < callees.size(); ++i) {
+        description.subMachines[calleeNames[i]] = callees[i];
+    }
+    return description;
+}
+
+void CompiledMachine::convertTextToBinary(const std::string& textFileName, const std::string& binaryFileName) {
+    std::ifstream textFile(textFileName);
+    if (!textFile.is_open()) {
+        throw std::runtime_error("Unable to open file: " + textFileName);
+    }
+
+    std::string machineType;
+    std::getline(textFile, machineType);
+    if (machineType != "REGULAR") {
+        throw std::invalid_argument("Only REGULAR machines have a binary format, got: " + machineType);
+    }
+
+    RegularTuringMachine machine;
+    machine.init(textFile);
+    machine.getProgram()->save(binaryFileName);
+}
+
+bool CompiledMachine::isBinaryFile(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    char magic[sizeof(IMAGE_MAGIC)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, IMAGE_MAGIC, sizeof(magic)) == 0;
+}
+
+void CompiledMachine::save(const std::string& fileName) const {
+    if (hasCalls()) {
+        throw std::invalid_argument("Machines calling sub-machines have no binary format");
+    }
+    std::ofstream outFile(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!outFile.is_open()) {
+        throw std::runtime_error("Unable to open or create file: " + fileName);
+    }
+    outFile.write(static_cast<const char*>(image), static_cast<std::streamsize>(imageSize));
+    if (!outFile) {
+        throw std::runtime_error("Unable to write file: " + fileName);
+    }
+}
+
+std::string_view CompiledMachine::getStateName(std::uint32_t state) const {
+    if (state >= stateCount || stateNameOffsets[state] > stateNameOffsets[state + 1]
+        || stateNameOffsets[state + 1] > stateNamesSize) {
+        return {};
+    }
+    return std::string_view(stateNames + stateNameOffsets[state], stateNameOffsets[state + 1] - stateNameOffsets[state]);
+}
+
+std::string CompiledMachine::describeTransition(std::size_t index) const {
+    if (index >= getTransitionCount()) {
+        return {};
+    }
+    const auto state = static_cast<std::uint32_t>(index / columnCount);
+    const auto column = static_cast<std::uint32_t>(index % columnCount);
+    const CompiledTransition& transition = transitions[index];
+
+    // The last column holds the symbols outside the alphabet, which have no single name.
+    std::string description = column + 1 < columnCount ? std::string(1, alphabet[column]) : std::string("*");
+    description += "{" + std::string(getStateName(state)) + "}->";
+    if (transition.newState >= stateCount) {
+        return description + "none";
+    }
+    if (transition.command == 'C') {
+        const std::string callee = transition.callee < calleeNames.size() ? calleeNames[transition.callee] : "?";
+        return description + "@" + callee + "{" + std::string(getStateName(transition.newState)) + "}";
+    }
+    return description + transition.newSymbol + "{" + std::string(getStateName(transition.newState)) + "}" + transition.command;
+}
+
+std::uint32_t CompiledMachine::findState(std::string_view name) const {
+    std::uint32_t low = 0;
+    std::uint32_t high = stateCount;
+    while (low < high) {
+        std::uint32_t middle = low + (high - low) / 2;
+        if (getStateName(middle) < name) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < stateCount && getStateName(low) == name ? low : NO_STATE;
+}
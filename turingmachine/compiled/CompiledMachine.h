@@ -0,0 +1,183 @@
+/**
+ * @file CompiledMachine.h
+ * @brief Immutable, flat representation of a regular Turing machine and its binary file format.
+ *
+ * A CompiledMachine is a single contiguous image: a header followed by the interned state
+ * table, the alphabet, a flat transition array indexed by (state, symbol column), the halting
+ * bitset, the initial tape and the initial head position. The same layout is used in memory
+ * and on disk, so a binary machine file is loaded with a single mmap and used in place.
+ */
+#ifndef TURING_MACHINE_COMPILEDMACHINE_H
+#define TURING_MACHINE_COMPILEDMACHINE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../machines/RegularTuringMachine.h"
+
+/**
+ * @struct CompiledTransition
+ * @brief One cell of the flat transition table.
+ */
+struct CompiledTransition {
+    std::uint32_t newState; ///< Target state id, or CompiledMachine::NO_STATE when no transition exists.
+    char newSymbol;         ///< The symbol to write on the tape.
+    char command;           ///< The movement command ('L', 'R' or 'S'), or 'C' to call a sub-machine.
+    std::uint16_t callee;   ///< Index of the sub-machine a 'C' transition calls, otherwise zero.
+};
+
+/**
+ * @class CompiledMachine
+ * @brief The immutable program of a regular machine.
+ *
+ * A compiled machine is never modified after it is built, so one instance can be shared by
+ * any number of executions running concurrently on different threads.
+ */
+class CompiledMachine {
+public:
+    static constexpr std::uint32_t NO_STATE = 0xFFFFFFFFu;
+    static constexpr std::uint32_t FORMAT_VERSION = 1;
+    static constexpr const char* FILE_TYPE = "TMBINARY"; ///< First line of a binary machine file.
+
+    struct Section {
+        std::uint64_t offset; ///< Byte offset from the start of the image.
+        std::uint64_t size;   ///< Size of the section in bytes.
+    };
+
+    /// The start of every image, in the byte order of the machine that wrote it.
+    struct ImageHeader {
+        char magic[16];
+        std::uint32_t version;
+        std::uint32_t byteOrderMark;
+        std::uint32_t stateCount;
+        std::uint32_t columnCount;   ///< Alphabet size plus one column for symbols outside the alphabet.
+        std::uint32_t initialState;
+        std::uint32_t reserved;
+        std::uint64_t initialHead;
+        std::uint64_t imageSize;
+        Section symbolColumns;       ///< uint16_t[256], maps a tape symbol to its column.
+        Section alphabet;            ///< char[columnCount - 1]
+        Section transitions;         ///< CompiledTransition[stateCount * columnCount]
+        Section haltingBits;         ///< uint64_t[(stateCount + 63) / 64]
+        Section stateNameOffsets;    ///< uint32_t[stateCount + 1] into stateNames
+        Section stateNames;          ///< Sorted, concatenated state names.
+        Section tape;                ///< char[], the initial tape.
+    };
+
+    /// The textual description a machine is compiled from.
+    struct Description {
+        std::set<std::string> states;
+        std::set<std::string> haltingStates;
+        std::unordered_map<RegularTuringMachine::TransitionKey, RegularTuringMachine::TransitionValue, RegularTuringMachine::TransitionKeyHash> transitions;
+        std::set<char> alphabet;
+        std::string initialState;
+        std::string tape;
+        std::uint64_t initialHead = 0;
+        /// Compiled sub-machines, by the name call transitions use; shared with other callers.
+        std::map<std::string, std::shared_ptr<const CompiledMachine>> subMachines;
+    };
+
+    CompiledMachine(const CompiledMachine&) = delete;
+    CompiledMachine& operator=(const CompiledMachine&) = delete;
+    ~CompiledMachine();
+
+    /**
+     * Builds an in-memory image from the parsed description of a regular machine.
+     * Every state named by a transition or by the halting set is interned; names are
+     * sorted so that lookups by name are a binary search over the image.
+     */
+    static std::shared_ptr<const CompiledMachine> compile(const Description& description);
+
+    /// Rebuilds the description this machine was compiled from.
+    Description decompile() const;
+
+    /// Maps a binary machine file produced by save() and validates its header; the tables are
+    /// used in place, and transitions or names pointing outside the image read as missing.
+    /// Binary files hold no sub-machines; call transitions of a loaded file never resolve.
+    static std::shared_ptr<const CompiledMachine> load(const std::string& fileName);
+
+    /// Parses a REGULAR text description and writes it in the binary format.
+    static void convertTextToBinary(const std::string& textFileName, const std::string& binaryFileName);
+
+    static bool isBinaryFile(const std::string& fileName);
+
+    /// Writes the image as a binary machine file; throws for machines that call sub-machines.
+    void save(const std::string& fileName) const;
+
+    std::uint32_t getStateCount() const { return stateCount; }
+    std::uint32_t getInitialState() const { return initialState; }
+    std::uint64_t getInitialHead() const { return initialHead; }
+    std::string_view getInitialTape() const { return std::string_view(tape, tapeSize); }
+    std::string_view getAlphabet() const { return std::string_view(alphabet, columnCount - 1); }
+
+    /// The sub-machine a call transition names, or nullptr for an index out of range.
+    const CompiledMachine* getCallee(std::uint16_t index) const {
+        return index < callees.size() ? callees[index].get() : nullptr;
+    }
+    bool hasCalls() const { return !callees.empty(); }
+    std::size_t getCalleeCount() const { return callees.size(); }
+
+    /// Empty for a state out of range, or one whose name lies outside the image.
+    std::string_view getStateName(std::uint32_t state) const;
+    std::uint32_t findState(std::string_view name) const;
+
+    bool isHalting(std::uint32_t state) const {
+        return (haltingBits[state >> 6] >> (state & 63)) & 1u;
+    }
+
+    const CompiledTransition& lookup(std::uint32_t state, char symbol) const {
+        return transitions[static_cast<std::size_t>(state) * columnCount + symbolColumns[static_cast<unsigned char>(symbol)]];
+    }
+
+    std::uint32_t getColumnCount() const { return columnCount; }
+    std::size_t getTransitionCount() const { return static_cast<std::size_t>(stateCount) * columnCount; }
+
+    /// Position of a transition returned by lookup() in the flat table.
+    std::size_t transitionIndex(const CompiledTransition& transition) const {
+        return static_cast<std::size_t>(&transition - transitions);
+    }
+
+    const CompiledTransition& transitionAt(std::size_t index) const { return transitions[index]; }
+
+    /// The transition at an index of the flat table in the text format, e.g. "0{q}->1{r}R".
+    std::string describeTransition(std::size_t index) const;
+
+    const void* data() const { return image; }
+    std::size_t size() const { return imageSize; }
+
+private:
+    CompiledMachine() = default;
+
+    void bind(const void* image, std::size_t imageSize);
+
+    std::vector<std::uint64_t> ownedImage; ///< Backing storage for machines compiled in memory.
+    void* mapping = nullptr;               ///< Backing mapping for machines loaded from a file.
+    std::size_t mappingSize = 0;
+
+    std::vector<std::shared_ptr<const CompiledMachine>> callees; ///< Sub-machines, by call index.
+    std::vector<std::string> calleeNames;                        ///< Their names, sorted.
+
+    const void* image = nullptr;
+    std::size_t imageSize = 0;
+
+    std::uint32_t stateCount = 0;
+    std::uint32_t columnCount = 0;
+    std::uint32_t initialState = NO_STATE;
+    std::uint64_t initialHead = 0;
+    const std::uint16_t* symbolColumns = nullptr;
+    const char* alphabet = nullptr;
+    const CompiledTransition* transitions = nullptr;
+    const std::uint64_t* haltingBits = nullptr;
+    const std::uint32_t* stateNameOffsets = nullptr;
+    const char* stateNames = nullptr;
+    std::uint64_t stateNamesSize = 0;
+    const char* tape = nullptr;
+    std::uint64_t tapeSize = 0;
+};
+
+#endif //TURING_MACHINE_COMPILEDMACHINE_H
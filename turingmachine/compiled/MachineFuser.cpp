@@ -0,0 +1,210 @@
+#include <functional>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include "MachineFuser.h"
+#include "../machines/CompositionTuringMachine.h"
+#include "../machines/ConditionalTuringMachine.h"
+#include "../machines/GraphTuringMachine.h"
+#include "../machines/IterationTuringMachine.h"
+#include "../machines/PipelineTuringMachine.h"
+#include "../machines/RegularTuringMachine.h"
+#include "../tape/Tape.h"
+
+namespace {
+
+constexpr int HALT = -1;
+const char* const HALT_STATE = "halt";
+
+}
+
+/// One stage of a composite and the stage that follows it, by the symbol under the head.
+struct MachineFuser::Stage {
+    CompiledMachine::Description description;
+    std::function<int(const std::string&, char)> next; ///< Next stage by halting state and symbol, or HALT.
+};
+
+/// Builds the fused description; stages are the states' "<stage>:" prefix.
+class MachineFuser::Fusion {
+public:
+    Fusion(std::vector<Stage> stages, const TuringMachine& machine) : stages(std::move(stages)) {
+        for (const Stage& stage : this->stages) {
+            fused.alphabet.insert(stage.description.alphabet.begin(), stage.description.alphabet.end());
+            for (const auto& [key, value] : stage.description.transitions) {
+                fused.alphabet.insert(key.currentSymbol);
+                fused.alphabet.insert(value.newSymbol);
+            }
+        }
+        // Dispatch rows cover every symbol that can be under the head.
+        fused.alphabet.insert(Tape::BLANK);
+        const std::string tape = machine.getOutput();
+        fused.alphabet.insert(tape.begin(), tape.end());
+        fused.haltingStates.insert(HALT_STATE);
+        fused.states.insert(HALT_STATE);
+        fused.tape = tape;
+        fused.initialHead = machine.getHeadPosition();
+    }
+
+    CompiledMachine::Description build() {
+        for (std::size_t index = 0; index < stages.size(); ++index) {
+            const CompiledMachine::Description& description = stages[index].description;
+            for (const auto& [key, value] : description.transitions) {
+                if (description.haltingStates.count(key.currentState) != 0) {
+                    continue; // A stage stops as soon as it enters a halting state.
+                }
+                fused.transitions[{key.currentSymbol, name(index, key.currentState)}] =
+                        RegularTuringMachine::TransitionValue{value.newSymbol, target(index, value.newState), value.command};
+            }
+        }
+        fused.initialState = entry("start", [](char) { return 0; });
+        for (const auto& [key, value] : fused.transitions) {
+            fused.states.insert(key.currentState);
+            fused.states.insert(value.newState);
+        }
+        fused.states.insert(fused.initialState);
+        return fused;
+    }
+
+private:
+    static std::string name(std::size_t stage, const std::string& state) {
+        return std::to_string(stage) + ":" + state;
+    }
+
+    bool startsHalted(int stage) const {
+        const CompiledMachine::Description& description = stages[static_cast<std::size_t>(stage)].description;
+        return description.haltingStates.count(description.initialState) != 0;
+    }
+
+    /// The first stage to take a step with `symbol` under the head, skipping stages that halt at once.
+    int resolve(int stage, char symbol) const {
+        for (std::size_t hops = 0; stage != HALT && startsHalted(stage); ++hops) {
+            if (hops > stages.size()) {
+                throw std::invalid_argument("Stages hand over to each other forever without taking a step");
+            }
+            const Stage& halted = stages[static_cast<std::size_t>(stage)];
+            stage = halted.next(halted.description.initialState, symbol);
+        }
+        return stage;
+    }
+
+    /// Where a transition of `stage` into `state` goes in the fused machine.
+    std::string target(std::size_t stage, const std::string& state) {
+        if (stages[stage].description.haltingStates.count(state) == 0) {
+            return name(stage, state);
+        }
+        auto known = exits.find({stage, state});
+        if (known != exits.end()) {
+            return known->second;
+        }
+        const std::string dispatch = "exit" + name(stage, state);
+        return entry(dispatch, [this, stage, &state](char symbol) { return stages[stage].next(state, symbol); },
+                     [this, stage, &state, &dispatch]() {
+            exits[{stage, state}] = dispatch; // Before the row is built, since the row may lead back here.
+        });
+    }
+
+    /**
+     * The state entering the stage chosen by `choose` for the symbol under the head: that
+     * stage's initial state when the choice does not depend on the symbol, otherwise a new
+     * dispatch state called `dispatch`, announced through `onDispatch` before its row is built.
+     */
+    std::string entry(const std::string& dispatch, const std::function<int(char)>& choose,
+                      const std::function<void()>& onDispatch = {}) {
+        std::map<char, int> chosen;
+        for (char symbol : fused.alphabet) {
+            chosen[symbol] = resolve(choose(symbol), symbol);
+        }
+        const int first = chosen.begin()->second;
+        bool uniform = true;
+        for (const auto& [symbol, stage] : chosen) {
+            uniform = uniform && stage == first;
+        }
+        if (uniform && first == HALT) {
+            return HALT_STATE;
+        }
+        if (uniform) {
+            return name(static_cast<std::size_t>(first), stages[static_cast<std::size_t>(first)].description.initialState);
+        }
+
+        if (onDispatch) {
+            onDispatch();
+        }
+        for (const auto& [symbol, stage] : chosen) {
+            if (stage == HALT) {
+                fused.transitions[{symbol, dispatch}] = RegularTuringMachine::TransitionValue{symbol, HALT_STATE, 'S'};
+                continue;
+            }
+            const CompiledMachine::Description& description = stages[static_cast<std::size_t>(stage)].description;
+            auto transition = description.transitions.find({symbol, description.initialState});
+            if (transition != description.transitions.end()) {
+                const RegularTuringMachine::TransitionValue& value = transition->second;
+                fused.transitions[{symbol, dispatch}] = RegularTuringMachine::TransitionValue{
+                        value.newSymbol, target(static_cast<std::size_t>(stage), value.newState), value.command};
+            }
+        }
+        return dispatch;
+    }
+
+    std::vector<Stage> stages;
+    CompiledMachine::Description fused;
+    std::map<std::pair<std::size_t, std::string>, std::string> exits; ///< Dispatch states built for stage exits.
+};
+
+std::vector<MachineFuser::Stage> MachineFuser::stagesOf(const TuringMachine& machine) {
+    auto describe = [](const RegularTuringMachine& stage) { return stage.getProgram()->decompile(); };
+    std::vector<Stage> stages;
+    if (auto* regular = dynamic_cast<const RegularTuringMachine*>(&machine)) {
+        stages.push_back({describe(*regular), [](const std::string&, char) { return HALT; }});
+    } else if (auto* composition = dynamic_cast<const CompositionTuringMachine*>(&machine)) {
+        stages.push_back({describe(*composition->machine1), [](const std::string&, char) { return 1; }});
+        stages.push_back({describe(*composition->machine2), [](const std::string&, char) { return HALT; }});
+    } else if (auto* pipeline = dynamic_cast<const PipelineTuringMachine*>(&machine)) {
+        const int count = static_cast<int>(pipeline->stages.size());
+        for (int index = 0; index < count; ++index) {
+            stages.push_back({pipeline->stages[static_cast<std::size_t>(index)]->decompile(),
+                              [index, count](const std::string&, char) { return index + 1 < count ? index + 1 : HALT; }});
+        }
+    } else if (auto* conditional = dynamic_cast<const ConditionalCompositionTuringMachine*>(&machine)) {
+        std::set<char> symbols = conditional->conditionalSymbols;
+        stages.push_back({describe(*conditional->machine1), [symbols](const std::string&, char symbol) { return symbols.count(symbol) != 0 ? 1 : 2; }});
+        stages.push_back({describe(*conditional->machine2), [](const std::string&, char) { return HALT; }});
+        stages.push_back({describe(*conditional->machine3), [](const std::string&, char) { return HALT; }});
+    } else if (auto* loop = dynamic_cast<const IterationLoopTuringMachine*>(&machine)) {
+        const char condition = loop->loopConditionSymbol;
+        stages.push_back({describe(*loop->loopMachine), [condition](const std::string&, char symbol) { return symbol == condition ? 0 : HALT; }});
+    } else if (auto* graph = dynamic_cast<const GraphTuringMachine*>(&machine)) {
+        for (const GraphTuringMachine::Node& node : graph->nodes) {
+            // Edges are tried in order, as GraphTuringMachine::next() does.
+            std::vector<std::tuple<std::optional<std::string>, std::optional<char>, int>> edges;
+            for (const GraphTuringMachine::Edge& edge : node.edges) {
+                std::optional<std::string> state;
+                if (edge.state != CompiledMachine::NO_STATE) {
+                    state = std::string(node.program->getStateName(edge.state));
+                }
+                edges.emplace_back(state, edge.symbol, static_cast<int>(edge.to));
+            }
+            stages.push_back({node.program->decompile(), [edges](const std::string& halted, char symbol) {
+                for (const auto& [state, guard, to] : edges) {
+                    if ((!state || *state == halted) && (!guard || *guard == symbol)) {
+                        return to;
+                    }
+                }
+                return HALT;
+            }});
+        }
+    } else {
+        throw std::invalid_argument("Only REGULAR, COMPOSITION, CONDITIONAL, LOOP, PIPELINE and GRAPH machines can be fused");
+    }
+    for (const Stage& stage : stages) {
+        if (!stage.description.subMachines.empty()) {
+            throw std::invalid_argument("Machines calling sub-machines cannot be fused");
+        }
+    }
+    return stages;
+}
+
+std::shared_ptr<const CompiledMachine> MachineFuser::fuse(const TuringMachine& machine) {
+    return CompiledMachine::compile(Fusion(stagesOf(machine), machine).build());
+}
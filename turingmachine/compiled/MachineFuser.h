@@ -0,0 +1,50 @@
+/**
+ * @file MachineFuser.h
+ * @brief Flattens composite machines into a single compiled regular machine.
+ */
+#ifndef TURING_MACHINE_MACHINEFUSER_H
+#define TURING_MACHINE_MACHINEFUSER_H
+
+#include <memory>
+#include <vector>
+#include "CompiledMachine.h"
+#include "../machines/TuringMachine.h"
+
+/**
+ * @class MachineFuser
+ * @brief Merges the stages of a composite machine into one transition graph.
+ *
+ * The states of every stage are renamed "<stage>:<state>". Transitions into a stage's halting
+ * states are rewired to where the composite would go next. If the next stage depends on
+ * the halting state or on the symbol under the head (a CONDITIONAL branch, a LOOP test or a
+ * guarded GRAPH edge), they go to a dispatch state. That state does not act itself: on each symbol it makes the move of the stage
+ * selected by that symbol. The fused machine therefore runs on the single-machine engine
+ * and takes the same steps as the composite, with these exceptions:
+ *
+ * - Ending at a dispatch state costs one step, into the single halting state "halt".
+ * - A stage that has no transition ends the fused run with NoTransition, as in a GRAPH; the
+ *   other composites go on with the next stage.
+ * - A LOOP becomes a back edge to the loop machine. IterationLoopTuringMachine gives its
+ *   post-loop machine a copy of the tape and then discards it, so the post-loop machine
+ *   cannot change the result and is left out. The fused loop takes fewer steps but leaves
+ *   the same tape and head, provided the post-loop machine halts.
+ */
+class MachineFuser {
+public:
+    /**
+     * Compiles a REGULAR, COMPOSITION, CONDITIONAL, LOOP, PIPELINE or GRAPH machine into one program
+     * starting on the machine's current tape and head. Throws std::invalid_argument for other
+     * machines, for stages that call sub-machines and for stages that would hand over to each
+     * other forever without a step.
+     */
+    static std::shared_ptr<const CompiledMachine> fuse(const TuringMachine& machine);
+
+private:
+    struct Stage;
+    class Fusion;
+
+    /// Splits a composite into its stages, reading its private members.
+    static std::vector<Stage> stagesOf(const TuringMachine& machine);
+};
+
+#endif //TURING_MACHINE_MACHINEFUSER_H
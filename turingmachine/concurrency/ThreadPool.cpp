@@ -0,0 +1,57 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && running == 0; });
+}
+
+void ThreadPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+            return; // Stopping, and every queued task has run.
+        }
+
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        ++running;
+        lock.unlock();
+        task();
+        lock.lock();
+        --running;
+        if (tasks.empty() && running == 0) {
+            idle.notify_all();
+        }
+    }
+}
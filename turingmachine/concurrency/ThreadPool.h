@@ -0,0 +1,49 @@
+/**
+ * @file ThreadPool.h
+ * @brief Fixed-size pool of worker threads running queued tasks in submission order.
+ */
+#ifndef TURING_MACHINE_THREADPOOL_H
+#define TURING_MACHINE_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Runs tasks on a fixed set of threads; the destructor finishes every queued task.
+ */
+class ThreadPool {
+public:
+    /// Starts `threads` workers, or one per hardware thread when threads is 0.
+    explicit ThreadPool(std::size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Queues a task. Tasks must not throw; an escaping exception terminates the process.
+    void submit(std::function<void()> task);
+
+    /// Blocks until the queue is empty and no task is running.
+    void wait();
+
+    std::size_t size() const { return workers.size(); }
+
+private:
+    void work();
+
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable idle;
+    std::deque<std::function<void()>> tasks;
+    std::size_t running = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif //TURING_MACHINE_THREADPOOL_H
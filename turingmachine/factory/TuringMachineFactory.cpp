@@ -1,40 +1,199 @@
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <sstream>
 #include "TuringMachineFactory.h"
 #include "../machines/RegularTuringMachine.h"
 #include "../machines/CompositionTuringMachine.h"
 #include "../machines/ConditionalTuringMachine.h"
 #include "../machines/IterationTuringMachine.h"
+#include "../machines/PipelineTuringMachine.h"
+#include "../machines/GraphTuringMachine.h"
 #include "../multitape/MultitapeTuringMachine.h"
+#include "../compiled/CompiledMachine.h"
+#include "../cache/CachedTuringMachine.h"
+#include "../hash/Hash.h"
+#include "../registry/ProgramRegistry.h"
+#include "../trace/Trace.h"
+
+namespace {
+
+void appendHash(std::string& hashes, std::string_view bytes) {
+    const Hash128 hash = hash128(bytes);
+    hashes.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+}
+
+/// Hashes a program without its initial tape, which the input hash covers, so that files that
+/// differ only in their tape share results.
+Hash128 imageHash(const CompiledMachine& program) {
+    const std::uint64_t fields[] = {program.getStateCount(), program.getColumnCount(), program.getInitialState(),
+                                    program.getInitialHead()};
+    std::string states;
+    for (std::uint32_t state = 0; state < program.getStateCount(); ++state) {
+        states += program.getStateName(state);
+        states += program.isHalting(state) ? '\1' : '\0';
+    }
+    std::string hashes;
+    appendHash(hashes, std::string_view(reinterpret_cast<const char*>(fields), sizeof(fields)));
+    appendHash(hashes, program.getAlphabet());
+    appendHash(hashes, std::string_view(reinterpret_cast<const char*>(&program.transitionAt(0)),
+                                        program.getTransitionCount() * sizeof(CompiledTransition)));
+    appendHash(hashes, states);
+    return hash128(hashes);
+}
+
+/// Appends the image hashes of a program and of the sub-machines it calls, callees first.
+void appendImageHashes(const CompiledMachine& program, std::string& hashes) {
+    for (std::uint16_t i = 0; i < program.getCalleeCount(); ++i) {
+        appendImageHashes(*program.getCallee(i), hashes);
+    }
+    const Hash128 hash = imageHash(program);
+    hashes.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+}
+
+/**
+ * Identifies what a machine computes. A regular machine without calls is its program, so
+ * identical programs share results whatever file they come from. Otherwise the images of
+ * every program run, sub-machines and components included, are hashed together; for
+ * composites with the description, which holds how the components are put together.
+ */
+Hash128 hashPrograms(const TuringMachine& machine, const std::string& content) {
+    auto* regular = dynamic_cast<const RegularTuringMachine*>(&machine);
+    if (regular && !regular->getProgram()->hasCalls()) {
+        return imageHash(*regular->getProgram());
+    }
+    std::string hashes;
+    if (!regular) {
+        const Hash128 description = hash128(content);
+        hashes.append(reinterpret_cast<const char*>(&description), sizeof(description));
+    }
+    machine.forEachProgram([&hashes](const CompiledMachine& program) {
+        appendImageHashes(program, hashes);
+    });
+    return hash128(hashes);
+}
+
+}
 
 TuringMachineFactory::TuringMachineFactory() = default;
 
-TuringMachine* TuringMachineFactory::getMachine(const std::string &fileName) {
-    std::ifstream tmData(fileName);
+std::unique_ptr<TuringMachine> TuringMachineFactory::getMachine(const std::string &fileName) {
+    TM_TRACE_SCOPE("getMachine");
+    std::error_code error;
+    auto modificationTime = std::filesystem::last_write_time(fileName, error);
+    auto fileSize = error ? 0 : std::filesystem::file_size(fileName, error);
+    if (error) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(fileName);
+        if (it != cache.end() && it->second.modificationTime == modificationTime && it->second.fileSize == fileSize
+            && ProgramRegistry::isCurrent(it->second.references)) {
+            return instantiate(it->second);
+        }
+    }
+
+    std::ifstream tmData(fileName, std::ios::binary);
     if (!tmData.is_open()) {
         throw std::runtime_error("Unable to open file: " + fileName);
     }
+    std::string machineType;
+    std::getline(tmData, machineType);
+
+    std::shared_ptr<const TuringMachine> prototype;
+    std::vector<ProgramRegistry::FileVersion> references;
+    std::string content;
+    std::uint64_t contentHash = 0;
+    if (machineType == CompiledMachine::FILE_TYPE) {
+        // Compiled images are mapped by load() rather than read here, so they are checked by time and size only.
+        tmData.close();
+        prototype = std::make_shared<RegularTuringMachine>(CompiledMachine::load(fileName));
+    } else {
+        tmData.clear();
+        tmData.seekg(0);
+        content.assign(std::istreambuf_iterator<char>(tmData), std::istreambuf_iterator<char>());
+        contentHash = fnv1a64(content);
+        {
+            // The file was touched but its content may be unchanged.
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            auto it = cache.find(fileName);
+            if (it != cache.end() && it->second.contentHash == contentHash && it->second.fileSize == content.size()
+                && ProgramRegistry::isCurrent(it->second.references)) {
+                it->second.modificationTime = modificationTime;
+                return instantiate(it->second);
+            }
+        }
+
+        ProgramRegistry::FileRecorder recorder;
+        prototype = createPrototype(fileName, content);
+        references = recorder.getFiles();
+    }
+
+    Hash128 programHash = hashPrograms(*prototype, content);
+    Hash128 inputHash = hash128(prototype->getOutput());
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    CacheEntry& entry = cache[fileName];
+    entry = CacheEntry{modificationTime, fileSize, contentHash, std::move(references), prototype, programHash, inputHash};
+    return instantiate(entry);
+}
+
+std::unique_ptr<TuringMachine> TuringMachineFactory::instantiate(const CacheEntry& entry) const {
+    if (!resultCache) {
+        return entry.prototype->clone();
+    }
+    return std::make_unique<CachedTuringMachine>(entry.prototype->clone(), resultCache, entry.programHash, entry.inputHash);
+}
+
+void TuringMachineFactory::setResultCache(std::shared_ptr<ResultCache> cache) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    resultCache = std::move(cache);
+}
+
+std::shared_ptr<ResultCache> TuringMachineFactory::getResultCache() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return resultCache;
+}
+
+std::shared_ptr<const TuringMachine> TuringMachineFactory::createPrototype(const std::string& fileName, const std::string& content) {
+    std::istringstream tmData(content);
 
     std::string machineType;
     std::getline(tmData, machineType);
 
-    TuringMachine* machine = new RegularTuringMachine();
+    std::shared_ptr<TuringMachine> machine;
 
     if(machineType == "REGULAR"){
-        machine = new RegularTuringMachine();
+        machine = std::make_shared<RegularTuringMachine>();
     } else if (machineType == "COMPOSITION"){
-        machine = new CompositionTuringMachine();
+        machine = std::make_shared<CompositionTuringMachine>();
     } else if (machineType == "CONDITIONAL"){
-        machine = new ConditionalCompositionTuringMachine();
+        machine = std::make_shared<ConditionalCompositionTuringMachine>();
     } else if (machineType == "LOOP"){
-        machine = new IterationLoopTuringMachine();
+        machine = std::make_shared<IterationLoopTuringMachine>();
+    } else if (machineType == "PIPELINE"){
+        machine = std::make_shared<PipelineTuringMachine>();
+    } else if (machineType == "GRAPH"){
+        machine = std::make_shared<GraphTuringMachine>();
     } else if (machineType == "MULTITAPE"){
-        machine = new MultiTapeTuringMachine();
+        machine = std::make_shared<MultiTapeTuringMachine>();
     } else {
         throw std::invalid_argument("Invalid machine type: " + machineType);
     }
 
-    machine->init(tmData);
+    machine->initFromFile(tmData, std::filesystem::path(fileName).parent_path().string());
 
     return machine;
 }
+
+void TuringMachineFactory::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.clear();
+}
+
+std::size_t TuringMachineFactory::getCacheSize() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return cache.size();
+}
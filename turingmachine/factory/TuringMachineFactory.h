@@ -2,15 +2,63 @@
 #ifndef TURING_MACHINE_TURINGMACHINEFACTORY_H
 #define TURING_MACHINE_TURINGMACHINEFACTORY_H
 
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "../machines/RegularTuringMachine.h"
+#include "../cache/ResultCache.h"
+#include "../registry/ProgramRegistry.h"
 
+/**
+ * @class TuringMachineFactory
+ * @brief Creates machines from description files and caches their compiled programs.
+ *
+ * The first request for a file parses it into a prototype machine that is kept for the
+ * lifetime of the factory. Later requests return clones of the prototype, which share its
+ * compiled program and own only their tape and execution state. A cached prototype is
+ * reused while the file's modification time and size are unchanged, or, when they change,
+ * while its content hash still matches, and only while the files its USE lines read, directly
+ * or through other files, are unchanged as well.
+ *
+ * With a ResultCache set, machines come wrapped in a CachedTuringMachine, so runs repeated
+ * with the same program and input are answered from the cache.
+ */
 class TuringMachineFactory {
 public:
 
     TuringMachineFactory();
 
-    TuringMachine* getMachine(const std::string& fileName);
+    std::unique_ptr<TuringMachine> getMachine(const std::string& fileName);
+
+    void clearCache();
+    std::size_t getCacheSize() const;
+
+    /// Puts a result cache in front of the machines created from now on; null removes it.
+    void setResultCache(std::shared_ptr<ResultCache> resultCache);
+    std::shared_ptr<ResultCache> getResultCache() const;
+
+private:
+    struct CacheEntry {
+        std::filesystem::file_time_type modificationTime;
+        std::uintmax_t fileSize;
+        std::uint64_t contentHash; ///< Of the description; 0 for compiled images, which are not read.
+        std::vector<ProgramRegistry::FileVersion> references; ///< Files read for its USE lines.
+        std::shared_ptr<const TuringMachine> prototype;
+        Hash128 programHash; ///< The compiled images of the machine and its components, and the description of composites.
+        Hash128 inputHash;   ///< The tape of the description.
+    };
+
+    std::unique_ptr<TuringMachine> instantiate(const CacheEntry& entry) const;
+
+    static std::shared_ptr<const TuringMachine> createPrototype(const std::string& fileName, const std::string& content);
+
+    mutable std::mutex cacheMutex;
+    std::unordered_map<std::string, CacheEntry> cache;
+    std::shared_ptr<ResultCache> resultCache;
 };
 
 
@@ -0,0 +1,460 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include "WorkloadGenerator.h"
+
+namespace {
+
+const std::string SYMBOLS = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const char FULL = '+';  ///< An unused pass on the counter at the start of the tape.
+const char USED = '-';  ///< A pass already taken.
+const char BLANK = ' ';
+const char START = '>';
+const std::uint64_t MAX_SIZE = std::uint64_t(1) << 30;
+
+struct BusyBeaverRule {
+    char write;
+    char move;
+    char next; ///< 'h' halts.
+};
+
+/// Champions for 2 to 5 states, indexed by [state][symbol read].
+struct BusyBeaver {
+    std::size_t states;
+    std::uint64_t steps;
+    std::uint64_t leftRoom; ///< Cells the head travels left of its starting cell.
+    BusyBeaverRule rules[5][2];
+};
+
+const BusyBeaver BUSY_BEAVERS[] = {
+        {2, 6, 2, {{{'1', 'R', 'b'}, {'1', 'L', 'b'}}, {{'1', 'L', 'a'}, {'1', 'R', 'h'}}}},
+        {3, 21, 1, {{{'1', 'R', 'b'}, {'1', 'R', 'h'}}, {{'1', 'L', 'b'}, {'0', 'R', 'c'}}, {{'1', 'L', 'c'}, {'1', 'L', 'a'}}}},
+        {4, 107, 10, {{{'1', 'R', 'b'}, {'1', 'L', 'b'}}, {{'1', 'L', 'a'}, {'0', 'L', 'c'}}, {{'1', 'R', 'h'}, {'1', 'L', 'd'}}, {{'1', 'R', 'd'}, {'0', 'R', 'a'}}}},
+        {5, 47176870, 12243, {{{'1', 'R', 'b'}, {'1', 'L', 'c'}}, {{'1', 'R', 'c'}, {'1', 'R', 'b'}}, {{'1', 'R', 'd'}, {'0', 'L', 'e'}}, {{'1', 'L', 'a'}, {'1', 'L', 'd'}}, {{'1', 'R', 'h'}, {'0', 'L', 'a'}}}},
+};
+
+void transition(std::ostream& out, char symbol, const std::string& state, char newSymbol, const std::string& newState, char command) {
+    out << symbol << '{' << state << "}->" << newSymbol << '{' << newState << '}' << command << '\n';
+}
+
+std::string dataSymbols(const WorkloadGenerator::Parameters& parameters) {
+    if (parameters.alphabetSize == 0 || parameters.alphabetSize > SYMBOLS.size()) {
+        throw std::invalid_argument("Alphabet size must be between 1 and " + std::to_string(SYMBOLS.size()));
+    }
+    return SYMBOLS.substr(0, parameters.alphabetSize);
+}
+
+std::string randomData(const std::string& symbols, std::size_t length, std::uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<std::size_t> pick(0, symbols.size() - 1);
+    std::string data(length, symbols[0]);
+    for (char& cell : data) {
+        cell = symbols[pick(random)];
+    }
+    return data;
+}
+
+/// The smallest size in [low, MAX_SIZE] whose step count reaches the target.
+template<typename StepCount>
+std::uint64_t smallestSize(std::uint64_t low, std::uint64_t target, StepCount steps) {
+    std::uint64_t high = MAX_SIZE;
+    while (low < high) {
+        std::uint64_t middle = low + (high - low) / 2;
+        if (steps(middle) >= target) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+std::size_t workingStates(const WorkloadGenerator::Parameters& parameters) {
+    if (parameters.states == 0) {
+        throw std::invalid_argument("A workload needs at least one working state");
+    }
+    return parameters.states;
+}
+
+std::string workingState(std::size_t index) {
+    return "r" + std::to_string(index);
+}
+
+/// The working state after reading a symbol, spread so that a sweep visits the whole table.
+std::size_t nextWorkingState(std::size_t state, std::size_t symbol, std::size_t stateCount) {
+    return (state * 31 + symbol + 1) % stateCount;
+}
+
+/**
+ * Sweeps right over the counter and the data, rewriting every data symbol, then turns on the
+ * blank, uses up one pass of the counter on the way back and starts over. Halts on '>' once
+ * the counter is used up, after 2(C+1)(C+L+1) steps for C passes and L data cells.
+ */
+void sweepingMachine(std::ostream& out, const std::string& symbols, std::size_t stateCount) {
+    for (std::size_t state = 0; state < stateCount; ++state) {
+        for (std::size_t symbol = 0; symbol < symbols.size(); ++symbol) {
+            transition(out, symbols[symbol], workingState(state), symbols[(symbol + 1) % symbols.size()],
+                       workingState(nextWorkingState(state, symbol, stateCount)), 'R');
+        }
+        transition(out, FULL, workingState(state), FULL, workingState(state), 'R');
+        transition(out, USED, workingState(state), USED, workingState(state), 'R');
+        transition(out, BLANK, workingState(state), BLANK, "back", 'L');
+    }
+    for (char symbol : symbols) {
+        transition(out, symbol, "back", symbol, "back", 'L');
+    }
+    transition(out, USED, "back", USED, "back", 'L');
+    transition(out, FULL, "back", USED, "home", 'L');
+    transition(out, START, "back", START, "halt", 'S');
+    transition(out, FULL, "home", FULL, "home", 'L');
+    transition(out, START, "home", START, workingState(0), 'R');
+    out << "1\nhalt\n";
+}
+
+/// One pass from '>' to the first blank that re-arms the counter; C+L+2 steps.
+void finishingMachine(std::ostream& out, const std::string& symbols, std::size_t shift) {
+    transition(out, START, "p", START, "p", 'R');
+    transition(out, USED, "p", FULL, "p", 'R');
+    transition(out, FULL, "p", FULL, "p", 'R');
+    for (std::size_t symbol = 0; symbol < symbols.size(); ++symbol) {
+        transition(out, symbols[symbol], "p", symbols[(symbol + shift) % symbols.size()], "p", 'R');
+    }
+    transition(out, BLANK, "p", BLANK, "halt", 'S');
+    out << "1\nhalt\n";
+}
+
+std::uint64_t sweepSteps(std::uint64_t passes, std::uint64_t length) {
+    return 2 * (passes + 1) * (passes + length + 1);
+}
+
+/// Steps of the sweeping machine, followed by the finishing pass when there is one.
+std::uint64_t totalSweepSteps(std::uint64_t passes, std::uint64_t length, bool finishing) {
+    return sweepSteps(passes, length) + (finishing ? passes + length + 2 : 0);
+}
+
+std::uint64_t sweepPasses(const WorkloadGenerator::Parameters& parameters, bool finishing) {
+    if (parameters.steps == 0) {
+        return 0;
+    }
+    return smallestSize(0, parameters.steps, [&](std::uint64_t passes) {
+        return totalSweepSteps(passes, parameters.tapeLength, finishing);
+    });
+}
+
+std::string sweepTape(const WorkloadGenerator::Parameters& parameters, const std::string& symbols, std::uint64_t passes) {
+    return std::string(1, START) + std::string(passes, FULL) + randomData(symbols, parameters.tapeLength, parameters.seed) + "\n";
+}
+
+std::uint64_t multiplicationSteps(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t steps = 1;
+    for (std::uint64_t i = 0; i < a; ++i) {
+        steps += 2 * (a - i) + 3 + b + b * (2 * b + 2 * i * b + 3);
+    }
+    return steps;
+}
+
+/// Each round over m unmarked cells takes 2m+1 steps; the last one takes 1 or 3.
+std::uint64_t palindromeSteps(std::uint64_t length) {
+    std::uint64_t rounds = length / 2;
+    std::uint64_t smallest = length % 2 ? 3 : 2;
+    std::uint64_t largest = length;
+    std::uint64_t roundSteps = rounds == 0 ? 0 : rounds * (smallest + largest) + rounds;
+    return roundSteps + (length % 2 ? 3 : 1);
+}
+
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::generate(Kind kind, const Parameters& parameters) {
+    switch (kind) {
+        case Kind::Regular: return regular(parameters);
+        case Kind::Composition: return composition(parameters);
+        case Kind::Loop: return loop(parameters);
+        case Kind::Conditional: return conditional(parameters);
+        case Kind::MultiTape: return multiTape(parameters);
+        case Kind::BinaryCounter: return binaryCounter(parameters);
+        case Kind::UnaryMultiplication: return unaryMultiplication(parameters);
+        case Kind::Palindrome: return palindrome(parameters);
+        case Kind::BusyBeaver: return busyBeaver(parameters);
+    }
+    throw std::invalid_argument("Unknown workload kind");
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::regular(const Parameters& parameters) {
+    std::string symbols = dataSymbols(parameters);
+    std::uint64_t passes = sweepPasses(parameters, false);
+
+    std::ostringstream out;
+    out << "REGULAR\n";
+    sweepingMachine(out, symbols, workingStates(parameters));
+    out << sweepTape(parameters, symbols, passes);
+    return {out.str(), totalSweepSteps(passes, parameters.tapeLength, false), true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::composition(const Parameters& parameters) {
+    std::string symbols = dataSymbols(parameters);
+    std::uint64_t passes = sweepPasses(parameters, true);
+
+    std::ostringstream out;
+    out << "COMPOSITION\n";
+    sweepingMachine(out, symbols, workingStates(parameters));
+    out << "SECOND MACHINE STATES\n";
+    finishingMachine(out, symbols, 1);
+    out << sweepTape(parameters, symbols, passes);
+    return {out.str(), totalSweepSteps(passes, parameters.tapeLength, true), true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::conditional(const Parameters& parameters) {
+    std::string symbols = dataSymbols(parameters);
+    std::uint64_t passes = sweepPasses(parameters, true);
+
+    // Both branches take the same number of steps, so the total does not depend on the branch.
+    std::ostringstream out;
+    out << "CONDITIONAL\n";
+    sweepingMachine(out, symbols, workingStates(parameters));
+    // The parser skips the line after each header, so the first transition is repeated there.
+    out << "SECOND MACHINE STATES\n";
+    transition(out, START, "p", START, "p", 'R');
+    finishingMachine(out, symbols, 0);
+    out << "THIRD MACHINE STATES\n";
+    transition(out, START, "p", START, "p", 'R');
+    finishingMachine(out, symbols, 1);
+    out << "1\n" << USED << "\n";
+    out << sweepTape(parameters, symbols, passes);
+    return {out.str(), totalSweepSteps(passes, parameters.tapeLength, true), true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::loop(const Parameters& parameters) {
+    std::string symbols = dataSymbols(parameters);
+    const std::uint64_t length = parameters.tapeLength;
+
+    // Iteration j starts on the (j+1)-th counter cell and takes 2(K+L-j)+1 steps; every
+    // iteration but the last also runs the one-step post-loop machine.
+    auto loopSteps = [&](std::uint64_t iterations) {
+        return iterations * iterations + 2 * iterations * length + 2 * iterations + iterations - 1;
+    };
+    std::uint64_t iterations = parameters.steps == 0 ? 1 : smallestSize(1, parameters.steps, loopSteps);
+
+    std::ostringstream out;
+    out << "LOOP\n";
+    transition(out, FULL, "take", USED, workingState(0), 'R');
+    for (char symbol : symbols) {
+        transition(out, symbol, "take", symbol, "halt", 'S');
+    }
+    transition(out, BLANK, "take", BLANK, "halt", 'S');
+    const std::size_t stateCount = workingStates(parameters);
+    for (std::size_t state = 0; state < stateCount; ++state) {
+        for (std::size_t symbol = 0; symbol < symbols.size(); ++symbol) {
+            transition(out, symbols[symbol], workingState(state), symbols[(symbol + 1) % symbols.size()],
+                       workingState(nextWorkingState(state, symbol, stateCount)), 'R');
+        }
+        transition(out, FULL, workingState(state), FULL, workingState(state), 'R');
+        transition(out, BLANK, workingState(state), BLANK, "ret", 'L');
+    }
+    for (char symbol : symbols) {
+        transition(out, symbol, "ret", symbol, "ret", 'L');
+    }
+    transition(out, FULL, "ret", FULL, "ret", 'L');
+    transition(out, USED, "ret", USED, "halt", 'R');
+    out << "1\nhalt\n";
+    out << "POST LOOP MACHINE STATES\n";
+    for (char symbol : symbols + FULL + USED + BLANK) {
+        transition(out, symbol, "post", symbol, "halt", 'S');
+    }
+    out << "1\nhalt\n";
+    out << sweepTape(parameters, symbols, iterations);
+    out << FULL << "\n";
+    return {out.str(), loopSteps(iterations), true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::multiTape(const Parameters& parameters) {
+    if (parameters.tapes < 2) {
+        throw std::invalid_argument("A MULTITAPE workload needs at least two tapes");
+    }
+    std::string symbols = dataSymbols(parameters);
+    const std::size_t stateCount = workingStates(parameters);
+    const std::size_t auxiliaryTapes = parameters.tapes - 1;
+    const std::size_t length = parameters.steps == 0 ? parameters.tapeLength
+                                                     : static_cast<std::size_t>(std::max<std::uint64_t>(parameters.steps, 2) - 2);
+
+    // The first head sweeps the data and the others follow it over their own tapes, which
+    // are one cell longer so that they never reach the next separator.
+    const std::string fresh(auxiliaryTapes, FULL);
+    const std::string visited(auxiliaryTapes, USED);
+    std::ostringstream out;
+    out << "MULTITAPE\n";
+    out << START << fresh << "{q0}->" << START << fresh << "{q0}R" << std::string(auxiliaryTapes, 'S') << "\n";
+    for (std::size_t state = 0; state < stateCount; ++state) {
+        for (std::size_t symbol = 0; symbol < symbols.size(); ++symbol) {
+            out << symbols[symbol] << fresh << "{q" << state << "}->" << symbols[(symbol + 1) % symbols.size()] << visited
+                << "{q" << nextWorkingState(state, symbol, stateCount) << "}" << std::string(parameters.tapes, 'R') << "\n";
+        }
+        out << '#' << fresh << "{q" << state << "}->#" << fresh << "{halt}" << std::string(parameters.tapes, 'S') << "\n";
+    }
+    out << "1\nhalt\n";
+    out << START << randomData(symbols, length, parameters.seed) << "\n";
+    for (std::size_t tape = 0; tape < auxiliaryTapes; ++tape) {
+        out << START << std::string(length + 1, FULL) << "\n";
+    }
+    return {out.str(), static_cast<std::uint64_t>(length) + 2, true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::binaryCounter(const Parameters& parameters) {
+    // Counting through every n-bit value takes 2^(n+2) - 2 steps.
+    auto counterSteps = [](std::uint64_t bits) { return (std::uint64_t(1) << (bits + 2)) - 2; };
+    std::uint64_t bits = parameters.steps == 0 ? parameters.tapeLength : smallestSize(0, parameters.steps, [&](std::uint64_t size) {
+        return size > 60 ? std::numeric_limits<std::uint64_t>::max() : counterSteps(size);
+    });
+    if (bits > 60) {
+        throw std::invalid_argument("A binary counter can have at most 60 bits");
+    }
+
+    std::ostringstream out;
+    out << "REGULAR\n";
+    transition(out, '0', "right", '0', "right", 'R');
+    transition(out, '1', "right", '1', "right", 'R');
+    transition(out, BLANK, "right", BLANK, "carry", 'L');
+    transition(out, '1', "carry", '0', "carry", 'L');
+    transition(out, '0', "carry", '1', "right", 'R');
+    transition(out, START, "carry", START, "halt", 'S');
+    out << "1\nhalt\n";
+    out << START << std::string(bits, '0') << "\n";
+    return {out.str(), counterSteps(bits), true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::unaryMultiplication(const Parameters& parameters) {
+    std::uint64_t factor = parameters.steps == 0 ? parameters.tapeLength / 2 : smallestSize(0, parameters.steps, [](std::uint64_t size) {
+        return size >= 4096 ? std::numeric_limits<std::uint64_t>::max() : multiplicationSteps(size, size);
+    });
+
+    // Marks each one of the first factor in turn and appends a copy of the second factor
+    // after '=', marking and restoring its ones.
+    std::ostringstream out;
+    out << "REGULAR\n";
+    transition(out, '1', "pick", 'x', "tob", 'R');
+    transition(out, '*', "pick", '*', "halt", 'S');
+    transition(out, '1', "tob", '1', "tob", 'R');
+    transition(out, '*', "tob", '*', "copy", 'R');
+    transition(out, 'y', "copy", 'y', "copy", 'R');
+    transition(out, '1', "copy", 'y', "toend", 'R');
+    transition(out, '=', "copy", '=', "restoreb", 'L');
+    transition(out, '1', "toend", '1', "toend", 'R');
+    transition(out, '=', "toend", '=', "toend", 'R');
+    transition(out, BLANK, "toend", '1', "backb", 'L');
+    transition(out, '1', "backb", '1', "backb", 'L');
+    transition(out, '=', "backb", '=', "backb", 'L');
+    transition(out, 'y', "backb", 'y', "copy", 'R');
+    transition(out, 'y', "restoreb", '1', "restoreb", 'L');
+    transition(out, '*', "restoreb", '*', "backa", 'L');
+    transition(out, '1', "backa", '1', "backa", 'L');
+    transition(out, 'x', "backa", 'x', "pick", 'R');
+    out << "1\nhalt\n";
+    out << START << std::string(factor, '1') << '*' << std::string(factor, '1') << "=\n";
+    return {out.str(), multiplicationSteps(factor, factor), true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::palindrome(const Parameters& parameters) {
+    std::string symbols = dataSymbols(parameters);
+    std::uint64_t length = parameters.steps == 0 ? parameters.tapeLength : smallestSize(0, parameters.steps, palindromeSteps);
+
+    // Marks the leftmost unmarked symbol, remembers it in the state and compares it with the
+    // rightmost unmarked one; a mismatch rejects.
+    std::ostringstream out;
+    out << "REGULAR\n";
+    for (char symbol : symbols) {
+        transition(out, symbol, "start", 'x', std::string("have") + symbol, 'R');
+    }
+    transition(out, 'x', "start", 'x', "accept", 'S');
+    transition(out, BLANK, "start", BLANK, "accept", 'S');
+    for (char remembered : symbols) {
+        const std::string have = std::string("have") + remembered;
+        const std::string check = std::string("check") + remembered;
+        for (char symbol : symbols) {
+            transition(out, symbol, have, symbol, have, 'R');
+            transition(out, symbol, check, symbol == remembered ? 'x' : symbol, symbol == remembered ? "back" : "reject",
+                       symbol == remembered ? 'L' : 'S');
+        }
+        transition(out, BLANK, have, BLANK, check, 'L');
+        transition(out, 'x', have, 'x', check, 'L');
+        transition(out, 'x', check, 'x', "accept", 'S');
+    }
+    for (char symbol : symbols) {
+        transition(out, symbol, "back", symbol, "back", 'L');
+    }
+    transition(out, 'x', "back", 'x', "start", 'R');
+    out << "2\naccept\nreject\n";
+
+    std::string half = randomData(symbols, length / 2, parameters.seed);
+    std::string word = half + (length % 2 ? randomData(symbols, 1, parameters.seed + 1) : "") + std::string(half.rbegin(), half.rend());
+    out << START << word << "\n";
+    return {out.str(), palindromeSteps(length), true};
+}
+
+WorkloadGenerator::Workload WorkloadGenerator::busyBeaver(const Parameters& parameters) {
+    const BusyBeaver* champion = nullptr;
+    for (const BusyBeaver& candidate : BUSY_BEAVERS) {
+        if (candidate.states == parameters.states) {
+            champion = &candidate;
+        }
+    }
+    if (!champion) {
+        throw std::invalid_argument("Busy beavers are available for 2 to 5 states");
+    }
+
+    // The tape cannot grow to the left, so the run starts after a prelude of '.' cells that
+    // count as zeros. A head that still reaches '>' bounces off it, which changes the run.
+    auto stateName = [](std::size_t index) { return std::string(1, static_cast<char>('a' + index)); };
+    auto emit = [&](std::ostream& out, char symbol, const std::string& state, const BusyBeaverRule& rule) {
+        transition(out, symbol, state, rule.write, rule.next == 'h' ? "halt" : std::string(1, rule.next), rule.move);
+    };
+
+    std::ostringstream out;
+    out << "REGULAR\n";
+    transition(out, '.', "seek", '.', "seek", 'R');
+    emit(out, BLANK, "seek", champion->rules[0][0]);
+    for (std::size_t state = 0; state < champion->states; ++state) {
+        for (char zero : {'0', '.', BLANK}) {
+            emit(out, zero, stateName(state), champion->rules[state][0]);
+        }
+        emit(out, '1', stateName(state), champion->rules[state][1]);
+        transition(out, START, stateName(state), START, stateName(state), 'R');
+    }
+    out << "1\nhalt\n";
+    out << START << std::string(parameters.tapeLength, '.') << "\n";
+    return {out.str(), parameters.tapeLength + champion->steps, parameters.tapeLength >= champion->leftRoom};
+}
+
+void WorkloadGenerator::writeFile(const std::string& fileName, const Workload& workload) {
+    std::ofstream file(fileName, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open or create file: " + fileName);
+    }
+    file << workload.description;
+}
+
+WorkloadGenerator::Kind WorkloadGenerator::parseKind(const std::string& name) {
+    for (Kind kind : {Kind::Regular, Kind::Composition, Kind::Loop, Kind::Conditional, Kind::MultiTape,
+                      Kind::BinaryCounter, Kind::UnaryMultiplication, Kind::Palindrome, Kind::BusyBeaver}) {
+        if (kindName(kind) == name) {
+            return kind;
+        }
+    }
+    throw std::invalid_argument("Unknown workload: " + name);
+}
+
+std::string WorkloadGenerator::kindName(Kind kind) {
+    switch (kind) {
+        case Kind::Regular: return "regular";
+        case Kind::Composition: return "composition";
+        case Kind::Loop: return "loop";
+        case Kind::Conditional: return "conditional";
+        case Kind::MultiTape: return "multitape";
+        case Kind::BinaryCounter: return "binary-counter";
+        case Kind::UnaryMultiplication: return "unary-multiplication";
+        case Kind::Palindrome: return "palindrome";
+        case Kind::BusyBeaver: return "busy-beaver";
+    }
+    return "";
+}
@@ -0,0 +1,74 @@
+/**
+ * @file WorkloadGenerator.h
+ * @brief Synthetic machine descriptions for benchmarks and hardware sizing.
+ *
+ * The generator writes description files in the same text formats the factory reads, so a
+ * generated workload can be run by any of the existing tools. Besides tunable sweeping
+ * machines of every type it provides a few canonical heavy workloads.
+ */
+#ifndef TURING_MACHINE_WORKLOADGENERATOR_H
+#define TURING_MACHINE_WORKLOADGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class WorkloadGenerator
+ * @brief Emits valid REGULAR, COMPOSITION, LOOP, CONDITIONAL and MULTITAPE descriptions.
+ */
+class WorkloadGenerator {
+public:
+    enum class Kind {
+        Regular,             ///< Bounces over random data, counting passes on the tape.
+        Composition,         ///< The regular workload followed by a pass that re-arms the counter.
+        Loop,                ///< One sweep of the data per loop iteration.
+        Conditional,         ///< The regular workload followed by one of two finishing passes.
+        MultiTape,           ///< Several heads sweeping their tapes in lockstep.
+        BinaryCounter,       ///< Counts through every value of an n-bit counter.
+        UnaryMultiplication, ///< Multiplies two unary numbers.
+        Palindrome,          ///< Checks a palindrome by marking both ends.
+        BusyBeaver           ///< Runs a 2 to 5 state busy beaver champion.
+    };
+
+    struct Parameters {
+        std::size_t states = 4;       ///< Working states of the sweeping machines, or the busy beaver size.
+        std::size_t alphabetSize = 2; ///< Distinct data symbols on the tape (at most 62).
+        std::size_t tapeLength = 64;  ///< Data cells on the tape.
+        std::uint64_t steps = 0;      ///< Target step count; 0 lets the tape length decide.
+        std::size_t tapes = 2;        ///< Tapes of a MULTITAPE workload.
+        std::uint32_t seed = 1;       ///< Seed for the random data.
+    };
+
+    struct Workload {
+        std::string description;     ///< The description file, starting with the machine type line.
+        std::uint64_t expectedSteps; ///< Transitions taken over the whole run, summed over all machines.
+        bool exact;                  ///< Whether expectedSteps is exact rather than an estimate.
+    };
+
+    /**
+     * Generates a workload. When a target step count is given, the size of the workload
+     * (passes, counter bits, input length) is chosen as the smallest one that reaches it.
+     */
+    static Workload generate(Kind kind, const Parameters& parameters);
+
+    /// Writes the description to a file.
+    static void writeFile(const std::string& fileName, const Workload& workload);
+
+    /// Maps a name such as "regular" or "busy-beaver" to a kind.
+    static Kind parseKind(const std::string& name);
+    static std::string kindName(Kind kind);
+
+private:
+    static Workload regular(const Parameters& parameters);
+    static Workload composition(const Parameters& parameters);
+    static Workload loop(const Parameters& parameters);
+    static Workload conditional(const Parameters& parameters);
+    static Workload multiTape(const Parameters& parameters);
+    static Workload binaryCounter(const Parameters& parameters);
+    static Workload unaryMultiplication(const Parameters& parameters);
+    static Workload palindrome(const Parameters& parameters);
+    static Workload busyBeaver(const Parameters& parameters);
+};
+
+#endif //TURING_MACHINE_WORKLOADGENERATOR_H
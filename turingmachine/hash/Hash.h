@@ -0,0 +1,110 @@
+#ifndef TURING_MACHINE_HASH_H
+#define TURING_MACHINE_HASH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/// 64-bit FNV-1a, used to detect changes in machine description files.
+inline std::uint64_t fnv1a64(std::string_view data, std::uint64_t seed = 0xcbf29ce484222325ull) {
+    std::uint64_t hash = seed;
+    for (unsigned char byte : data) {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/// A 128-bit hash value.
+struct Hash128 {
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    bool operator==(const Hash128& other) const { return low == other.low && high == other.high; }
+    bool operator!=(const Hash128& other) const { return !(*this == other); }
+
+    /// 32 lowercase hex digits, high word first.
+    std::string toHex() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            hex[15 - i] = digits[(high >> (4 * i)) & 0xF];
+            hex[31 - i] = digits[(low >> (4 * i)) & 0xF];
+        }
+        return hex;
+    }
+};
+
+namespace detail {
+
+inline std::uint64_t rotl64(std::uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t fmix64(std::uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+inline std::uint64_t load64(const unsigned char* bytes) {
+    std::uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+}
+
+/// MurmurHash3 x64 128-bit, used to key cached results; fast, but not cryptographic.
+inline Hash128 hash128(std::string_view data, std::uint64_t seed = 0) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    const std::size_t blocks = data.size() / 16;
+    const std::uint64_t c1 = 0x87c37b91114253d5ull;
+    const std::uint64_t c2 = 0x4cf5ad432745937full;
+    std::uint64_t h1 = seed;
+    std::uint64_t h2 = seed;
+
+    for (std::size_t i = 0; i < blocks; ++i) {
+        std::uint64_t k1 = detail::load64(bytes + 16 * i);
+        std::uint64_t k2 = detail::load64(bytes + 16 * i + 8);
+        k1 *= c1; k1 = detail::rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = detail::rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = detail::rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = detail::rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const unsigned char* tail = bytes + 16 * blocks;
+    std::uint64_t k1 = 0;
+    std::uint64_t k2 = 0;
+    const std::size_t rest = data.size() & 15;
+    for (std::size_t i = rest; i > 8; --i) {
+        k2 ^= static_cast<std::uint64_t>(tail[i - 1]) << (8 * (i - 9));
+    }
+    if (rest > 8) {
+        k2 *= c2; k2 = detail::rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    for (std::size_t i = std::min<std::size_t>(rest, 8); i > 0; --i) {
+        k1 ^= static_cast<std::uint64_t>(tail[i - 1]) << (8 * (i - 1));
+    }
+    if (rest > 0) {
+        k1 *= c1; k1 = detail::rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= data.size();
+    h2 ^= data.size();
+    h1 += h2;
+    h2 += h1;
+    h1 = detail::fmix64(h1);
+    h2 = detail::fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+    return Hash128{h1, h2};
+}
+
+#endif //TURING_MACHINE_HASH_H
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include "TuringMachine.h"
 #include "../parsers/CompositionParser.h"
+#include "RegularExecution.h"
 
 #include "CompositionTuringMachine.h"
 #include <fstream>
@@ -19,24 +20,89 @@ CompositionTuringMachine::CompositionTuringMachine(std::istream& inputStream) {
 }
 
 void CompositionTuringMachine::init(std::istream& inputStream) {
-    CompositionMachineParser parser(inputStream);
+    initFromFile(inputStream, {});
+}
+
+void CompositionTuringMachine::initFromFile(std::istream& inputStream, const std::string& directory) {
+    CompositionMachineParser parser(inputStream, directory);
     parser.parse();
     machine1 = parser.getFirstMachine();
     machine2 = parser.getSecondMachine();
-    machine1->setTape(parser.getTape());
+    machine1->getExecution().getTape() = machine2->getExecution().getTape();
     machine1->setCurrentPosition(1);
 }
 
 void CompositionTuringMachine::run(const std::string &outputFileName) {
+    if (!machine1 || !machine2) {
+        std::cerr << "Error: Machines not initialized properly in CompositionTuringMachine." << std::endl;
+        return;
+    }
+    if (advance() == Status::NoTransition) {
+        std::cerr << "Machine reached invalid state: " << getStateName() << std::endl;
+    }
+    (stage == 0 ? machine1 : machine2)->outputTape(outputFileName);
+}
+
+std::unique_ptr<TuringMachine> CompositionTuringMachine::clone() const {
+    auto copy = std::make_unique<CompositionTuringMachine>();
     if (machine1 && machine2) {
-        machine1->run(outputFileName);  // Run the first machine
+        copy->setMachines(machine1->cloneRegular(), machine2->cloneRegular());
+    }
+    copy->stage = stage;
+    copy->steps = steps;
+    copy->stuck = stuck;
+    return copy;
+}
 
-        std::string intermediateTape = machine1->getTape();
-        machine2->setTape(intermediateTape);  // Set the tape for the second machine
-        machine2->setCurrentPosition(machine1->getCurrentPosition());  // Reset position for the second machine
-        machine2->run(outputFileName);  // Run the second machine
-    } else {
-        std::cerr << "Error: Machines not initialized properly in CompositionTuringMachine." << std::endl;
+void CompositionTuringMachine::setInput(const std::string& tape) {
+    machine1->setInput(tape);
+    stage = 0;
+    steps = 0;
+    stuck = false;
+}
+
+TuringMachine::Status CompositionTuringMachine::advance(std::uint64_t maxSteps) {
+    std::uint64_t remaining = maxSteps;
+    while (true) {
+        Status status = advanceStage(stage == 0 ? *machine1 : *machine2, remaining, steps);
+        if (status == Status::Running) {
+            return status;
+        }
+        stuck = stuck || status == Status::NoTransition;
+        if (stage == 1) {
+            return stuck ? Status::NoTransition : Status::Halted;
+        }
+
+        // The second machine starts on the first one's tape however it stopped; the head moves with it.
+        machine2->getExecution().start(std::move(machine1->getExecution().getTape()));
+        stage = 1;
+    }
+}
+
+std::string CompositionTuringMachine::getOutput() const {
+    return (stage == 0 ? machine1 : machine2)->getOutput();
+}
+
+std::size_t CompositionTuringMachine::getTapeSize() const {
+    return (stage == 0 ? machine1 : machine2)->getTapeSize();
+}
+
+std::uint64_t CompositionTuringMachine::getStepCount() const {
+    return steps;
+}
+
+std::size_t CompositionTuringMachine::getHeadPosition() const {
+    return (stage == 0 ? machine1 : machine2)->getHeadPosition();
+}
+
+std::string CompositionTuringMachine::getStateName() const {
+    return (stage == 0 ? machine1 : machine2)->getStateName();
+}
+
+void CompositionTuringMachine::forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const {
+    if (machine1 && machine2) {
+        machine1->forEachProgram(visit);
+        machine2->forEachProgram(visit);
     }
 }
 
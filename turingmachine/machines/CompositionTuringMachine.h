@@ -10,13 +10,28 @@ public:
     CompositionTuringMachine();
     CompositionTuringMachine(std::istream& inputStream);
     void init(std::istream& inputStream) override;
+    void initFromFile(std::istream& inputStream, const std::string& directory) override;
     void run(const std::string &outputFileName);
+    std::unique_ptr<TuringMachine> clone() const override;
+    void setInput(const std::string& tape) override;
+    Status advance(std::uint64_t maxSteps = UNLIMITED) override;
+    std::string getOutput() const override;
+    std::size_t getTapeSize() const override;
+    std::uint64_t getStepCount() const override;
+    std::size_t getHeadPosition() const override;
+    std::string getStateName() const override;
+    void forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const override;
     void setMachines(std::unique_ptr<RegularTuringMachine> m1, std::unique_ptr<RegularTuringMachine> m2);
     void setTape(const std::string& tape);
 
 private:
+    friend class MachineFuser;
+
     std::unique_ptr<RegularTuringMachine> machine1; ///< First machine to be executed
     std::unique_ptr<RegularTuringMachine> machine2; ///< Second machine to be executed
+    std::size_t stage = 0;     ///< Index of the machine advance() is running.
+    std::uint64_t steps = 0;   ///< Steps taken by both machines.
+    bool stuck = false;        ///< Whether a machine stopped without a transition.
     std::string createTempFile(const std::vector<std::string>& inputLines, int index);
 };
 
@@ -4,36 +4,106 @@
 #include <filesystem>
 #include "ConditionalTuringMachine.h"
 #include "../parsers/ConditionalParser.h"
+#include "RegularExecution.h"
 
 
 void ConditionalCompositionTuringMachine::init(std::istream& inputStream) {
-    ConditionalCompositionMachineParser parser(inputStream);
+    initFromFile(inputStream, {});
+}
+
+void ConditionalCompositionTuringMachine::initFromFile(std::istream& inputStream, const std::string& directory) {
+    ConditionalCompositionMachineParser parser(inputStream, directory);
     parser.parse();
 
     machine1 = parser.getFirstMachine();
     machine2 = parser.getSecondMachine();
     machine3 = parser.getThirdMachine();
-    machine1->setTape(machine3->getTape());
+    machine1->getExecution().getTape() = machine3->getExecution().getTape();
     machine1->setCurrentPosition(1);
 }
 
 void ConditionalCompositionTuringMachine::run(const std::string& outputFileName) {
-    machine1->run(outputFileName);
-
-    std::string intermediateTape = machine1->getTape();
-    char currentSymbol = intermediateTape[machine1->getCurrentPosition()];
-
-    if (conditionalSymbols.find(currentSymbol) != conditionalSymbols.end()) {
-        machine2->setTape(intermediateTape);
-        machine2->setCurrentPosition(machine1->getCurrentPosition());
-        machine2->run(outputFileName);
-    } else {
-        machine3->setTape(intermediateTape);
-        machine3->setCurrentPosition(machine1->getCurrentPosition());
-        machine3->run(outputFileName);
+    if (advance() == Status::NoTransition) {
+        std::cerr << "Machine reached invalid state: " << getStateName() << std::endl;
+    }
+    (current ? current : machine1.get())->outputTape(outputFileName);
+}
+
+std::unique_ptr<TuringMachine> ConditionalCompositionTuringMachine::clone() const {
+    auto copy = std::make_unique<ConditionalCompositionTuringMachine>();
+    if (machine1 && machine2 && machine3) {
+        copy->machine1 = machine1->cloneRegular();
+        copy->machine2 = machine2->cloneRegular();
+        copy->machine3 = machine3->cloneRegular();
+    }
+    copy->conditionalSymbols = conditionalSymbols;
+    if (current == machine2.get()) {
+        copy->current = copy->machine2.get();
+    } else if (current == machine3.get()) {
+        copy->current = copy->machine3.get();
+    }
+    copy->steps = steps;
+    copy->stuck = stuck;
+    return copy;
+}
+
+void ConditionalCompositionTuringMachine::setInput(const std::string& tape) {
+    machine1->setInput(tape);
+    current = nullptr;
+    steps = 0;
+    stuck = false;
+}
+
+TuringMachine::Status ConditionalCompositionTuringMachine::advance(std::uint64_t maxSteps) {
+    std::uint64_t remaining = maxSteps;
+    Status status = advanceStage(current ? *current : *machine1, remaining, steps);
+    if (status == Status::Running) {
+        return status;
+    }
+    stuck = stuck || status == Status::NoTransition;
+
+    if (!current) {
+        Tape& intermediateTape = machine1->getExecution().getTape();
+        char currentSymbol = intermediateTape.empty() ? Tape::BLANK : intermediateTape.read();
+        current = conditionalSymbols.find(currentSymbol) != conditionalSymbols.end() ? machine2.get() : machine3.get();
+        current->getExecution().start(std::move(intermediateTape));
+
+        status = advanceStage(*current, remaining, steps);
+        if (status == Status::Running) {
+            return status;
+        }
+        stuck = stuck || status == Status::NoTransition;
     }
+    return stuck ? Status::NoTransition : Status::Halted;
+}
+
+std::string ConditionalCompositionTuringMachine::getOutput() const {
+    return (current ? current : machine1.get())->getOutput();
+}
+
+std::size_t ConditionalCompositionTuringMachine::getTapeSize() const {
+    return (current ? current : machine1.get())->getTapeSize();
+}
+
+std::uint64_t ConditionalCompositionTuringMachine::getStepCount() const {
+    return steps;
 }
 
+std::size_t ConditionalCompositionTuringMachine::getHeadPosition() const {
+    return (current ? current : machine1.get())->getHeadPosition();
+}
+
+std::string ConditionalCompositionTuringMachine::getStateName() const {
+    return (current ? current : machine1.get())->getStateName();
+}
+
+void ConditionalCompositionTuringMachine::forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const {
+    for (const auto* machine : {machine1.get(), machine2.get(), machine3.get()}) {
+        if (machine) {
+            machine->forEachProgram(visit);
+        }
+    }
+}
 
 ConditionalCompositionTuringMachine::ConditionalCompositionTuringMachine() {
 }
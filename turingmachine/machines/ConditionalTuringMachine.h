@@ -9,15 +9,30 @@ public:
     ConditionalCompositionTuringMachine();
     ConditionalCompositionTuringMachine(std::istream& inputStream);
     void init(std::istream& inputStream) override;
+    void initFromFile(std::istream& inputStream, const std::string& directory) override;
     void run(const std::string &outputFileName);
+    std::unique_ptr<TuringMachine> clone() const override;
+    void setInput(const std::string& tape) override;
+    Status advance(std::uint64_t maxSteps = UNLIMITED) override;
+    std::string getOutput() const override;
+    std::size_t getTapeSize() const override;
+    std::uint64_t getStepCount() const override;
+    std::size_t getHeadPosition() const override;
+    std::string getStateName() const override;
+    void forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const override;
 
 private:
+    friend class MachineFuser;
+
     std::unique_ptr<RegularTuringMachine> machine1;
     std::unique_ptr<RegularTuringMachine> machine2;
     std::unique_ptr<RegularTuringMachine> machine3;
 
     std::string createTempFile(const std::vector<std::string>& inputLines, int index);
     std::set<char> conditionalSymbols;
+    RegularTuringMachine* current = nullptr; ///< Machine advance() is running; machine1 when null.
+    std::uint64_t steps = 0;                 ///< Steps taken by all machines.
+    bool stuck = false;                      ///< Whether a machine stopped without a transition.
 
 };
 
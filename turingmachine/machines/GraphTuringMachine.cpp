@@ -0,0 +1,70 @@
+#include <stdexcept>
+#include "GraphTuringMachine.h"
+#include "../parsers/GraphParser.h"
+#include "../tape/Tape.h"
+
+GraphTuringMachine::GraphTuringMachine() {
+}
+
+GraphTuringMachine::GraphTuringMachine(std::istream& inputStream) {
+    init(inputStream);
+}
+
+void GraphTuringMachine::init(std::istream& inputStream) {
+    initFromFile(inputStream, {});
+}
+
+void GraphTuringMachine::initFromFile(std::istream& inputStream, const std::string& directory) {
+    GraphMachineParser parser(inputStream, directory);
+    parser.parse();
+
+    std::vector<Node> parsed;
+    for (auto& node : parser.getNodes()) {
+        parsed.push_back({std::move(node.name), std::move(node.program), {}});
+    }
+    for (const auto& edge : parser.getEdges()) {
+        Edge compiled;
+        if (edge.state) {
+            compiled.state = parsed[edge.from].program->findState(*edge.state);
+        }
+        compiled.symbol = edge.symbol;
+        compiled.to = edge.to;
+        parsed[edge.from].edges.push_back(compiled);
+    }
+    setNodes(std::move(parsed), parser.getTape());
+}
+
+void GraphTuringMachine::setNodes(std::vector<Node> newNodes, const std::string& tape) {
+    if (newNodes.empty()) {
+        throw std::invalid_argument("Machine graph without nodes");
+    }
+    nodes = std::move(newNodes);
+    start(tape);
+}
+
+std::unique_ptr<TuringMachine> GraphTuringMachine::clone() const {
+    auto copy = std::make_unique<GraphTuringMachine>();
+    copy->nodes = nodes;
+    copyRunTo(*copy);
+    return copy;
+}
+
+std::optional<std::size_t> GraphTuringMachine::next(Status& status) {
+    if (status != Status::Halted) {
+        return std::nullopt;
+    }
+    // The first edge, in file order, whose guards match the halting state and the symbol under the head.
+    const Tape& tape = execution->getTape();
+    const char symbol = tape.empty() ? Tape::BLANK : tape.read();
+    for (const Edge& edge : nodes[current].edges) {
+        if ((edge.state == CompiledMachine::NO_STATE || edge.state == execution->getState())
+            && (!edge.symbol || *edge.symbol == symbol)) {
+            return edge.to;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string GraphTuringMachine::describeCurrent() const {
+    return "node " + getNodeName();
+}
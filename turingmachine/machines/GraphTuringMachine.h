@@ -0,0 +1,60 @@
+#ifndef TURING_MACHINE_GRAPHTURINGMACHINE_H
+#define TURING_MACHINE_GRAPHTURINGMACHINE_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "SharedTapeTuringMachine.h"
+
+/**
+ * @class GraphTuringMachine
+ * @brief Regular machines connected by edges guarded on how the previous one halted.
+ *
+ * The nodes share one tape and head, like the stages of a pipeline. When a node halts, the
+ * first of its edges, in file order, whose halting state and symbol under the head match
+ * names the node that takes over; when none matches, the graph halts. A node that stops
+ * without a transition ends the graph with NoTransition.
+ */
+class GraphTuringMachine : public SharedTapeTuringMachine {
+public:
+    /// An edge out of a node; the guards that are set must all match.
+    struct Edge {
+        std::uint32_t state = CompiledMachine::NO_STATE; ///< Halting state of the node, or any.
+        std::optional<char> symbol;                      ///< Symbol under the head, or any.
+        std::size_t to = 0;                              ///< Node that runs next.
+    };
+
+    /// A sub-machine with the edges leaving it.
+    struct Node {
+        std::string name;
+        std::shared_ptr<const CompiledMachine> program;
+        std::vector<Edge> edges;
+    };
+
+    GraphTuringMachine();
+    GraphTuringMachine(std::istream& inputStream);
+    void init(std::istream& inputStream) override;
+    void initFromFile(std::istream& inputStream, const std::string& directory) override;
+    std::unique_ptr<TuringMachine> clone() const override;
+
+    /// Replaces the nodes and starts the first one on the given tape.
+    void setNodes(std::vector<Node> nodes, const std::string& tape);
+
+    std::size_t getNodeCount() const { return nodes.size(); }
+    /// Name of the node advance() is running.
+    const std::string& getNodeName() const { return nodes[current].name; }
+
+protected:
+    std::size_t getProgramCount() const override { return nodes.size(); }
+    const std::shared_ptr<const CompiledMachine>& getProgram(std::size_t index) const override { return nodes[index].program; }
+    std::optional<std::size_t> next(Status& status) override;
+    std::string describeCurrent() const override;
+
+private:
+    friend class MachineFuser;
+
+    std::vector<Node> nodes; ///< Sub-machines; the first one starts the graph.
+};
+
+#endif //TURING_MACHINE_GRAPHTURINGMACHINE_H
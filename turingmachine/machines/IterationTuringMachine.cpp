@@ -2,6 +2,7 @@
 #include "IterationTuringMachine.h"
 #include "TuringMachine.h"
 #include "../parsers/IterationParser.h"
+#include "RegularExecution.h"
 
 IterationLoopTuringMachine::IterationLoopTuringMachine(std::istream& inputStream) {
     init(inputStream);
@@ -12,7 +13,11 @@ IterationLoopTuringMachine::IterationLoopTuringMachine() {
 }
 
 void IterationLoopTuringMachine::init(std::istream& inputStream) {
-    IterationLoopMachineParser parser(inputStream);
+    initFromFile(inputStream, {});
+}
+
+void IterationLoopTuringMachine::initFromFile(std::istream& inputStream, const std::string& directory) {
+    IterationLoopMachineParser parser(inputStream, directory);
     parser.parse();
 
     loopMachine = parser.getLoopMachine();
@@ -20,19 +25,89 @@ void IterationLoopTuringMachine::init(std::istream& inputStream) {
     loopConditionSymbol = parser.getLoopConditionSymbol();
 }
 
-void IterationLoopTuringMachine::run(const std::string &outputFileName) {
-    char lastSymbol;
-    std::string initialState = loopMachine->getCurrentState();
-    do {
-        loopMachine->setCurrentState(initialState);
-        loopMachine->run(outputFileName);
-
-        lastSymbol = loopMachine->getTape()[loopMachine->getCurrentPosition()];
-
-        if (lastSymbol == loopConditionSymbol) {
-            postLoopMachine->setTape(loopMachine->getTape());
-            postLoopMachine->setCurrentPosition(loopMachine->getCurrentPosition());
-            postLoopMachine->run(outputFileName);
+std::unique_ptr<TuringMachine> IterationLoopTuringMachine::clone() const {
+    auto copy = std::make_unique<IterationLoopTuringMachine>();
+    if (loopMachine && postLoopMachine) {
+        copy->loopMachine = loopMachine->cloneRegular();
+        copy->postLoopMachine = postLoopMachine->cloneRegular();
+    }
+    copy->loopConditionSymbol = loopConditionSymbol;
+    copy->inPostLoop = inPostLoop;
+    copy->steps = steps;
+    copy->stuck = stuck;
+    return copy;
+}
+
+void IterationLoopTuringMachine::setInput(const std::string& tape) {
+    loopMachine->setInput(tape);
+    inPostLoop = false;
+    steps = 0;
+    stuck = false;
+}
+
+TuringMachine::Status IterationLoopTuringMachine::advance(std::uint64_t maxSteps) {
+    std::uint64_t remaining = maxSteps;
+    while (true) {
+        if (!inPostLoop) {
+            Status status = advanceStage(*loopMachine, remaining, steps);
+            if (status == Status::Running) {
+                return status;
+            }
+            stuck = stuck || status == Status::NoTransition;
+
+            const Tape& loopTape = loopMachine->getExecution().getTape();
+            char lastSymbol = loopTape.empty() ? Tape::BLANK : loopTape.read();
+            if (lastSymbol != loopConditionSymbol) {
+                return stuck ? Status::NoTransition : Status::Halted;
+            }
+            // The loop machine keeps its own tape, so the post-loop machine works on a copy.
+            postLoopMachine->getExecution().start(loopTape);
+            inPostLoop = true;
+        }
+
+        Status status = advanceStage(*postLoopMachine, remaining, steps);
+        if (status == Status::Running) {
+            return status;
         }
-    } while (lastSymbol == loopConditionSymbol);
-}
\ No newline at end of file
+        stuck = stuck || status == Status::NoTransition;
+
+        // Next iteration: the loop machine starts over on its own tape.
+        RegularExecution& loopExecution = loopMachine->getExecution();
+        loopExecution.setState(loopExecution.getProgram()->getInitialState());
+        inPostLoop = false;
+    }
+}
+
+std::string IterationLoopTuringMachine::getOutput() const {
+    return (inPostLoop ? postLoopMachine : loopMachine)->getOutput();
+}
+
+std::size_t IterationLoopTuringMachine::getTapeSize() const {
+    return (inPostLoop ? postLoopMachine : loopMachine)->getTapeSize();
+}
+
+std::uint64_t IterationLoopTuringMachine::getStepCount() const {
+    return steps;
+}
+
+std::size_t IterationLoopTuringMachine::getHeadPosition() const {
+    return (inPostLoop ? postLoopMachine : loopMachine)->getHeadPosition();
+}
+
+std::string IterationLoopTuringMachine::getStateName() const {
+    return (inPostLoop ? postLoopMachine : loopMachine)->getStateName();
+}
+
+void IterationLoopTuringMachine::forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const {
+    if (loopMachine && postLoopMachine) {
+        loopMachine->forEachProgram(visit);
+        postLoopMachine->forEachProgram(visit);
+    }
+}
+
+void IterationLoopTuringMachine::run(const std::string &outputFileName) {
+    if (advance() == Status::NoTransition) {
+        std::cerr << "Machine reached invalid state: " << getStateName() << std::endl;
+    }
+    (inPostLoop ? postLoopMachine : loopMachine)->outputTape(outputFileName);
+}
@@ -18,13 +18,30 @@ public:
     IterationLoopTuringMachine();
 
     void init(std::istream& inputStream) override;
+    void initFromFile(std::istream& inputStream, const std::string& directory) override;
 
     void run(const std::string& outputFileName) override;
 
+    std::unique_ptr<TuringMachine> clone() const override;
+
+    void setInput(const std::string& tape) override;
+    Status advance(std::uint64_t maxSteps = UNLIMITED) override;
+    std::string getOutput() const override;
+    std::size_t getTapeSize() const override;
+    std::uint64_t getStepCount() const override;
+    std::size_t getHeadPosition() const override;
+    std::string getStateName() const override;
+    void forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const override;
+
 private:
+    friend class MachineFuser;
+
     std::unique_ptr<RegularTuringMachine> loopMachine;        ///< Turing machine to be run in the loop.
     std::unique_ptr<RegularTuringMachine> postLoopMachine;    ///< Turing machine to be run after the loop.
     char loopConditionSymbol;                                ///< Symbol that dictates the looping condition.
+    bool inPostLoop = false;                                 ///< Whether advance() is running the post-loop machine.
+    std::uint64_t steps = 0;                                 ///< Steps taken by both machines.
+    bool stuck = false;                                      ///< Whether a machine stopped without a transition.
 };
 
 #endif //TURING_MACHINE_ITERATIONTURINGMACHINE_H
@@ -0,0 +1,50 @@
+#include "PipelineTuringMachine.h"
+#include "../parsers/PipelineParser.h"
+
+PipelineTuringMachine::PipelineTuringMachine() {
+}
+
+PipelineTuringMachine::PipelineTuringMachine(std::istream& inputStream) {
+    init(inputStream);
+}
+
+void PipelineTuringMachine::init(std::istream& inputStream) {
+    initFromFile(inputStream, {});
+}
+
+void PipelineTuringMachine::initFromFile(std::istream& inputStream, const std::string& directory) {
+    PipelineMachineParser parser(inputStream, directory);
+    parser.parse();
+    setStages(parser.getStages(), parser.getTape());
+}
+
+void PipelineTuringMachine::setStages(std::vector<std::shared_ptr<const CompiledMachine>> newStages, const std::string& tape) {
+    stages = std::move(newStages);
+    start(tape);
+}
+
+std::unique_ptr<TuringMachine> PipelineTuringMachine::clone() const {
+    auto copy = std::make_unique<PipelineTuringMachine>();
+    copy->stages = stages;
+    copyRunTo(*copy);
+    copy->stuck = stuck;
+    return copy;
+}
+
+void PipelineTuringMachine::setInput(const std::string& tape) {
+    SharedTapeTuringMachine::setInput(tape);
+    stuck = false;
+}
+
+std::optional<std::size_t> PipelineTuringMachine::next(Status& status) {
+    stuck = stuck || status == Status::NoTransition;
+    if (current + 1 == stages.size()) {
+        status = stuck ? Status::NoTransition : Status::Halted;
+        return std::nullopt;
+    }
+    return current + 1;
+}
+
+std::string PipelineTuringMachine::describeCurrent() const {
+    return "stage " + std::to_string(current + 1);
+}
@@ -0,0 +1,44 @@
+#ifndef TURING_MACHINE_PIPELINETURINGMACHINE_H
+#define TURING_MACHINE_PIPELINETURINGMACHINE_H
+
+#include <memory>
+#include <vector>
+#include "SharedTapeTuringMachine.h"
+
+/**
+ * @class PipelineTuringMachine
+ * @brief Runs any number of regular machines one after the other on a single tape.
+ *
+ * The stages share one tape and head. As in a composition, a stage starts however the
+ * previous one stopped, and the pipeline reports NoTransition if any stage got stuck.
+ */
+class PipelineTuringMachine : public SharedTapeTuringMachine {
+public:
+    PipelineTuringMachine();
+    PipelineTuringMachine(std::istream& inputStream);
+    void init(std::istream& inputStream) override;
+    void initFromFile(std::istream& inputStream, const std::string& directory) override;
+    std::unique_ptr<TuringMachine> clone() const override;
+    void setInput(const std::string& tape) override;
+
+    /// Replaces the stages and starts the first one on the given tape.
+    void setStages(std::vector<std::shared_ptr<const CompiledMachine>> stages, const std::string& tape);
+
+    std::size_t getStageCount() const { return stages.size(); }
+    /// Index of the stage advance() is running.
+    std::size_t getStage() const { return current; }
+
+protected:
+    std::size_t getProgramCount() const override { return stages.size(); }
+    const std::shared_ptr<const CompiledMachine>& getProgram(std::size_t index) const override { return stages[index]; }
+    std::optional<std::size_t> next(Status& status) override;
+    std::string describeCurrent() const override;
+
+private:
+    friend class MachineFuser;
+
+    std::vector<std::shared_ptr<const CompiledMachine>> stages; ///< Programs of the stages, in order.
+    bool stuck = false;        ///< Whether a stage stopped without a transition.
+};
+
+#endif //TURING_MACHINE_PIPELINETURINGMACHINE_H
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include "RegularExecution.h"
+#include "../trace/Trace.h"
+
+RegularExecution::RegularExecution(std::shared_ptr<const CompiledMachine> compiledProgram)
+        : program(std::move(compiledProgram)), running(program.get()), state(CompiledMachine::NO_STATE), steps(0) {
+    reset();
+}
+
+void RegularExecution::reset() {
+    tape.assign(program->getInitialTape(), program->getInitialHead());
+    running = program.get();
+    callStack.clear();
+    state = program->getInitialState();
+    steps = 0;
+    if (stats) {
+        resetStats();
+    }
+}
+
+void RegularExecution::start(Tape input) {
+    tape = std::move(input);
+    running = program.get();
+    callStack.clear();
+    state = program->getInitialState();
+    steps = 0;
+    if (stats) {
+        resetStats();
+    }
+}
+
+void RegularExecution::setProgram(std::shared_ptr<const CompiledMachine> newProgram, std::uint32_t newState) {
+    program = std::move(newProgram);
+    running = program.get();
+    callStack.clear();
+    state = newState;
+}
+
+RegularExecution::Status RegularExecution::run(std::uint64_t maxSteps) {
+    TM_TRACE_SCOPE("run");
+    return stats ? runLoop<true, false>(maxSteps, nullptr) : runLoop<false, false>(maxSteps, nullptr);
+}
+
+RegularExecution::Status RegularExecution::run(std::uint64_t maxSteps, HeadRange& range) {
+    TM_TRACE_SCOPE("run");
+    return stats ? runLoop<true, true>(maxSteps, &range) : runLoop<false, true>(maxSteps, &range);
+}
+
+template<bool Profiled, bool Ranged>
+RegularExecution::Status RegularExecution::runLoop(std::uint64_t maxSteps, HeadRange* range) {
+    if (state >= running->getStateCount()) {
+        return Status::NoTransition;
+    }
+
+    // The profiled loop only bumps one transition counter per step and checks the head
+    // against the extremes it reached; per-state hits and head travel are derived from the
+    // transition counters when the stats are read. Transitions of sub-machines are counted
+    // as steps but have no counter of their own; their moves are counted on the side. A
+    // caller's head range is tracked the same way; the stats only ever widen to what it reaches.
+    constexpr bool Tracked = Profiled || Ranged;
+    const std::size_t initialSize = tape.size();
+    std::uint64_t* transitionHits = nullptr;
+    std::size_t minPosition = 0;
+    std::size_t maxPosition = 0;
+    std::uint64_t blockedMoves = 0; ///< Left moves on the first cell, which do not move the head.
+    std::uint64_t subMachineMoves = 0;
+    if (Profiled) {
+        stats->bind(program->getStateCount(), program->getTransitionCount());
+        transitionHits = stats->transitionHits.data();
+    }
+    if (Ranged) {
+        minPosition = range->first;
+        maxPosition = range->last;
+    } else if (Profiled) {
+        minPosition = static_cast<std::size_t>(std::max<std::int64_t>(0, static_cast<std::int64_t>(statsOrigin) + stats->minHeadOffset));
+        maxPosition = static_cast<std::size_t>(static_cast<std::int64_t>(statsOrigin) + stats->maxHeadOffset);
+    }
+    if (Tracked) {
+        minPosition = std::min(minPosition, tape.getHeadPosition());
+        maxPosition = std::max(maxPosition, tape.getHeadPosition());
+    }
+    tape.ensureCell();
+
+    std::uint64_t remaining = maxSteps;
+    Status status = Status::Halted;
+    while (true) {
+        // Rebound on every call and return; machines without calls stay in the inner loop.
+        const CompiledMachine& machine = *running;
+        const std::uint32_t stateCount = machine.getStateCount();
+        bool called = false;
+        while (!machine.isHalting(state)) {
+            if (remaining == 0) {
+                status = Status::Running;
+                break;
+            }
+
+            TM_TRACE_SAMPLE("regular", steps, state, tape.getHeadPosition());
+            const CompiledTransition& transition = machine.lookup(state, tape.read());
+            if (transition.newState >= stateCount) {
+                status = Status::NoTransition;
+                break;
+            }
+
+            if (Profiled) {
+                if (callStack.empty()) {
+                    ++transitionHits[machine.transitionIndex(transition)];
+                } else if (transition.command == 'L' || transition.command == 'R') {
+                    ++subMachineMoves;
+                }
+            }
+
+            tape.write(transition.newSymbol);
+            state = transition.newState;
+
+            if (transition.command == 'L') {
+                if (Tracked && tape.getHeadPosition() == minPosition) {
+                    // One cell at a time, so a new leftmost cell is only reached from the old one.
+                    if (minPosition == 0) {
+                        ++blockedMoves;
+                    } else {
+                        --minPosition;
+                    }
+                }
+                tape.moveLeft();
+            } else if (transition.command == 'R') {
+                if (Tracked && tape.getHeadPosition() == maxPosition) {
+                    ++maxPosition;
+                }
+                tape.moveRight();
+            } else if (transition.command == 'C') {
+                const CompiledMachine* callee = machine.getCallee(transition.callee);
+                if (callee == nullptr || callee->getInitialState() >= callee->getStateCount()) {
+                    status = Status::NoTransition;
+                    break;
+                }
+                callStack.push_back({running, state});
+                running = callee;
+                state = callee->getInitialState();
+                called = true;
+            }
+
+            --remaining;
+            ++steps;
+            if (called) {
+                break;
+            }
+        }
+        if (called) {
+            continue;
+        }
+        if (status != Status::Halted || callStack.empty()) {
+            break;
+        }
+        running = callStack.back().program;
+        state = callStack.back().returnState;
+        callStack.pop_back();
+    }
+
+    if (Profiled) {
+        stats->steps += maxSteps - remaining;
+        blockedLeftMoves += blockedMoves;
+        calledMoves += subMachineMoves;
+        stats->tapeGrowth += tape.size() - initialSize;
+        stats->recordHeadOffset(static_cast<std::int64_t>(minPosition) - static_cast<std::int64_t>(statsOrigin));
+        stats->recordHeadOffset(static_cast<std::int64_t>(maxPosition) - static_cast<std::int64_t>(statsOrigin));
+    }
+    if (Ranged) {
+        range->first = std::min(range->first, minPosition);
+        range->last = std::max(range->last, maxPosition);
+    }
+    return status;
+}
+
+void RegularExecution::enableStats(bool enabled) {
+    if (enabled) {
+        stats.emplace();
+        resetStats();
+    } else {
+        stats.reset();
+    }
+}
+
+void RegularExecution::resetStats() {
+    stats->reset(program->getStateCount(), program->getTransitionCount());
+    statsOrigin = tape.getHeadPosition();
+    blockedLeftMoves = 0;
+    calledMoves = 0;
+}
+
+std::optional<ExecutionStats> RegularExecution::getStats() const {
+    if (!stats) {
+        return std::nullopt;
+    }
+    // Per-state hits and head travel follow from the transition counters.
+    std::optional<ExecutionStats> result = stats;
+    const std::uint32_t columnCount = program->getColumnCount();
+    std::uint64_t moves = calledMoves;
+    result->stateHits.assign(program->getStateCount(), 0);
+    for (std::size_t index = 0; index < result->transitionHits.size() && columnCount != 0; ++index) {
+        const std::uint64_t hits = result->transitionHits[index];
+        if (hits == 0) {
+            continue;
+        }
+        result->stateHits[index / columnCount] += hits;
+        const char command = program->transitionAt(index).command;
+        if (command == 'L' || command == 'R') {
+            moves += hits;
+        }
+    }
+    result->headTravel = moves - blockedLeftMoves;
+    return result;
+}
+
+ExecutionStats::Labels RegularExecution::getStatsLabels() const {
+    std::shared_ptr<const CompiledMachine> labelled = program;
+    return {
+            [labelled](std::size_t state) { return std::string(labelled->getStateName(static_cast<std::uint32_t>(state))); },
+            [labelled](std::size_t index) { return labelled->describeTransition(index); }
+    };
+}
@@ -0,0 +1,115 @@
+#ifndef TURING_MACHINE_REGULAREXECUTION_H
+#define TURING_MACHINE_REGULAREXECUTION_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../compiled/CompiledMachine.h"
+#include "../tape/Tape.h"
+#include "../stats/ExecutionStats.h"
+#include "TuringMachine.h"
+
+/**
+ * @class RegularExecution
+ * @brief One run of a compiled regular machine.
+ *
+ * An execution owns only the mutable part of a run: the tape, the head and the current
+ * state. The program is shared and never modified, so any number of executions of the same
+ * machine can run concurrently without copying it.
+ *
+ * A call transition pushes the caller and its return state on the call stack and runs the
+ * sub-machine on the same tape from the current head position; when the sub-machine halts,
+ * the caller resumes in the return state. The call itself takes one step, the return none.
+ */
+class RegularExecution {
+public:
+    using Status = TuringMachine::Status;
+
+    static constexpr std::uint64_t UNLIMITED = TuringMachine::UNLIMITED;
+
+    /// Starts an execution in the initial configuration stored in the program.
+    explicit RegularExecution(std::shared_ptr<const CompiledMachine> program);
+
+    /// Leftmost and rightmost cells the head was on.
+    struct HeadRange {
+        std::size_t first;
+        std::size_t last;
+    };
+
+    /// Runs at most maxSteps transitions.
+    Status run(std::uint64_t maxSteps = UNLIMITED);
+
+    /// Like run(), widening `range` to the cells the head visits, without collecting stats.
+    Status run(std::uint64_t maxSteps, HeadRange& range);
+
+    /// Returns to the initial configuration stored in the program.
+    void reset();
+
+    /// Starts over in the initial state on the given tape.
+    void start(Tape input);
+
+    /// The program the execution was started with, whichever sub-machine it is running.
+    const std::shared_ptr<const CompiledMachine>& getProgram() const { return program; }
+
+    /// The program or sub-machine the current state belongs to.
+    const CompiledMachine& getCurrentProgram() const { return *running; }
+
+    /// Number of sub-machine calls that have not returned yet.
+    std::size_t getCallDepth() const { return callStack.size(); }
+
+    /// Switches to another program, keeping the tape and the head; pending calls are dropped.
+    void setProgram(std::shared_ptr<const CompiledMachine> newProgram, std::uint32_t newState);
+
+    std::uint32_t getState() const { return state; }
+    void setState(std::uint32_t newState) { state = newState; }
+    std::string_view getStateName() const { return running->getStateName(state); }
+
+    Tape& getTape() { return tape; }
+    const Tape& getTape() const { return tape; }
+
+    std::uint64_t getStepCount() const { return steps; }
+
+    /**
+     * Starts or stops collecting ExecutionStats. Enabling clears the counters and takes the
+     * current head position as offset zero. Executions without stats run the plain loop.
+     * Counting costs one counter per step: a few percent on small tables, and around 15-20% once
+     * the counters, as large as the transition table, no longer fit in cache beside it.
+     */
+    void enableStats(bool enabled = true);
+
+    bool hasStats() const { return stats.has_value(); }
+
+    /// A copy of the collected counters with the derived ones filled in, or nullopt when stats are disabled.
+    std::optional<ExecutionStats> getStats() const;
+
+    /// Labels naming the states and transitions of the current program.
+    ExecutionStats::Labels getStatsLabels() const;
+
+private:
+    template<bool Profiled, bool Ranged>
+    Status runLoop(std::uint64_t maxSteps, HeadRange* range);
+
+    void resetStats();
+
+    /// A caller waiting for a sub-machine to halt.
+    struct Frame {
+        const CompiledMachine* program; ///< Kept alive by the program that calls it.
+        std::uint32_t returnState;      ///< State of the caller once the sub-machine halts.
+    };
+
+    std::shared_ptr<const CompiledMachine> program;
+    const CompiledMachine* running;    ///< program, or the sub-machine it called.
+    std::vector<Frame> callStack;      ///< Callers of the running sub-machine, innermost last.
+    Tape tape;
+    std::uint32_t state;
+    std::uint64_t steps;
+    std::optional<ExecutionStats> stats; ///< Per-state hits and head travel are left to getStats().
+    std::size_t statsOrigin = 0;        ///< Head position that stats offsets are relative to.
+    std::uint64_t blockedLeftMoves = 0; ///< Left moves on the first cell, subtracted from the head travel.
+    std::uint64_t calledMoves = 0;      ///< Moves of called sub-machines, which have no transition counters.
+};
+
+#endif //TURING_MACHINE_REGULAREXECUTION_H
@@ -1,14 +1,19 @@
 #include "RegularTuringMachine.h"
+#include "RegularExecution.h"
 #include "../parsers/RegularParser.h"
+#include "../compiled/CompiledMachine.h"
+#include "../tape/TapeCodec.h"
+#include "../trace/Trace.h"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
 
 
-RegularTuringMachine::RegularTuringMachine() {
+RegularTuringMachine::RegularTuringMachine()
+        : execution(std::make_unique<RegularExecution>(CompiledMachine::compile(CompiledMachine::Description()))) {
 }
 
-RegularTuringMachine::RegularTuringMachine(const std::string& fileName) {
+RegularTuringMachine::RegularTuringMachine(const std::string& fileName) : RegularTuringMachine() {
     std::ifstream file(fileName);
     if (!file.is_open()) {
         std::cerr << "Unable to open file: " << fileName << std::endl;
@@ -18,19 +23,25 @@ RegularTuringMachine::RegularTuringMachine(const std::string& fileName) {
     init(file);
 }
 
+RegularTuringMachine::RegularTuringMachine(std::shared_ptr<const CompiledMachine> program)
+        : execution(std::make_unique<RegularExecution>(std::move(program))) {
+}
 
-bool RegularTuringMachine::isValidTape(const std::string& inputTape) {
-    return std::all_of(inputTape.begin(), inputTape.end(), [this](char symbol) {
-        return alphabet.find(symbol) != alphabet.end();
-    });
+RegularTuringMachine::RegularTuringMachine(const RegularTuringMachine& other)
+        : execution(std::make_unique<RegularExecution>(*other.execution)) {
 }
 
-void RegularTuringMachine::setTape(const std::string& tapeString){
-    tape.free();
-    for (char ch : tapeString) {
-        tape.push_back(ch);
+RegularTuringMachine& RegularTuringMachine::operator=(const RegularTuringMachine& other) {
+    if (this != &other) {
+        *execution = *other.execution;
     }
-    currentPosition = tape.begin();
+    return *this;
+}
+
+RegularTuringMachine::~RegularTuringMachine() = default;
+
+void RegularTuringMachine::setTape(const std::string& tapeString){
+    execution->getTape().assign(tapeString);
 }
 
 void RegularTuringMachine::init(std::istream& inputStream) {
@@ -38,69 +49,87 @@ void RegularTuringMachine::init(std::istream& inputStream) {
 
     auto machineConfig = parser.parse();
 
-    this->transitions = std::move(machineConfig->transitions);
-    this->haltingStates = std::move(machineConfig->haltingStates);
-    this->setTape(machineConfig->getTape());
-    this->currentState = machineConfig->currentState;
-    this->states = machineConfig->states;
-    this->alphabet = machineConfig->alphabet;
-    this->currentState = parser.getInitialState();
-    setInitialTapePosition(parser.getInitialTapePosition());
-}
-
-void RegularTuringMachine::setInitialTapePosition(int position) {
-    auto it = tape.begin();
-    while (position > 0){
-        position--;
-        it++;
-    }
-    this->currentPosition = it;
+    bool collectStats = execution->hasStats();
+    *this = *machineConfig;
+    execution->enableStats(collectStats);
+}
+
+std::unique_ptr<TuringMachine> RegularTuringMachine::clone() const {
+    return cloneRegular();
+}
+
+std::unique_ptr<RegularTuringMachine> RegularTuringMachine::cloneRegular() const {
+    return std::make_unique<RegularTuringMachine>(*this);
 }
 
 void RegularTuringMachine::run(const std::string &outputFileName) {
-    while (true) {
-        if (haltingStates.find(currentState) != haltingStates.end()) {
-            break;
-        }
-
-        char currentSymbol = *currentPosition;
-
-        TransitionKey key{currentSymbol, currentState};
-        auto it = transitions.find(key);
-        if (it == transitions.end()) {
-            std::cerr << "Machine reached invalid state: " << currentSymbol << ", " << currentState << std::endl;
-            break;
-        }
-
-        TransitionValue transition = it->second;
-
-        *currentPosition = transition.newSymbol;
-
-        currentState = transition.newState;
-
-        if (transition.command == 'L') {
-            if (currentPosition != tape.begin()) {
-                --currentPosition;
-            }
-        } else if (transition.command == 'R') {
-            ++currentPosition;
-            if (currentPosition == tape.end()) {
-                // Append a blank space if at the end of the tape
-                tape.push_back(' ');
-                currentPosition = tape.last();
-            }
-        }
+    if (execution->run() == RegularExecution::Status::NoTransition) {
+        const Tape& tape = execution->getTape();
+        char currentSymbol = tape.empty() ? Tape::BLANK : tape.read();
+        std::cerr << "Machine reached invalid state: " << currentSymbol << ", " << execution->getStateName() << std::endl;
     }
 
     outputTape(outputFileName);
 }
 
+void RegularTuringMachine::setInput(const std::string& tape) {
+    execution->start(Tape(tape, execution->getProgram()->getInitialHead()));
+}
+
+void RegularTuringMachine::setInput(std::istream& tape) {
+    execution->getTape() = Tape(); // Never hold the previous tape and the new one at once.
+    Tape input;
+    TapeCodec::read(tape, input, execution->getProgram()->getInitialHead());
+    execution->start(std::move(input));
+}
+
+void RegularTuringMachine::setInputFile(const std::string& fileName) {
+    execution->getTape() = Tape(); // Never hold the previous tape and the new one at once.
+    Tape input;
+    TapeCodec::readFile(fileName, input, execution->getProgram()->getInitialHead());
+    execution->start(std::move(input));
+}
+
+void RegularTuringMachine::mapInputFile(const std::string& fileName) {
+    execution->getTape() = Tape(); // Never hold the previous tape and the new one at once.
+    Tape input;
+    input.map(TapeSource::map(fileName), execution->getProgram()->getInitialHead());
+    execution->start(std::move(input));
+}
+
+TuringMachine::Status RegularTuringMachine::advance(std::uint64_t maxSteps) {
+    return execution->run(maxSteps);
+}
+
+std::string RegularTuringMachine::getOutput() const {
+    return execution->getTape().toString();
+}
+
+std::size_t RegularTuringMachine::getTapeSize() const {
+    return execution->getTape().size();
+}
+
+std::uint64_t RegularTuringMachine::getStepCount() const {
+    return execution->getStepCount();
+}
+
+std::size_t RegularTuringMachine::getHeadPosition() const {
+    return execution->getTape().getHeadPosition();
+}
+
+std::string RegularTuringMachine::getStateName() const {
+    return std::string(execution->getStateName());
+}
+
+void RegularTuringMachine::forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const {
+    visit(*getProgram());
+}
+
 void RegularTuringMachine::outputTape(const std::string &outputFileName){
+    TM_TRACE_SCOPE("output");
     std::ofstream outFile(outputFileName, std::ios::out);
     if (outFile.is_open()) {
-        for (auto it = tape.begin(); it != tape.end(); ++it) {
-            outFile << *it;
-        }
+        execution->getTape().writeTo(outFile);
         outFile.close();
         std::cout << "Tape successfully written to " << outputFileName << std::endl;
     } else {
@@ -110,35 +139,20 @@ void RegularTuringMachine::outputTape(const std::string &outputFileName){
 
 
 std::string RegularTuringMachine::getTape() {
-    std::string tapeString;
-    for (auto it = tape.begin(); it != tape.end(); ++it) {
-        tapeString += *it;
-    }
-    return tapeString;
+    return execution->getTape().toString();
 }
 int RegularTuringMachine::getCurrentPosition() {
-    int pos = 0;
-    for (auto it = tape.begin(); it != currentPosition; ++it) {
-        ++pos;
-    }
-    return pos;
+    return static_cast<int>(execution->getTape().getHeadPosition());
 }
 
 void RegularTuringMachine::setCurrentPosition(int position) {
-    currentPosition = tape.begin();
-    for (int i = 0; i < position && currentPosition != tape.end(); ++i) {
-        ++currentPosition;
-    }
+    execution->getTape().setHeadPosition(static_cast<std::size_t>(std::max(position, 0)));
 }
 
 bool RegularTuringMachine::isValidCommand(const char command) {
     return command == 'L' || command == 'R' || command == 'S';
 }
 
-void RegularTuringMachine::processTape(const std::string& tapeData) {
-    setTape(tapeData); // Set the tape using the provided data
-}
-
 std::size_t RegularTuringMachine::TransitionKeyHash::operator()(const TransitionKey& key) const {
     return std::hash<std::string>()(key.currentState) ^ std::hash<char>()(key.currentSymbol);
 }
@@ -147,30 +161,82 @@ bool RegularTuringMachine::TransitionKey::operator==(const TransitionKey& other)
     return currentSymbol == other.currentSymbol && currentState == other.currentState;
 }
 
+template<typename Update>
+void RegularTuringMachine::updateDescription(Update update) {
+    // Programs are immutable: rebuild the description, change it and compile a new program.
+    // The tape and the head stay as they are; the current state is kept by name.
+    CompiledMachine::Description description = execution->getProgram()->decompile();
+    std::string currentState(execution->getStateName());
+    update(description);
+
+    auto program = CompiledMachine::compile(description);
+    std::uint32_t state = program->findState(currentState);
+    execution->setProgram(std::move(program), state);
+}
+
 void RegularTuringMachine::setTransitions(const std::unordered_map<TransitionKey, TransitionValue, TransitionKeyHash>& transitions) {
-    this->transitions = transitions;
+    updateDescription([&transitions](CompiledMachine::Description& description) {
+        description.transitions = transitions;
+    });
 }
 
 void RegularTuringMachine::setHaltingStates(const std::set<std::string>& haltingStates) {
-    this->haltingStates = haltingStates;
+    updateDescription([&haltingStates](CompiledMachine::Description& description) {
+        description.haltingStates = haltingStates;
+    });
 }
 
 void RegularTuringMachine::setStates(const std::set<std::string>& states) {
-    this->states = states;
+    updateDescription([&states](CompiledMachine::Description& description) {
+        description.states = states;
+    });
 }
 
 
 void RegularTuringMachine::setAlphabet(const std::set<char>& alphabet) {
-    this->alphabet = alphabet;
+    updateDescription([&alphabet](CompiledMachine::Description& description) {
+        description.alphabet = alphabet;
+    });
+}
+
+const std::shared_ptr<const CompiledMachine>& RegularTuringMachine::getProgram() const {
+    return execution->getProgram();
+}
+
+RegularExecution RegularTuringMachine::createExecution() const {
+    return *execution;
+}
+
+RegularExecution& RegularTuringMachine::getExecution() {
+    return *execution;
+}
+
+const RegularExecution& RegularTuringMachine::getExecution() const {
+    return *execution;
+}
+
+void RegularTuringMachine::enableStats(bool enabled) {
+    execution->enableStats(enabled);
+}
+
+std::optional<ExecutionStats> RegularTuringMachine::getStats() const {
+    return execution->getStats();
+}
+
+void RegularTuringMachine::writeStats(std::ostream& out, std::size_t top) const {
+    if (std::optional<ExecutionStats> stats = execution->getStats()) {
+        stats->writeJson(out, execution->getStatsLabels(), top);
+    }
 }
 
 void RegularTuringMachine::setCurrentState(const std::string& state) {
-    if (states.find(state) != states.end()) {
-        currentState = state;
+    std::uint32_t id = execution->getProgram()->findState(state);
+    if (id != CompiledMachine::NO_STATE) {
+        execution->setState(id);
     } else {
         std::cerr << "Invalid state: " << state << std::endl;
     }
 }
 std::string RegularTuringMachine::getCurrentState() {
-    return currentState;
-}
\ No newline at end of file
+    return std::string(execution->getStateName());
+}
@@ -5,16 +5,51 @@
 #include <unordered_map>
 #include <string>
 #include <set>
+#include <memory>
+#include <optional>
+#include <ostream>
 #include "TuringMachine.h"
 #include "../tape/DoublyLinkedList.h"
-
+#include "../stats/ExecutionStats.h"
+
+class CompiledMachine;
+class RegularExecution;
+
+/**
+ * @class RegularTuringMachine
+ * @brief A single-tape machine made of a shared compiled program and one execution of it.
+ *
+ * The program (states, alphabet, transitions and halting states) is immutable and shared
+ * between copies and clones; the machine itself owns only its RegularExecution, that is the
+ * tape, the head and the current state. The description setters compile a new program.
+ */
 class RegularTuringMachine : public TuringMachine {
 public:
     RegularTuringMachine();
     RegularTuringMachine(const std::string& fileName);
+    explicit RegularTuringMachine(std::shared_ptr<const CompiledMachine> program);
+    RegularTuringMachine(const RegularTuringMachine& other);
+    RegularTuringMachine& operator=(const RegularTuringMachine& other);
+    ~RegularTuringMachine() override;
 
     virtual void init(std::istream& inputStream) override;
     virtual void run(const std::string& outputFileName) override;
+    std::unique_ptr<TuringMachine> clone() const override;
+    std::unique_ptr<RegularTuringMachine> cloneRegular() const;
+    void setInput(const std::string& tape) override;
+    /// Like setInput(), streaming the first line of a stream, or a TapeCodec-compressed tape, straight onto the tape.
+    void setInput(std::istream& tape);
+    /// Like setInput(), streaming the first line of a file, or a TapeCodec-compressed tape, straight onto the tape.
+    void setInputFile(const std::string& fileName);
+    /// Like setInputFile(), mapping the file and loading its blocks only as the head reaches them.
+    void mapInputFile(const std::string& fileName);
+    Status advance(std::uint64_t maxSteps = UNLIMITED) override;
+    std::string getOutput() const override;
+    std::size_t getTapeSize() const override;
+    std::uint64_t getStepCount() const override;
+    std::size_t getHeadPosition() const override;
+    std::string getStateName() const override;
+    void forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const override;
 
     std::string getTape();
     void setTape(const std::string& tape);
@@ -45,7 +80,8 @@ public:
     struct TransitionValue {
         char newSymbol; ///< The symbol to write on the tape.
         std::string newState; ///< The new state to transition to.
-        char command; ///< The movement command ('L' for left, 'R' for right, 'S' for stay).
+        char command; ///< The movement command ('L' for left, 'R' for right, 'S' for stay), or 'C' for a call.
+        std::string call{}; ///< Sub-machine run by a 'C' transition before resuming in newState.
     };
 
 
@@ -56,25 +92,32 @@ public:
 
     void setTransitions(const std::unordered_map<TransitionKey, TransitionValue, TransitionKeyHash> &transitions);
 
-private:
-    // Private member variables
-    std::set<std::string> states;
-    std::set<std::string> haltingStates;
-    std::unordered_map<TransitionKey, TransitionValue, TransitionKeyHash> transitions;
-    std::set<char> alphabet;
+    /// The shared, immutable program of this machine.
+    const std::shared_ptr<const CompiledMachine>& getProgram() const;
 
-    std::string currentState;
-    DoublyLinkedList<char> tape;
-    typename DoublyLinkedList<char>::Iterator currentPosition;
+    /// Creates a new execution of the shared program, starting from this machine's configuration.
+    RegularExecution createExecution() const;
 
-    // Private methods including error checks and utility functions
+    RegularExecution& getExecution();
+    const RegularExecution& getExecution() const;
+
+    /// Starts or stops collecting ExecutionStats for the following runs.
+    void enableStats(bool enabled = true);
+    /// A copy of the collected counters, or nullopt when stats are disabled.
+    std::optional<ExecutionStats> getStats() const;
+    /// Writes the collected counters as JSON, listing at most `top` transitions when top is not zero.
+    void writeStats(std::ostream& out, std::size_t top = 0) const;
+
+    /// Writes the tape to a file, as run() does when the machine stops.
     void outputTape(const std::string& outFile);
-    bool isValidTape(const std::string& tape);
-    static bool isValidCommand(const char command);
-    void processTape(const std::string& tapeData);
 
-    // Additional private methods
-    void setInitialTapePosition(int position);
+private:
+    std::unique_ptr<RegularExecution> execution;
+
+    // Private methods including error checks and utility functions
+    static bool isValidCommand(const char command);
+    template<typename Update>
+    void updateDescription(Update update);
 };
 
 
@@ -0,0 +1,106 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include "SharedTapeTuringMachine.h"
+#include "../tape/Tape.h"
+#include "../trace/Trace.h"
+
+void SharedTapeTuringMachine::start(const std::string& tape) {
+    execution = std::make_unique<RegularExecution>(getProgram(0));
+    setInput(tape);
+}
+
+void SharedTapeTuringMachine::copyRunTo(SharedTapeTuringMachine& copy) const {
+    if (execution) {
+        copy.execution = std::make_unique<RegularExecution>(*execution);
+    }
+    copy.current = current;
+    copy.result = result;
+}
+
+void SharedTapeTuringMachine::run(const std::string& outputFileName) {
+    if (!execution) {
+        std::cerr << "Error: Machine not initialized properly." << std::endl;
+        return;
+    }
+    if (advance() == Status::NoTransition) {
+        std::cerr << "Machine reached invalid state in " << describeCurrent() << std::endl;
+    }
+
+    TM_TRACE_SCOPE("output");
+    std::ofstream outFile(outputFileName, std::ios::out);
+    if (outFile.is_open()) {
+        execution->getTape().writeTo(outFile);
+        std::cout << "Tape successfully written to " << outputFileName << std::endl;
+    } else {
+        std::cerr << "Unable to open or create file: " << outputFileName << std::endl;
+    }
+}
+
+void SharedTapeTuringMachine::setInput(const std::string& tape) {
+    const auto& program = getProgram(0);
+    execution->setProgram(program, program->getInitialState());
+    execution->start(Tape(tape, program->getInitialHead()));
+    current = 0;
+    result.reset();
+}
+
+TuringMachine::Status SharedTapeTuringMachine::advance(std::uint64_t maxSteps) {
+    if (result) {
+        return *result;
+    }
+    std::uint64_t remaining = maxSteps;
+    std::size_t idleHops = 0;
+    while (true) {
+        const std::uint64_t before = execution->getStepCount();
+        Status status = execution->run(remaining);
+        const std::uint64_t taken = execution->getStepCount() - before;
+        if (remaining != UNLIMITED) {
+            remaining -= taken;
+        }
+        if (status == Status::Running) {
+            return status;
+        }
+        std::optional<std::size_t> following = next(status);
+        if (!following) {
+            result = status;
+            return status;
+        }
+
+        // Without a step the tape is unchanged, so more hops than programs never end.
+        idleHops = taken == 0 ? idleHops + 1 : 0;
+        if (idleHops > getProgramCount()) {
+            throw std::runtime_error("Machine cycles through its programs without taking a step");
+        }
+
+        // The next program takes over the tape and head where this one left them.
+        current = *following;
+        execution->setProgram(getProgram(current), getProgram(current)->getInitialState());
+    }
+}
+
+std::string SharedTapeTuringMachine::getOutput() const {
+    return execution->getTape().toString();
+}
+
+std::size_t SharedTapeTuringMachine::getTapeSize() const {
+    return execution->getTape().size();
+}
+
+std::uint64_t SharedTapeTuringMachine::getStepCount() const {
+    return execution->getStepCount();
+}
+
+std::size_t SharedTapeTuringMachine::getHeadPosition() const {
+    return execution->getTape().getHeadPosition();
+}
+
+std::string SharedTapeTuringMachine::getStateName() const {
+    return std::string(execution->getStateName());
+}
+
+void SharedTapeTuringMachine::forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const {
+    for (std::size_t i = 0; i < getProgramCount(); ++i) {
+        visit(*getProgram(i));
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef TURING_MACHINE_SHAREDTAPETURINGMACHINE_H
+#define TURING_MACHINE_SHAREDTAPETURINGMACHINE_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include "RegularExecution.h"
+#include "TuringMachine.h"
+#include "../compiled/CompiledMachine.h"
+
+/**
+ * @class SharedTapeTuringMachine
+ * @brief Regular programs taking turns on one tape: the base of pipelines and machine graphs.
+ *
+ * All programs share one RegularExecution. When the running program stops, the next one
+ * takes over the tape and head where it left them, so nothing is copied between programs
+ * and the output is written once. Subclasses only choose which program runs next.
+ */
+class SharedTapeTuringMachine : public TuringMachine {
+public:
+    void run(const std::string& outputFileName) override;
+    void setInput(const std::string& tape) override;
+    Status advance(std::uint64_t maxSteps = UNLIMITED) override;
+    std::string getOutput() const override;
+    std::size_t getTapeSize() const override;
+    std::uint64_t getStepCount() const override;
+    std::size_t getHeadPosition() const override;
+    std::string getStateName() const override;
+    void forEachProgram(const std::function<void(const CompiledMachine&)>& visit) const override;
+
+protected:
+    virtual std::size_t getProgramCount() const = 0;
+    virtual const std::shared_ptr<const CompiledMachine>& getProgram(std::size_t index) const = 0;
+
+    /**
+     * Called when the running program stopped with `status`, Halted or NoTransition. Returns
+     * the program that takes over, or nullopt to stop with `status`, which may be changed.
+     */
+    virtual std::optional<std::size_t> next(Status& status) = 0;
+
+    /// The running program in messages, e.g. "stage 2".
+    virtual std::string describeCurrent() const = 0;
+
+    /// Creates the execution and starts the first program on the given tape.
+    void start(const std::string& tape);
+
+    /// Copies the execution and the progress of the run into a clone.
+    void copyRunTo(SharedTapeTuringMachine& copy) const;
+
+    std::unique_ptr<RegularExecution> execution; ///< The shared tape, head and state.
+    std::size_t current = 0;                     ///< Index of the program advance() is running.
+    std::optional<Status> result;                ///< How the machine stopped, once it has.
+};
+
+#endif //TURING_MACHINE_SHAREDTAPETURINGMACHINE_H
@@ -1,13 +1,88 @@
 #ifndef TURING_MACHINE_TURINGMACHINE_H
 #define TURING_MACHINE_TURINGMACHINE_H
 
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <memory>
 #include <string>
 
+class CompiledMachine;
+
 class TuringMachine {
 public:
+    enum class Status {
+        Running,      ///< The step budget ran out before the machine stopped.
+        Halted,       ///< The machine reached a halting state.
+        NoTransition  ///< No transition is defined for the current state and symbol.
+    };
+
+    static constexpr std::uint64_t UNLIMITED = std::numeric_limits<std::uint64_t>::max();
+
+    virtual ~TuringMachine() = default;
+
     virtual void init(std::istream& inputStream) = 0;
 
+    /**
+     * As init(), for a description read from a file in `directory`: the files its USE lines
+     * name are relative to it. Machines without USE lines read it like init() does.
+     */
+    virtual void initFromFile(std::istream& inputStream, const std::string& /*directory*/) { init(inputStream); }
+
     virtual void run(const std::string& outputFileName) = 0;
+
+    /**
+     * Creates an independent instance in the same configuration. The compiled program
+     * is shared with this machine; only the tape and the execution state are copied.
+     */
+    virtual std::unique_ptr<TuringMachine> clone() const = 0;
+
+    /**
+     * Replaces the input tape, written as in the description files, and returns to the
+     * initial state. The head starts where the description format puts it.
+     */
+    virtual void setInput(const std::string& tape) = 0;
+
+    /**
+     * Runs at most maxSteps transitions, continuing where the previous call stopped.
+     * Unlike run(), nothing is written to disk.
+     */
+    virtual Status advance(std::uint64_t maxSteps = UNLIMITED) = 0;
+
+    /// The tape as run() would write it.
+    virtual std::string getOutput() const = 0;
+
+    /// Cells on the tape, that is getOutput().size() without building the string.
+    virtual std::size_t getTapeSize() const = 0;
+
+    /// Transitions taken since the machine was initialised or given a new input.
+    virtual std::uint64_t getStepCount() const = 0;
+
+    /// Index of the cell under the head in getOutput(); the first head of a multi-tape machine.
+    virtual std::size_t getHeadPosition() const = 0;
+
+    /// Name of the current state.
+    virtual std::string getStateName() const = 0;
+
+    /**
+     * Calls `visit` with every compiled program the machine runs, those of its components
+     * included, always in the same order. Machines without compiled programs visit none.
+     */
+    virtual void forEachProgram(const std::function<void(const CompiledMachine&)>&) const {}
+
+protected:
+    /// Advances one stage of a composite machine, charging its steps to the budget and the total.
+    static Status advanceStage(TuringMachine& stage, std::uint64_t& remaining, std::uint64_t& steps) {
+        const std::uint64_t before = stage.getStepCount();
+        const Status status = stage.advance(remaining);
+        const std::uint64_t taken = stage.getStepCount() - before;
+        steps += taken;
+        if (remaining != UNLIMITED) {
+            remaining -= taken;
+        }
+        return status;
+    }
 };
 
 
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include "PrefixMemo.h"
+
+PrefixMemo::PrefixMemo(std::shared_ptr<const CompiledMachine> program) : PrefixMemo(std::move(program), Options()) {
+}
+
+PrefixMemo::PrefixMemo(std::shared_ptr<const CompiledMachine> program, Options options)
+        : program(std::move(program)), options(options) {
+    if (this->program->hasCalls()) {
+        // A snapshot holds no call stack.
+        throw std::invalid_argument("Prefix memoisation needs a machine without sub-machine calls");
+    }
+    if (this->options.stride == 0) {
+        this->options.stride = 1;
+    }
+}
+
+std::size_t PrefixMemo::findDeepest(std::string_view input, std::uint64_t maxSteps, Snapshot& found) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const Node* node = &root;
+    const Snapshot* deepest = nullptr;
+    std::size_t depth = 0;
+    std::size_t deepestDepth = 0;
+    while (depth + options.stride <= input.size()) {
+        auto child = node->children.find(input.substr(depth, options.stride));
+        if (child == node->children.end()) {
+            break;
+        }
+        node = child->second.get();
+        depth += options.stride;
+        if (node->snapshot) {
+            if (node->snapshot->steps > maxSteps) {
+                break;
+            }
+            deepest = &*node->snapshot;
+            deepestDepth = depth;
+            if (deepest->status != TuringMachine::Status::Running) {
+                break; // The run ended inside this prefix; nothing deeper is cached.
+            }
+        }
+    }
+    if (deepest) {
+        found = *deepest;
+    }
+    return deepestDepth;
+}
+
+void PrefixMemo::insert(std::string_view input, std::vector<std::pair<std::size_t, Snapshot>>& snapshots) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    Node* node = &root;
+    std::size_t depth = 0;
+    for (auto& [snapshotDepth, snapshot] : snapshots) {
+        while (depth < snapshotDepth) {
+            std::string_view chunk = input.substr(depth, options.stride);
+            auto child = node->children.find(chunk);
+            if (child == node->children.end()) {
+                if (bytes + snapshot.cells.size() + chunk.size() > options.maxBytes) {
+                    return;
+                }
+                bytes += chunk.size() + sizeof(Node);
+                child = node->children.emplace(std::string(chunk), std::make_unique<Node>()).first;
+            }
+            node = child->second.get();
+            depth += options.stride;
+        }
+        if (!node->snapshot) {
+            if (bytes + snapshot.cells.size() > options.maxBytes) {
+                return;
+            }
+            bytes += snapshot.cells.size();
+            ++snapshotCount;
+            node->snapshot = std::move(snapshot);
+        }
+    }
+}
+
+PrefixMemo::Result PrefixMemo::run(std::string_view input, std::uint64_t maxSteps) {
+    const CompiledMachine& machine = *program;
+    const std::uint32_t stateCount = machine.getStateCount();
+    const std::size_t stride = options.stride;
+    ++runs;
+
+    // The tape as Tape(input, initialHead) would lay it out. A flat buffer lets the cached
+    // prefixes be copied in and out in one go.
+    Result result;
+    std::string& cells = result.tape;
+    cells.assign(input);
+    std::size_t head = machine.getInitialHead();
+    if (head >= cells.size()) {
+        cells.resize(head + 1, Tape::BLANK);
+    }
+    std::uint32_t state = machine.getInitialState();
+    std::uint64_t steps = 0;
+
+    Snapshot cached;
+    const std::size_t resumeDepth = findDeepest(input, maxSteps, cached);
+    if (resumeDepth != 0) {
+        cells.replace(0, resumeDepth, cached.cells);
+        state = cached.state;
+        steps = cached.steps;
+        head = cached.head;
+        if (head == cells.size()) {
+            cells.push_back(Tape::BLANK); // Arrived just past the end of the input.
+        }
+        result.skippedSteps = steps;
+        skippedSteps += steps;
+        if (cached.status != TuringMachine::Status::Running) {
+            ++replayed;
+            result.status = cached.status;
+            result.steps = steps;
+            result.head = head;
+            return result;
+        }
+        ++resumed;
+    }
+
+    // Cells reachable through the trie; snapshots are taken when the head first arrives at a
+    // multiple of the stride beyond the initial head.
+    const std::size_t lastDepth = std::min(input.size(), options.maxDepth) / stride * stride;
+    std::size_t nextDepth = std::max(resumeDepth, head / stride * stride) + stride;
+    std::size_t reached = head;
+    std::vector<std::pair<std::size_t, Snapshot>> snapshots;
+
+    std::uint64_t remaining = maxSteps - steps;
+    TuringMachine::Status status = TuringMachine::Status::Halted;
+    if (state >= stateCount) {
+        status = TuringMachine::Status::NoTransition;
+    }
+    while (status == TuringMachine::Status::Halted && !machine.isHalting(state)) {
+        if (remaining == 0) {
+            status = TuringMachine::Status::Running;
+            break;
+        }
+        const CompiledTransition& transition = machine.lookup(state, cells[head]);
+        if (transition.newState >= stateCount) {
+            status = TuringMachine::Status::NoTransition;
+            break;
+        }
+
+        cells[head] = transition.newSymbol;
+        state = transition.newState;
+        ++steps;
+        --remaining;
+        if (transition.command == 'L') {
+            if (head > 0) {
+                --head;
+            }
+        } else if (transition.command == 'R') {
+            if (++head == cells.size()) {
+                cells.push_back(Tape::BLANK);
+            }
+            if (head > reached) {
+                reached = head;
+                if (head == nextDepth && head <= lastDepth) {
+                    snapshots.emplace_back(head, Snapshot{TuringMachine::Status::Running, state, steps, head,
+                                                          cells.substr(0, head)});
+                    nextDepth += stride;
+                }
+            }
+        }
+    }
+
+    if (status != TuringMachine::Status::Running) {
+        // The run read only the cells up to `reached`.
+        const std::size_t depth = (reached / stride + 1) * stride;
+        if (depth <= lastDepth) {
+            snapshots.emplace_back(depth, Snapshot{status, state, steps, head, cells.substr(0, depth)});
+        }
+    }
+    if (!snapshots.empty()) {
+        insert(input, snapshots);
+    }
+
+    result.status = status;
+    result.steps = steps;
+    result.head = head;
+    return result;
+}
+
+PrefixMemo::Stats PrefixMemo::getStats() const {
+    Stats stats;
+    stats.runs = runs;
+    stats.resumed = resumed;
+    stats.replayed = replayed;
+    stats.skippedSteps = skippedSteps;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    stats.snapshots = snapshotCount;
+    stats.bytes = bytes;
+    return stats;
+}
+
+void PrefixMemo::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    root.children.clear();
+    root.snapshot.reset();
+    snapshotCount = 0;
+    bytes = 0;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file PrefixMemo.h
+ * @brief Memoised execution of a regular machine on inputs that share prefixes.
+ */
+#ifndef TURING_MACHINE_PREFIXMEMO_H
+#define TURING_MACHINE_PREFIXMEMO_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "../compiled/CompiledMachine.h"
+#include "../machines/TuringMachine.h"
+#include "../tape/Tape.h"
+
+/**
+ * @class PrefixMemo
+ * @brief Runs one compiled regular machine on many inputs, resuming from cached configurations.
+ *
+ * Until the head first reaches cell k, a run has read nothing but the first k cells of its
+ * input, so the configuration at that moment is the same for every input starting with
+ * those cells. Such configurations are cached every `stride` cells in a trie keyed by the
+ * input prefix, and a later run resumes from the deepest one its input matches. A run that
+ * halts or gets stuck without reaching cell k is cached the same way, so repeating it costs
+ * one lookup. This holds for any machine; how much it saves depends on how far the machine
+ * gets through the prefix before it needs the rest of the input. The memo runs on a flat copy
+ * of the tape rather than a Tape, so a resumed run costs a copy of the prefix, not a rebuild.
+ *
+ * Runs may be made from several threads at once.
+ */
+class PrefixMemo {
+public:
+    struct Options {
+        std::size_t stride = 64;                 ///< Cells between cached configurations.
+        std::size_t maxDepth = 1 << 16;          ///< No configuration is cached beyond this cell.
+        std::size_t maxBytes = 64 << 20;         ///< Memory for cached tapes; nothing is added beyond it.
+    };
+
+    struct Result {
+        TuringMachine::Status status = TuringMachine::Status::Running;
+        std::uint64_t steps = 0;                 ///< Steps of the whole run, skipped ones included.
+        std::uint64_t skippedSteps = 0;          ///< Steps replayed from the cache.
+        std::string tape;                        ///< The final tape, as getOutput() writes it.
+        std::size_t head = 0;                    ///< The final head position.
+    };
+
+    struct Stats {
+        std::uint64_t runs = 0;
+        std::uint64_t resumed = 0;               ///< Runs that started from a cached configuration.
+        std::uint64_t replayed = 0;              ///< Runs whose whole outcome came from the cache.
+        std::uint64_t skippedSteps = 0;
+        std::size_t snapshots = 0;
+        std::size_t bytes = 0;
+    };
+
+    /// Throws std::invalid_argument for programs that call sub-machines.
+    explicit PrefixMemo(std::shared_ptr<const CompiledMachine> program);
+    PrefixMemo(std::shared_ptr<const CompiledMachine> program, Options options);
+
+    /**
+     * Runs the machine from its initial state on a tape written as in the description files,
+     * for at most maxSteps steps; the result is the same as without the memo.
+     */
+    Result run(std::string_view input, std::uint64_t maxSteps = TuringMachine::UNLIMITED);
+
+    Stats getStats() const;
+
+    /// Drops every cached configuration.
+    void clear();
+
+private:
+    /// A configuration cached at the node of the first `depth` input cells.
+    struct Snapshot {
+        TuringMachine::Status status;  ///< Running when the head arrived at cell `depth`.
+        std::uint32_t state;
+        std::uint64_t steps;
+        std::size_t head;
+        std::string cells;             ///< The first `depth` cells of the tape at that point.
+    };
+
+    struct Node {
+        std::optional<Snapshot> snapshot;
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> children; ///< Keyed by the next `stride` cells.
+    };
+
+    /// Copies the deepest snapshot matching the input within maxSteps; returns its depth, or 0.
+    std::size_t findDeepest(std::string_view input, std::uint64_t maxSteps, Snapshot& found) const;
+    void insert(std::string_view input, std::vector<std::pair<std::size_t, Snapshot>>& snapshots);
+
+    std::shared_ptr<const CompiledMachine> program;
+    Options options;
+    mutable std::shared_mutex mutex;
+    Node root;
+    std::size_t snapshotCount = 0;
+    std::size_t bytes = 0;
+    std::atomic<std::uint64_t> runs{0};
+    std::atomic<std::uint64_t> resumed{0};
+    std::atomic<std::uint64_t> replayed{0};
+    std::atomic<std::uint64_t> skippedSteps{0};
+};
+
+#endif //TURING_MACHINE_PREFIXMEMO_H
@@ -1,6 +1,7 @@
 #include <limits>
 #include <sstream>
 #include "MultitapeParser.h"
+#include "../trace/Trace.h"
 #include <sstream>
 #include <string>
 #include <vector>
@@ -23,11 +24,11 @@ DoublyLinkedList<char> MultiTapeMachineParser::getCombinedTape(const std::string
     return tapeList;
 }
 DoublyLinkedList<char> MultiTapeMachineParser::getCombinedTape() const {
-    DoublyLinkedList<char> tapeList;
-    for (char ch : combinedTape) {
-        tapeList.push_back(ch);
-    }
-    return tapeList;
+    return combinedTapeList;
+}
+
+DoublyLinkedList<char> MultiTapeMachineParser::takeCombinedTape() {
+    return std::move(combinedTapeList);
 }
 
 
@@ -65,6 +66,7 @@ const std::vector<typename DoublyLinkedList<char>::Iterator>& MultiTapeMachinePa
     return this->initialTapePositions;
 }
 std::unique_ptr<MultiTapeTuringMachine> MultiTapeMachineParser::parse() {
+    TM_TRACE_SCOPE("parse");
     // Parse transitions, halting states, and tapes
     this->transitions = this->parseTransitions();
     this->haltingStates = this->parseHaltingStates();
@@ -108,23 +110,18 @@ std::set<std::string> MultiTapeMachineParser::parseHaltingStates() {
     return haltingStates;
 }
 
-void MultiTapeMachineParser::initializeIterators(const DoublyLinkedList<char>& combinedTapeList,
-                                                 const std::vector<std::string>& tapes) {
-    // Convert each tape to a DoublyLinkedList and store the start iterator of each
+void MultiTapeMachineParser::initializeIterators() {
+    // The first head starts on the first cell, every other head right after its '#' separator
     initialTapePositions.clear();
 
     auto it = combinedTapeList.begin();
-    for (const auto& tape : tapes) {
+    if (it != combinedTapeList.end()) {
         initialTapePositions.push_back(it);
-
-        // Move iterator to the end of the current tape segment
-        for (size_t i = 0; i < tape.length(); ++i) {
-            ++it;
-        }
-
-        // Skip the separator (assuming one character like '#')
-        if (it != combinedTapeList.end()) {
-            ++it;
+    }
+    for (; it != combinedTapeList.end(); ++it) {
+        if (*it == '#') {
+            auto next = it;
+            initialTapePositions.push_back(++next);
         }
     }
 }
@@ -132,23 +129,24 @@ void MultiTapeMachineParser::initializeIterators(const DoublyLinkedList<char>& c
 
 std::string MultiTapeMachineParser::parseTapes() {
     std::string combinedTape;
-    std::vector<std::string> tapes;
     std::string line;
    // int tapeCount;
    // inputStream >> tapeCount; // Read the number of tapes
 
     // Combine tapes using a separator
     while (std::getline(inputStream, line)) {
-        tapes.push_back(line); // Store individual tapes for iterator initialization
+        if (line.empty()) {
+            continue;
+        }
         if (!combinedTape.empty()) {
             line[0] = '#'; // Separator
         }
-        tapes.push_back(line);
         combinedTape += line;
     }
 
-    // Initialize iterators based on the combined tape
-    initializeIterators(getCombinedTape(combinedTape), tapes);
+    // Build the tape once; the iterators point into it and survive moving it out
+    combinedTapeList = getCombinedTape(combinedTape);
+    initializeIterators();
 
     return combinedTape;
 }
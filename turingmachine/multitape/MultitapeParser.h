@@ -20,6 +20,8 @@ public:
     const std::unordered_map<MultiTapeTuringMachine::TransitionKey, MultiTapeTuringMachine::TransitionValue, MultiTapeTuringMachine::TransitionKeyHash>& getTransitions() const;
     const std::set<std::string>& getHaltingStates() const;
     DoublyLinkedList<char> getCombinedTape() const;
+    /// Moves the parsed tape out of the parser; the initial tape positions stay valid.
+    DoublyLinkedList<char> takeCombinedTape();
     const std::vector<typename DoublyLinkedList<char>::Iterator>& getInitialTapePositions() const;
 
     const std::set<std::string> getAlphabetCombinations() const;
@@ -33,11 +35,12 @@ private:
     std::set<std::string> haltingStates;
     std::unordered_map<MultiTapeTuringMachine::TransitionKey, MultiTapeTuringMachine::TransitionValue, MultiTapeTuringMachine::TransitionKeyHash> transitions;
     std::vector<typename DoublyLinkedList<char>::Iterator> initialTapePositions;
+    DoublyLinkedList<char> combinedTapeList;
 
     std::unordered_map<MultiTapeTuringMachine::TransitionKey, MultiTapeTuringMachine::TransitionValue, MultiTapeTuringMachine::TransitionKeyHash>
     parseTransitions();
 
-    void initializeIterators(const DoublyLinkedList<char> &combinedTapeList, const std::vector<std::string> &tapes);
+    void initializeIterators();
 
     DoublyLinkedList<char> getCombinedTape(const std::string &currTape) const;
 };
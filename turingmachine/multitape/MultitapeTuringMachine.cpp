@@ -8,23 +8,37 @@
  */
 #include "MultitapeTuringMachine.h"
 #include "MultitapeParser.h"
+#include "../trace/Trace.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
+namespace {
 
-MultiTapeTuringMachine::MultiTapeTuringMachine() {}
+/// Index of a cell in the combined tape; only used when a trace sample is taken.
+std::uint64_t cellIndex(const DoublyLinkedList<char>& tape, DoublyLinkedList<char>::Iterator cell) {
+    std::uint64_t index = 0;
+    for (auto it = tape.begin(); it != tape.end() && it != cell; ++it) {
+        ++index;
+    }
+    return index;
+}
+
+}
 
-MultiTapeTuringMachine::MultiTapeTuringMachine(std::istream& inputStream) {
+
+MultiTapeTuringMachine::MultiTapeTuringMachine() : program(std::make_shared<Program>()) {}
+
+MultiTapeTuringMachine::MultiTapeTuringMachine(std::istream& inputStream) : program(std::make_shared<Program>()) {
     init(inputStream);
 }
 
 
 void MultiTapeTuringMachine::outputTape(std::ofstream& outFile) const {
-    for (const auto& it : tape) {
-        outFile << it;
-    }
+    TM_TRACE_SCOPE("output");
+    writeTape(outFile);
 }
 
 void MultiTapeTuringMachine::init(std::istream& inputStream) {
@@ -32,43 +46,115 @@ void MultiTapeTuringMachine::init(std::istream& inputStream) {
     // parser.parse() should fill transitions, haltingStates, and the combined tape
     MultiTapeMachineParser parser(inputStream);
     parser.parse();
-    this->transitions = parser.getTransitions();
-    this->haltingStates = parser.getHaltingStates();
-    this->tape = parser.getCombinedTape();
+    auto parsed = std::make_shared<Program>();
+    parsed->transitions = parser.getTransitions();
+    parsed->haltingStates = parser.getHaltingStates();
+    parsed->states = parser.getStates();
+    parsed->alphabetCombination = parser.getAlphabetCombinations();
+    parsed->initialState = parser.getInitialState();
+    parsed->intern();
+    this->program = std::move(parsed);
+    unmap();
+    this->tape = parser.takeCombinedTape();
     this->tapeIterators = parser.getInitialTapePositions();
-    this->states = parser.getStates();
-    this->alphabetCombination = parser.getAlphabetCombinations();
     this->currentState = parser.getInitialState();
+    this->steps = 0;
+}
+
+std::unique_ptr<TuringMachine> MultiTapeTuringMachine::clone() const {
+    auto copy = std::make_unique<MultiTapeTuringMachine>();
+    copy->program = program;
+    copy->currentState = currentState;
+    copy->steps = steps;
+    copy->tape = tape;
+    copy->stats = stats;
+    copy->headOffsets = headOffsets;
+    copy->source = source;
+    copy->headIndices = headIndices;
+
+    // Loaded blocks lie in the list in block order, each as one run of cells.
+    auto cell = copy->tape.begin();
+    for (const auto& [index, block] : loadedBlocks) {
+        const std::size_t size = source->block(index).size();
+        auto first = cell;
+        for (std::size_t i = 1; i < size; ++i) {
+            ++cell;
+        }
+        copy->loadedBlocks.emplace(index, Block(first, cell));
+        ++cell;
+    }
+
+    // Re-create every head at the same offset in the copied tape.
+    for (const auto& head : tapeIterators) {
+        auto source = tape.begin();
+        auto target = copy->tape.begin();
+        while (source != head && source != tape.end()) {
+            ++source;
+            ++target;
+        }
+        copy->tapeIterators.push_back(source == head ? target : copy->tape.end());
+    }
+    return copy;
+}
+
+MultiTapeTuringMachine::Program& MultiTapeTuringMachine::mutableProgram() {
+    if (program.use_count() != 1) {
+        program = std::make_shared<Program>(*program);
+    }
+    return const_cast<Program&>(*program);
 }
 void MultiTapeTuringMachine::run(const std::string& outputFileName) {
+    TM_TRACE_SCOPE("run");
     std::ofstream outFile(outputFileName, std::ios::out);
     if (!outFile.is_open()) {
         std::cerr << "Unable to open or create file: " << outputFileName << std::endl;
         return;
     }
 
-    while (true) {
-        if (haltingStates.find(currentState) != haltingStates.end()) {
-            break;
-        }
+    if (advance() == Status::NoTransition) {
+        std::cerr << "Machine reached invalid state: " << currentSymbols() << ", " << currentState << std::endl;
+    }
 
-        std::string currentSymbols;
-        for (auto it : tapeIterators) {
-            currentSymbols.push_back(*it);
+    // Write final tape state to file
+    outputTape(outFile);
+}
+
+TuringMachine::Status MultiTapeTuringMachine::advance(std::uint64_t maxSteps) {
+    const auto& transitions = program->transitions;
+    const auto& haltingStates = program->haltingStates;
+    std::uint32_t currentStateId = 0;
+    if (stats) {
+        stats->bind(program->stateNames.size(), program->transitionKeys.size());
+        headOffsets.resize(tapeIterators.size(), 0);
+        currentStateId = program->stateId(currentState);
+    }
+
+    std::uint64_t remaining = maxSteps;
+    while (haltingStates.find(currentState) == haltingStates.end()) {
+        if (remaining == 0) {
+            return Status::Running;
         }
 
-        TransitionKey key{currentSymbols, currentState};
+        TM_TRACE_SAMPLE("multitape", steps, program->stateId(currentState), getHeadPosition());
+        TransitionKey key{currentSymbols(), currentState};
         auto it = transitions.find(key);
         if (it == transitions.end()) {
-            std::cerr << "Machine reached invalid state: " << currentSymbols << ", " << currentState << std::endl;
-            break;
+            return Status::NoTransition;
         }
 
         const TransitionValue& transition = it->second;
+        if (stats) {
+            recordStep(currentStateId, transition);
+            currentStateId = transition.newStateId;
+        }
         for (size_t i = 0; i < tapeIterators.size(); ++i) {
             if (transition.command[i] != 'S') {
                 *tapeIterators[i] = transition.newSymbolCombination[i];
             }
+            if (source && transition.command[i] != 'S') {
+                moveMappedHead(i, transition.command[i]);
+                continue;
+            }
 
             switch (transition.command[i]) {
                 case 'L': --tapeIterators[i]; break;
@@ -78,21 +164,268 @@ void MultiTapeTuringMachine::run(const std::string& outputFileName) {
         }
 
         currentState = transition.newState;
+        --remaining;
+        ++steps;
     }
+    return Status::Halted;
+}
 
-    // Write final tape state to file
-    outputTape(outFile);
+std::string MultiTapeTuringMachine::currentSymbols() const {
+    std::string symbols;
+    for (auto it : tapeIterators) {
+        symbols.push_back(*it);
+    }
+    return symbols;
+}
+
+void MultiTapeTuringMachine::setInput(const std::string& combinedTape) {
+    unmap();
+    tape.free();
+    setTape(combinedTape);
+    currentState = program->initialState;
+    steps = 0;
+    if (stats) {
+        enableStats();
+    }
+}
+
+void MultiTapeTuringMachine::mapInputFile(const std::string& fileName) {
+    unmap();
+    tape.free();
+    tapeIterators.clear();
+    source = TapeSource::map(fileName);
+
+    // As in setTape(), a head starts on the first cell and after every separator.
+    const char* cells = source->data();
+    const std::size_t size = source->size();
+    for (std::size_t first = 0; first < size;) {
+        const Block& block = loadBlock(first / TapeSource::BLOCK_SIZE);
+        auto head = block.first;
+        for (std::size_t i = 0; i < first % TapeSource::BLOCK_SIZE; ++i) {
+            ++head;
+        }
+        headIndices.push_back(first);
+        tapeIterators.push_back(head);
+
+        const void* separator = std::memchr(cells + first, '#', size - first);
+        if (separator == nullptr) {
+            break;
+        }
+        first = static_cast<std::size_t>(static_cast<const char*>(separator) - cells) + 1;
+    }
+
+    currentState = program->initialState;
+    steps = 0;
+    if (stats) {
+        enableStats();
+    }
+}
+
+void MultiTapeTuringMachine::unmap() {
+    source.reset();
+    loadedBlocks.clear();
+    headIndices.clear();
+}
+
+const MultiTapeTuringMachine::Block& MultiTapeTuringMachine::loadBlock(std::size_t index) {
+    auto found = loadedBlocks.find(index);
+    if (found != loadedBlocks.end()) {
+        return found->second;
+    }
+
+    std::string_view cells = source->block(index);
+    Block block;
+    auto next = loadedBlocks.upper_bound(index);
+    if (next == loadedBlocks.end()) {
+        auto previous = tape.last();
+        tape.append(cells.data(), cells.data() + cells.size());
+        block.first = previous.valid() ? ++previous : tape.begin();
+        block.second = tape.last();
+    } else {
+        const auto before = next->second.first;
+        for (char symbol : cells) {
+            tape.push_before(before, symbol);
+        }
+        block.second = before;
+        --block.second;
+        block.first = block.second;
+        for (std::size_t i = 1; i < cells.size(); ++i) {
+            --block.first;
+        }
+    }
+    return loadedBlocks.emplace(index, block).first->second;
+}
+
+void MultiTapeTuringMachine::moveMappedHead(std::size_t head, char command) {
+    // Within a block the next cell is the next node; across blocks it is found by index. Off
+    // either end of the tape the head leaves the list, as it does on an unmapped tape.
+    std::size_t& index = headIndices[head];
+    auto& cell = tapeIterators[head];
+    if (command == 'L') {
+        if (index == 0) {
+            --cell;
+        } else if (index-- % TapeSource::BLOCK_SIZE != 0) {
+            --cell;
+        } else {
+            cell = loadBlock(index / TapeSource::BLOCK_SIZE).second;
+        }
+    } else if (command == 'R') {
+        if (index + 1 >= source->size()) {
+            ++cell;
+        } else if (++index % TapeSource::BLOCK_SIZE != 0) {
+            ++cell;
+        } else {
+            cell = loadBlock(index / TapeSource::BLOCK_SIZE).first;
+        }
+    }
+}
+
+void MultiTapeTuringMachine::writeTape(std::ostream& out) const {
+    if (!source) {
+        for (const auto& symbol : tape) {
+            out << symbol;
+        }
+        return;
+    }
+
+    std::size_t next = 0;
+    for (const auto& [index, block] : loadedBlocks) {
+        std::string_view skipped = source->range(next * TapeSource::BLOCK_SIZE, index * TapeSource::BLOCK_SIZE);
+        out.write(skipped.data(), static_cast<std::streamsize>(skipped.size()));
+        for (auto it = block.first;; ++it) {
+            out << *it;
+            if (it == block.second) {
+                break;
+            }
+        }
+        next = index + 1;
+    }
+    std::string_view rest = source->range(std::min(next * TapeSource::BLOCK_SIZE, source->size()), source->size());
+    out.write(rest.data(), static_cast<std::streamsize>(rest.size()));
+}
+
+std::string MultiTapeTuringMachine::getOutput() const {
+    if (source) {
+        std::ostringstream contents;
+        writeTape(contents);
+        return contents.str();
+    }
+    std::string contents;
+    for (const auto& symbol : tape) {
+        contents += symbol;
+    }
+    return contents;
+}
+
+std::size_t MultiTapeTuringMachine::getTapeSize() const {
+    if (source) {
+        return source->size();
+    }
+    // The list keeps no count; multi-tape tapes never grow, so callers can cache this.
+    std::size_t cells = 0;
+    for (auto it = tape.begin(); it != tape.end(); ++it) {
+        ++cells;
+    }
+    return cells;
+}
+
+std::uint64_t MultiTapeTuringMachine::getStepCount() const {
+    return steps;
+}
+
+std::size_t MultiTapeTuringMachine::getHeadPosition() const {
+    if (source) {
+        return headIndices.empty() ? 0 : headIndices.front();
+    }
+    return tapeIterators.empty() ? 0 : cellIndex(tape, tapeIterators.front());
+}
+
+std::string MultiTapeTuringMachine::getStateName() const {
+    return currentState;
 }
 
 
 void MultiTapeTuringMachine::setTransitions(const std::unordered_map<TransitionKey, TransitionValue, TransitionKeyHash>& transitions) {
-    this->transitions = transitions;
+    Program& updated = mutableProgram();
+    updated.transitions = transitions;
+    updated.intern();
 }
 
 void MultiTapeTuringMachine::setHaltingStates(const std::set<std::string>& haltingStates) {
+    Program& updated = mutableProgram();
     for (const auto& state : haltingStates) {
-        this->haltingStates.insert(state);
+        updated.haltingStates.insert(state);
+    }
+    updated.intern();
+}
+
+void MultiTapeTuringMachine::Program::intern() {
+    std::set<std::string> names = states;
+    names.insert(haltingStates.begin(), haltingStates.end());
+    for (const auto& transition : transitions) {
+        names.insert(transition.first.currentState);
+        names.insert(transition.second.newState);
     }
+    stateNames.assign(names.begin(), names.end());
+
+    transitionKeys.clear();
+    transitionKeys.reserve(transitions.size());
+    for (auto& transition : transitions) {
+        transition.second.id = static_cast<std::uint32_t>(transitionKeys.size());
+        transition.second.newStateId = stateId(transition.second.newState);
+        transitionKeys.push_back(transition.first);
+    }
+}
+
+std::uint32_t MultiTapeTuringMachine::Program::stateId(const std::string& state) const {
+    return static_cast<std::uint32_t>(std::lower_bound(stateNames.begin(), stateNames.end(), state) - stateNames.begin());
+}
+
+void MultiTapeTuringMachine::recordStep(std::uint32_t stateId, const TransitionValue& transition) {
+    ++stats->steps;
+    if (stateId < stats->stateHits.size()) {
+        ++stats->stateHits[stateId];
+    }
+    ++stats->transitionHits[transition.id];
+    for (std::size_t i = 0; i < headOffsets.size() && i < transition.command.size(); ++i) {
+        if (transition.command[i] == 'L' || transition.command[i] == 'R') {
+            headOffsets[i] += transition.command[i] == 'R' ? 1 : -1;
+            ++stats->headTravel;
+            stats->recordHeadOffset(headOffsets[i]);
+        }
+    }
+}
+
+void MultiTapeTuringMachine::enableStats(bool enabled) {
+    if (enabled) {
+        stats.emplace();
+        stats->reset(program->stateNames.size(), program->transitionKeys.size());
+        headOffsets.assign(tapeIterators.size(), 0);
+    } else {
+        stats.reset();
+        headOffsets.clear();
+    }
+}
+
+const ExecutionStats* MultiTapeTuringMachine::getStats() const {
+    return stats ? &*stats : nullptr;
+}
+
+void MultiTapeTuringMachine::writeStats(std::ostream& out, std::size_t top) const {
+    if (!stats) {
+        return;
+    }
+    std::shared_ptr<const Program> labelled = program;
+    ExecutionStats::Labels labels{
+            [labelled](std::size_t state) { return labelled->stateNames[state]; },
+            [labelled](std::size_t index) {
+                const TransitionKey& key = labelled->transitionKeys[index];
+                const TransitionValue& value = labelled->transitions.at(key);
+                return key.currentSymbolCombination + "{" + key.currentState + "}->" + value.newSymbolCombination
+                       + "{" + value.newState + "}" + value.command;
+            }
+    };
+    stats->writeJson(out, labels, top);
 }
 
 
@@ -125,10 +458,7 @@ void MultiTapeTuringMachine::setTape(const std::string& combinedTapeStr) {
 void MultiTapeTuringMachine::outputTape(const std::string& outFile) {
     std::ofstream outFileStream(outFile, std::ios::out);
     if (outFileStream.is_open()) {
-        // Iterate through the DoublyLinkedList<char> and write to file
-        for (auto it = tape.begin(); it != tape.end(); ++it) {
-            outFileStream << *it; // Assuming the DoublyLinkedList node has a 'data' member
-        }
+        writeTape(outFileStream);
         outFileStream.close();
     } else {
         std::cerr << "Unable to open or create file: " << outFile << std::endl;
@@ -168,19 +498,21 @@ void MultiTapeTuringMachine::processTape(const std::string& tapeData) {
 }
 
 const std::set<std::string> &MultiTapeTuringMachine::getStates() const {
-    return states;
+    return program->states;
 }
 
 void MultiTapeTuringMachine::setStates(const std::set<std::string> &states) {
-    MultiTapeTuringMachine::states = states;
+    Program& updated = mutableProgram();
+    updated.states = states;
+    updated.intern();
 }
 
 const std::set<std::string> &MultiTapeTuringMachine::getAlphabetCombination() const {
-    return alphabetCombination;
+    return program->alphabetCombination;
 }
 
 void MultiTapeTuringMachine::setAlphabetCombination(const std::set<std::string> &alphabet) {
-    MultiTapeTuringMachine::alphabetCombination = alphabetCombination;
+    mutableProgram().alphabetCombination = alphabet;
 }
 
 const std::vector<DoublyLinkedList<char>::Iterator> &MultiTapeTuringMachine::getTapeIterators() const {
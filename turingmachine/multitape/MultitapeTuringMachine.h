@@ -15,10 +15,16 @@
 
 
 #include "../machines/TuringMachine.h"
+#include <map>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <set>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include "../stats/ExecutionStats.h"
+#include "../tape/TapeSource.h"
 
 
 /**
@@ -35,6 +41,21 @@ public:
     MultiTapeTuringMachine(std::istream& inputStream);
     virtual void init(std::istream& inputStream) override;
     virtual void run(const std::string& outputFileName) override;
+    std::unique_ptr<TuringMachine> clone() const override;
+    /// Loads a combined tape, the tapes separated by '#', with every head at the start of its tape.
+    void setInput(const std::string& combinedTape) override;
+    /**
+     * Like setInput() on a combined tape file, which is mapped rather than read: a block of
+     * cells is only loaded when a head first reaches it. Finding the heads scans the file for
+     * separators but loads nothing else.
+     */
+    void mapInputFile(const std::string& fileName);
+    Status advance(std::uint64_t maxSteps = UNLIMITED) override;
+    std::string getOutput() const override;
+    std::size_t getTapeSize() const override;
+    std::uint64_t getStepCount() const override;
+    std::size_t getHeadPosition() const override;
+    std::string getStateName() const override;
 
     struct TransitionKey {
         std::string currentSymbolCombination;
@@ -46,6 +67,8 @@ public:
         std::string newSymbolCombination;
         std::string newState;
         std::string command;
+        std::uint32_t id = 0;         ///< Interned index of the transition, used by the stats.
+        std::uint32_t newStateId = 0; ///< Interned id of newState.
     };
 
     struct TransitionKeyHash {
@@ -62,21 +85,55 @@ public:
     void setTapeIterators(const std::vector<DoublyLinkedList<char>::Iterator> &tapeIterators);
     const std::set<std::string> &getAlphabetCombination() const;
     void setAlphabetCombination(const std::set<std::string> &alphabet);
+
+    /// Starts or stops collecting ExecutionStats for the following runs.
+    void enableStats(bool enabled = true);
+    /// The collected counters, or nullptr when stats are disabled.
+    const ExecutionStats* getStats() const;
+    /// Writes the collected counters as JSON, listing at most `top` transitions when top is not zero.
+    void writeStats(std::ostream& out, std::size_t top = 0) const;
 private:
-    std::unordered_map<TransitionKey, TransitionValue, TransitionKeyHash> transitions;
-    std::set<std::string> states;
-    std::set<std::string> haltingStates;
-    std::set<std::string> alphabetCombination;
+    /// Immutable part of the machine, shared between clones and copied on write by the setters.
+    struct Program {
+        std::unordered_map<TransitionKey, TransitionValue, TransitionKeyHash> transitions;
+        std::set<std::string> states;
+        std::set<std::string> haltingStates;
+        std::set<std::string> alphabetCombination;
+        std::string initialState;
+        std::vector<std::string> stateNames;     ///< Every state, sorted; the index is the state id.
+        std::vector<TransitionKey> transitionKeys; ///< Keys of the transitions, by transition id.
+
+        /// Assigns state ids and transition ids after the description changed.
+        void intern();
+        std::uint32_t stateId(const std::string& state) const;
+    };
+
+    std::shared_ptr<const Program> program;
     std::string currentState;
+    std::uint64_t steps = 0;
     DoublyLinkedList<char> tape;
     std::vector<typename DoublyLinkedList<char>::Iterator> tapeIterators;
     std::vector<typename DoublyLinkedList<char>::Iterator> initialTapePositions;
+    std::optional<ExecutionStats> stats;
+    std::vector<std::int64_t> headOffsets; ///< Offset of each head since stats were enabled.
+
+    using Block = std::pair<DoublyLinkedList<char>::Iterator, DoublyLinkedList<char>::Iterator>;
+    std::shared_ptr<const TapeSource> source; ///< Backs a mapped tape; null when the whole tape is in the list.
+    std::map<std::size_t, Block> loadedBlocks; ///< First and last cell of every loaded block of a mapped tape.
+    std::vector<std::size_t> headIndices;      ///< Cell index of every head on a mapped tape.
 
     void processTape(const std::string& tapeData);
+    std::string currentSymbols() const;
     void outputTape(const std::string& outFile);
     bool isValidTape(const std::string& tape) const;
     bool isValidCommand(const std::string command);
     void outputTape(std::ofstream &outFile) const;
+    Program& mutableProgram();
+    void unmap();
+    const Block& loadBlock(std::size_t index);
+    void moveMappedHead(std::size_t head, char command);
+    void writeTape(std::ostream& out) const;
+    void recordStep(std::uint32_t stateId, const TransitionValue& transition);
 };
 
 #endif //TURING_MACHINE_MULTITAPETURINGMACHINE_H
@@ -7,7 +7,7 @@ void BaseParser::parseTransitions(std::unordered_map<RegularTuringMachine::Trans
     alphabet.insert('>');
     std::string line;
     bool firstTransition = true;
-    while (std::getline(inputStream, line)) {
+    while (readLine(line)) {
         if (line.empty()) {
             continue;
         }
@@ -34,7 +34,7 @@ void BaseParser::parseTransitions(std::unordered_map<RegularTuringMachine::Trans
 }
 
 void BaseParser::parseTape(std::string& tape) {
-    std::getline(inputStream, tape);
+    readLine(tape);
     findInitialTapePosition(tape);
 }
 
@@ -67,6 +67,19 @@ bool BaseParser::parseTransitionLine(const std::string& line, RegularTuringMachi
 
     if (!(stream >> arrow >> arrow && arrow == '>')) return false;
 
+    // "0{s}->@name{r}" calls the sub-machine name and resumes in r; "@{r}R" writes an '@'.
+    if (stream.peek() == '@') {
+        stream.get();
+        if (stream.peek() != '{') {
+            std::getline(stream, value.call, '{');
+            std::getline(stream, value.newState, '}');
+            value.newSymbol = key.currentSymbol;
+            value.command = 'C';
+            return !value.call.empty() && !stream.fail();
+        }
+        stream.unget();
+    }
+
     if (!(stream >>  std::noskipws >> value.newSymbol >> tempBracket && tempBracket == '{')) return false;
     std::getline(stream, value.newState, '}');
 
@@ -78,16 +91,44 @@ bool BaseParser::parseTransitionLine(const std::string& line, RegularTuringMachi
 
 void BaseParser::parseHaltingStates(std::set<std::string>& haltingStates) {
     std::string line;
-    while (std::getline(inputStream, line)) {
+    while (readLine(line)) {
         if (!line.empty() && (line[0] == '>' || isupper(line[0]))) {
-            inputStream.putback('\n');
-            for (auto it = line.rbegin(); it != line.rend(); ++it) inputStream.putback(*it);
+            unreadLine(std::move(line));
             break;
         }
         haltingStates.insert(line);
     }
 }
 
+bool BaseParser::readLine(std::string& line) {
+    if (lookahead) {
+        line = std::move(*lookahead);
+        lookahead.reset();
+        return true;
+    }
+    return static_cast<bool>(std::getline(inputStream, line));
+}
+
+const std::string* BaseParser::peekLine() {
+    if (!lookahead) {
+        std::string line;
+        if (!std::getline(inputStream, line)) {
+            return nullptr;
+        }
+        lookahead = std::move(line);
+    }
+    return &*lookahead;
+}
+
+void BaseParser::unreadLine(std::string line) {
+    lookahead = std::move(line);
+}
+
+void BaseParser::skipLine() {
+    std::string line;
+    readLine(line);
+}
+
 const std::set<std::string>& BaseParser::getStates() const {
     return states;
 }
@@ -2,14 +2,22 @@
 #define TURING_MACHINE_BASEPARSER_H
 
 #include <istream>
+#include <optional>
 #include <unordered_map>
 #include <set>
 #include <string>
+#include <utility>
 #include "../machines/RegularTuringMachine.h"
 
 class BaseParser {
 public:
-    explicit BaseParser(std::istream& input) : inputStream(input){}
+    /// `directory` is the one relative paths in USE lines are resolved against; empty for the working directory.
+    explicit BaseParser(std::istream& input, std::string directory = {})
+            : inputStream(input), lookahead(ownLookahead), directory(std::move(directory)) {}
+    /// Reads part of a description another parser reads, sharing the line it looked ahead at.
+    BaseParser(std::istream& input, std::optional<std::string>& sharedLookahead) : inputStream(input), lookahead(sharedLookahead) {}
+    BaseParser(const BaseParser&) = delete;
+    BaseParser& operator=(const BaseParser&) = delete;
 
     void parseTransitions(std::unordered_map<RegularTuringMachine::TransitionKey, RegularTuringMachine::TransitionValue, RegularTuringMachine::TransitionKeyHash>& transitions);
     void parseHaltingStates(std::set<std::string>& haltingStates);
@@ -20,13 +28,25 @@ public:
     const std::string& getInitialState() const;
     int getInitialTapePosition() const;
 protected:
+    /// Reads the next line, the one looked ahead at if there is one.
+    bool readLine(std::string& line);
+    /// The next line, which is left to be read; nullptr at the end of the input.
+    const std::string* peekLine();
+    /// Gives back the line just read, so that the next read returns it again.
+    void unreadLine(std::string line);
+    void skipLine();
+
     std::istream& inputStream;
+    std::optional<std::string>& lookahead; ///< A line read ahead, shared by the parsers of one description.
+    std::string directory;
     std::set<std::string> states;
     std::set<char> alphabet;
     std::string initialState;
     int initialTapePosition;
 
 private:
+    std::optional<std::string> ownLookahead;
+
     bool isValidCommand(const char command);
     bool parseTransitionLine(const std::string& line, RegularTuringMachine::TransitionKey& key, RegularTuringMachine::TransitionValue& value);
     void findInitialState(const std::string& line);
@@ -4,11 +4,11 @@
 #include "RegularParser.h"
 
 void CompositionMachineParser::parse() {
-    RegularMachineParser machine1Parser(inputStream);
-    machine1 = machine1Parser.parse();
+    RegularMachineParser machine1Parser(inputStream, lookahead);
+    machine1 = machine1Parser.parseBlock(directory);
 
-    RegularMachineParser machine2Parser(inputStream);
-    machine2 = machine2Parser.parse();
+    RegularMachineParser machine2Parser(inputStream, lookahead);
+    machine2 = machine2Parser.parseBlock(directory);
 
     this->tape = machine2->getTape();
 }
@@ -1,28 +1,32 @@
 #include <memory>
 #include <limits>
+#include <sstream>
 #include "ConditionalParser.h"
 #include "../machines/RegularTuringMachine.h"
 #include "ConditionalParser.h"
 #include "RegularParser.h"
 
 void ConditionalCompositionMachineParser::parse() {
-    RegularMachineParser machine1Parser(inputStream);
-    machine1 = machine1Parser.parse();
-    inputStream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    RegularMachineParser machine2Parser(inputStream);
-    machine2 = machine2Parser.parse();
-    inputStream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    RegularMachineParser machine3Parser(inputStream);
-    machine3 = machine3Parser.parse();
+    RegularMachineParser machine1Parser(inputStream, lookahead);
+    machine1 = machine1Parser.parseBlock(directory);
+    skipLine();
+    RegularMachineParser machine2Parser(inputStream, lookahead);
+    machine2 = machine2Parser.parseBlock(directory);
+    skipLine();
+    RegularMachineParser machine3Parser(inputStream, lookahead);
+    machine3 = machine3Parser.parseBlock(directory);
 
-    int numConditionalSymbols;
-    inputStream >> numConditionalSymbols;
+    // The number of conditional symbols and the symbols, on the first line that is not blank.
+    std::string line;
+    while (readLine(line) && line.find_first_not_of(" \t\r") == std::string::npos) {
+    }
+    std::istringstream symbols(line);
+    int numConditionalSymbols = 0;
+    symbols >> numConditionalSymbols;
     char symbol;
-    for (int i = 0; i < numConditionalSymbols; ++i) {
-        inputStream >> std::noskipws >> symbol;
+    for (int i = 0; i < numConditionalSymbols && symbols >> std::noskipws >> symbol; ++i) {
         conditionalSymbols.insert(symbol);
     }
-    inputStream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
     parseTape(tape);
 }
@@ -0,0 +1,108 @@
+#include <stdexcept>
+#include "GraphParser.h"
+#include "RegularParser.h"
+
+namespace {
+
+const std::string NODE_PREFIX = "NODE ";
+const std::string EDGES_LINE = "EDGES";
+
+std::string trimmed(const std::string& line) {
+    std::size_t end = line.find_last_not_of(" \t\r");
+    return end == std::string::npos ? std::string() : line.substr(0, end + 1);
+}
+
+}
+
+void GraphMachineParser::parse() {
+    std::string line;
+    readLine(line);
+    line = trimmed(line);
+
+    // Every block reads the line after its halting states as its tape: the next "NODE" line,
+    // or "EDGES" after the last block.
+    while (line.compare(0, NODE_PREFIX.size(), NODE_PREFIX) == 0) {
+        std::string name = line.substr(NODE_PREFIX.size());
+        if (name.empty()) {
+            throw std::runtime_error("Machine graph node without a name");
+        }
+        for (const Node& node : nodes) {
+            if (node.name == name) {
+                throw std::runtime_error("Duplicate machine graph node: " + name);
+            }
+        }
+        RegularMachineParser nodeParser(inputStream, lookahead);
+        nodes.push_back({name, nodeParser.parseBlock(directory)->getProgram()});
+        line = trimmed(nodeParser.getTapeLine());
+    }
+    if (nodes.empty()) {
+        throw std::runtime_error("Machine graph without nodes");
+    }
+    if (line != EDGES_LINE) {
+        throw std::runtime_error("Expected EDGES after the last machine graph node, found: " + line);
+    }
+
+    while (readLine(line)) {
+        line = trimmed(line);
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '>') {
+            tape = line;
+            break;
+        }
+        edges.push_back(parseEdge(line));
+    }
+}
+
+GraphMachineParser::Edge GraphMachineParser::parseEdge(const std::string& line) const {
+    const std::size_t arrow = line.find("->");
+    if (arrow == std::string::npos) {
+        throw std::runtime_error("Invalid machine graph edge: " + line);
+    }
+    Edge edge{};
+    std::string from = line.substr(0, arrow);
+    if (from.size() >= 3 && from.back() == ']' && from[from.size() - 3] == '[') {
+        edge.symbol = from[from.size() - 2];
+        from.resize(from.size() - 3);
+    }
+    if (!from.empty() && from.back() == '}') {
+        std::size_t open = from.rfind('{');
+        if (open == std::string::npos) {
+            throw std::runtime_error("Invalid machine graph edge: " + line);
+        }
+        edge.state = from.substr(open + 1, from.size() - open - 2);
+        from.resize(open);
+    }
+    edge.from = findNode(from);
+    edge.to = findNode(line.substr(arrow + 2));
+    if (edge.state) {
+        const CompiledMachine& program = *nodes[edge.from].program;
+        const std::uint32_t state = program.findState(*edge.state);
+        if (state == CompiledMachine::NO_STATE || !program.isHalting(state)) {
+            throw std::runtime_error(*edge.state + " is not a halting state of machine graph node " + from);
+        }
+    }
+    return edge;
+}
+
+std::size_t GraphMachineParser::findNode(const std::string& name) const {
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].name == name) {
+            return i;
+        }
+    }
+    throw std::runtime_error("Unknown machine graph node: " + name);
+}
+
+std::vector<GraphMachineParser::Node> GraphMachineParser::getNodes() {
+    return std::move(nodes);
+}
+
+std::vector<GraphMachineParser::Edge> GraphMachineParser::getEdges() {
+    return std::move(edges);
+}
+
+std::string GraphMachineParser::getTape() {
+    return tape;
+}
@@ -0,0 +1,55 @@
+#ifndef TURING_MACHINE_GRAPHPARSER_H
+#define TURING_MACHINE_GRAPHPARSER_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "BaseParser.h"
+#include "../compiled/CompiledMachine.h"
+
+/**
+ * @class GraphMachineParser
+ * @brief Reads the nodes and edges of a GRAPH description.
+ *
+ * Every node is a "NODE <name>" line followed by a regular machine block; the first node is
+ * where the graph starts. An "EDGES" line follows the last block, then one edge per line:
+ *
+ *     <from>{<halting state>}[<symbol>]-><to>
+ *
+ * Both guards are optional. "{done}" matches when the node halted in state done, "[0]" when the
+ * head is on a 0. The tape on the last line belongs to the whole graph.
+ */
+class GraphMachineParser : public BaseParser {
+public:
+    using BaseParser::BaseParser;  // Inherit the constructor
+
+    struct Node {
+        std::string name;
+        std::shared_ptr<const CompiledMachine> program;
+    };
+
+    struct Edge {
+        std::size_t from;                 ///< Index of the node that halted.
+        std::optional<std::string> state; ///< Halting state the node must have reached.
+        std::optional<char> symbol;       ///< Symbol that must be under the head.
+        std::size_t to;                   ///< Index of the node to run next.
+    };
+
+    void parse();
+
+    std::vector<Node> getNodes();
+
+    std::vector<Edge> getEdges();
+
+    std::string getTape();
+private:
+    std::size_t findNode(const std::string& name) const;
+    Edge parseEdge(const std::string& line) const;
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::string tape;
+};
+
+#endif //TURING_MACHINE_GRAPHPARSER_H
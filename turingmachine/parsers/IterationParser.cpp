@@ -1,16 +1,20 @@
 #include <limits>
 #include "IterationParser.h"
 #include "RegularParser.h"
+#include "../machines/RegularExecution.h"
 
 void IterationLoopMachineParser::parse() {
-    RegularMachineParser loopMachineParser(inputStream);
-    loopMachine = loopMachineParser.parse();
+    RegularMachineParser loopMachineParser(inputStream, lookahead);
+    loopMachine = loopMachineParser.parseBlock(directory);
 
-    RegularMachineParser postLoopMachineParser(inputStream);
-    postLoopMachine = postLoopMachineParser.parse();
+    RegularMachineParser postLoopMachineParser(inputStream, lookahead);
+    postLoopMachine = postLoopMachineParser.parseBlock(directory);
 
-    inputStream >> std::noskipws >> loopConditionSymbol;
-    loopMachine->setTape(postLoopMachine->getTape());
+    std::string line;
+    if (readLine(line)) {
+        loopConditionSymbol = line.empty() ? '\n' : line[0];
+    }
+    loopMachine->getExecution().getTape() = postLoopMachine->getExecution().getTape();
     loopMachine->setCurrentPosition(1);
 }
 
@@ -0,0 +1,28 @@
+#include "PipelineParser.h"
+#include "RegularParser.h"
+
+void PipelineMachineParser::parse() {
+    // Every block reads the line after its halting states as its tape: a separator for all
+    // stages but the last, whose tape is the pipeline's.
+    while (inputStream) {
+        RegularMachineParser stageParser(inputStream, lookahead);
+        stages.push_back(stageParser.parseBlock(directory)->getProgram());
+
+        const std::string& line = stageParser.getTapeLine();
+        if (line.empty() || line[0] == '>') {
+            tape = line;
+            break;
+        }
+    }
+    if (stages.empty()) {
+        throw std::runtime_error("Pipeline without stages");
+    }
+}
+
+std::vector<std::shared_ptr<const CompiledMachine>> PipelineMachineParser::getStages() {
+    return std::move(stages);
+}
+
+std::string PipelineMachineParser::getTape() {
+    return tape;
+}
@@ -0,0 +1,31 @@
+#ifndef TURING_MACHINE_PIPELINEPARSER_H
+#define TURING_MACHINE_PIPELINEPARSER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "BaseParser.h"
+#include "../compiled/CompiledMachine.h"
+
+/**
+ * @class PipelineMachineParser
+ * @brief Reads the stages of a PIPELINE description.
+ *
+ * Stages are regular machine blocks separated by a line starting with an uppercase letter,
+ * conventionally "STAGE"; the tape on the last line belongs to the whole pipeline.
+ */
+class PipelineMachineParser : public BaseParser {
+public:
+    using BaseParser::BaseParser;  // Inherit the constructor
+
+    void parse();
+
+    std::vector<std::shared_ptr<const CompiledMachine>> getStages();
+
+    std::string getTape();
+private:
+    std::vector<std::shared_ptr<const CompiledMachine>> stages;
+    std::string tape;
+};
+
+#endif //TURING_MACHINE_PIPELINEPARSER_H
@@ -1,29 +1,127 @@
+#include <functional>
+#include <set>
 #include "../machines/RegularTuringMachine.h"
+#include "../compiled/CompiledMachine.h"
 #include "RegularParser.h"
-std::unique_ptr<RegularTuringMachine> RegularMachineParser::parse() {
-    try {
-        auto machine = std::make_unique<RegularTuringMachine>();
+#include "../registry/ProgramRegistry.h"
+#include "../trace/Trace.h"
+
+namespace {
 
-        std::unordered_map<RegularTuringMachine::TransitionKey, RegularTuringMachine::TransitionValue, RegularTuringMachine::TransitionKeyHash> transitions;
-        parseTransitions(transitions);
-        machine->setTransitions(transitions);
+const std::string SUBMACHINE_PREFIX = "SUBMACHINE ";
+const std::string USE_PREFIX = "USE ";
 
-        std::set<std::string> haltingStates;
-        parseHaltingStates(haltingStates);
-        machine->setHaltingStates(haltingStates);
+bool isSubMachineLine(const std::string& line) {
+    return line.compare(0, SUBMACHINE_PREFIX.size(), SUBMACHINE_PREFIX) == 0;
+}
 
-        std::string tape;
-        parseTape(tape);
-        machine->setTape(tape);
+}
 
-        machine->setStates(getStates());
-        machine->setAlphabet(getAlphabet());
+std::unique_ptr<RegularTuringMachine> RegularMachineParser::parse() {
+    TM_TRACE_SCOPE("parse");
+    try {
+        CompiledMachine::Description description = parseDescription();
+        description.subMachines = parseSubMachines();
+        return std::make_unique<RegularTuringMachine>(CompiledMachine::compile(description));
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Error parsing Turing Machine: " + std::string(e.what()));
+    }
+}
 
-        machine->setCurrentState(getInitialState());
-        machine->setCurrentPosition(getInitialTapePosition());
+std::unique_ptr<RegularTuringMachine> RegularMachineParser::parseBlock(const std::string& directory) {
+    TM_TRACE_SCOPE("parse");
+    try {
+        ProgramRegistry& registry = ProgramRegistry::global();
+        std::shared_ptr<const CompiledMachine> program;
+        const std::string* line = peekLine();
+        if (line && line->compare(0, USE_PREFIX.size(), USE_PREFIX) == 0) {
+            std::string reference = line->substr(USE_PREFIX.size());
+            reference.erase(reference.find_last_not_of(" \t\r") + 1);
+            skipLine();
+            program = registry.resolve(reference, directory);
+            readLine(tapeLine);
+        }
+        if (!program) {
+            CompiledMachine::Description description = parseDescription();
+            description.tape.clear();
+            description.subMachines = parseSubMachines();
+            program = registry.intern(CompiledMachine::compile(description));
+        }
 
+        auto machine = std::make_unique<RegularTuringMachine>(program);
+        machine->setInput(tapeLine);
         return machine;
     } catch (const std::exception& e) {
         throw std::runtime_error("Error parsing Turing Machine: " + std::string(e.what()));
     }
 }
+
+CompiledMachine::Description RegularMachineParser::parseDescription() {
+    CompiledMachine::Description description;
+
+    parseTransitions(description.transitions);
+    parseHaltingStates(description.haltingStates);
+    parseTape(description.tape);
+    tapeLine = description.tape;
+
+    description.states = getStates();
+    description.alphabet = getAlphabet();
+    description.initialState = getInitialState();
+    description.initialHead = getInitialTapePosition();
+    return description;
+}
+
+std::map<std::string, std::shared_ptr<const CompiledMachine>> RegularMachineParser::parseSubMachines() {
+    const std::string* next = peekLine();
+    if (!next || !isSubMachineLine(*next)) {
+        return {};
+    }
+    std::string line;
+    readLine(line);
+
+    // Every block reads the line after its halting states as its tape: the next SUBMACHINE line.
+    std::map<std::string, CompiledMachine::Description> descriptions;
+    while (isSubMachineLine(line)) {
+        std::string name = line.substr(SUBMACHINE_PREFIX.size());
+        if (name.empty() || descriptions.count(name) != 0) {
+            throw std::runtime_error("Missing or duplicate sub-machine name: " + name);
+        }
+        RegularMachineParser blockParser(inputStream, lookahead);
+        CompiledMachine::Description description = blockParser.parseDescription();
+        line = description.tape;
+        description.tape.clear();
+        descriptions.emplace(name, std::move(description));
+    }
+    if (!line.empty()) {
+        unreadLine(std::move(line));
+    }
+
+    // Callees are compiled before their callers, so every caller shares one program per callee.
+    std::map<std::string, std::shared_ptr<const CompiledMachine>> compiled;
+    std::set<std::string> visiting;
+    std::function<void(const std::string&)> compileSubMachine = [&](const std::string& name) {
+        if (compiled.count(name) != 0) {
+            return;
+        }
+        auto found = descriptions.find(name);
+        if (found == descriptions.end()) {
+            throw std::runtime_error("Unknown sub-machine: " + name);
+        }
+        if (!visiting.insert(name).second) {
+            throw std::runtime_error("Recursive sub-machine call: " + name);
+        }
+        CompiledMachine::Description& description = found->second;
+        for (const auto& transition : description.transitions) {
+            if (transition.second.command == 'C') {
+                compileSubMachine(transition.second.call);
+                description.subMachines[transition.second.call] = compiled.at(transition.second.call);
+            }
+        }
+        compiled[name] = ProgramRegistry::global().intern(CompiledMachine::compile(description));
+        visiting.erase(name);
+    };
+    for (const auto& entry : descriptions) {
+        compileSubMachine(entry.first);
+    }
+    return compiled;
+}
@@ -4,18 +4,49 @@
 
 #include "BaseParser.h"
 #include <istream>
+#include <map>
 #include <memory>
+#include "../compiled/CompiledMachine.h"
 #include "../machines/RegularTuringMachine.h"
 
+/**
+ * @class RegularMachineParser
+ * @brief Reads a regular machine block and the sub-machines it calls.
+ *
+ * Sub-machines follow the tape line, each as a "SUBMACHINE <name>" line and a regular machine
+ * block without a tape. A transition "0{s}->@name{r}" calls one of them; sub-machines may call
+ * each other, but not recursively.
+ *
+ * Blocks of composite descriptions are read with parseBlock(). Their programs are interned in
+ * the ProgramRegistry, and a "USE <reference>" line may stand for the transitions and halting
+ * states of a block.
+ */
 class RegularMachineParser : public BaseParser {
 public:
     using BaseParser::BaseParser;
 
     std::unique_ptr<RegularTuringMachine> parse();
 
+    /**
+     * Reads one block of a composite description. The program has no tape of its own and is
+     * shared with identical blocks; the machine starts on the block's tape line. A file named
+     * by a USE line is looked for relative to `directory`, or the working directory if empty.
+     */
+    std::unique_ptr<RegularTuringMachine> parseBlock(const std::string& directory = {});
+
+    /// The line read as the tape of the last block: the tape or a separator line.
+    const std::string& getTapeLine() const { return tapeLine; }
+
 private:
+    /// Transitions, halting states and the tape line of one block.
+    CompiledMachine::Description parseDescription();
+
+    /// Reads the SUBMACHINE blocks after the tape, if any, and compiles them.
+    std::map<std::string, std::shared_ptr<const CompiledMachine>> parseSubMachines();
+
     std::string initialState;
     int initialTapePosition;
+    std::string tapeLine;
 };
 
 
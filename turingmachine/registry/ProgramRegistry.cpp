@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include "ProgramRegistry.h"
+#include "../hash/Hash.h"
+#include "../parsers/RegularParser.h"
+
+namespace {
+
+/// Same image and same sub-machines; callees are interned first, so identity decides.
+bool identical(const CompiledMachine& a, const CompiledMachine& b) {
+    if (a.size() != b.size() || a.getCalleeCount() != b.getCalleeCount()
+        || std::memcmp(a.data(), b.data(), a.size()) != 0) {
+        return false;
+    }
+    for (std::uint16_t i = 0; i < a.getCalleeCount(); ++i) {
+        if (a.getCallee(i) != b.getCallee(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+thread_local ProgramRegistry::FileRecorder* currentRecorder = nullptr;
+
+}
+
+ProgramRegistry::FileRecorder::FileRecorder() : outer(currentRecorder) {
+    currentRecorder = this;
+}
+
+ProgramRegistry::FileRecorder::~FileRecorder() {
+    currentRecorder = outer;
+    if (outer) {
+        outer->files.insert(outer->files.end(), files.begin(), files.end());
+    }
+}
+
+void ProgramRegistry::FileRecorder::record(const std::vector<FileVersion>& versions) {
+    if (currentRecorder) {
+        currentRecorder->files.insert(currentRecorder->files.end(), versions.begin(), versions.end());
+    }
+}
+
+bool ProgramRegistry::isCurrent(const std::vector<FileVersion>& files) {
+    return std::all_of(files.begin(), files.end(), [](const FileVersion& file) {
+        std::error_code error;
+        const auto modificationTime = std::filesystem::last_write_time(file.path, error);
+        const std::uintmax_t size = error ? 0 : std::filesystem::file_size(file.path, error);
+        return !error && modificationTime == file.modificationTime && size == file.size;
+    });
+}
+
+ProgramRegistry& ProgramRegistry::global() {
+    static ProgramRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<const CompiledMachine> ProgramRegistry::intern(std::shared_ptr<const CompiledMachine> program) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return internLocked(std::move(program));
+}
+
+std::shared_ptr<const CompiledMachine> ProgramRegistry::internLocked(std::shared_ptr<const CompiledMachine> program) {
+    ++stats.interned;
+    const std::uint64_t key = hash128(std::string_view(static_cast<const char*>(program->data()), program->size())).low;
+    auto& bucket = programs[key];
+    for (auto it = bucket.begin(); it != bucket.end();) {
+        std::shared_ptr<const CompiledMachine> existing = it->lock();
+        if (!existing) {
+            it = bucket.erase(it);
+            continue;
+        }
+        if (identical(*existing, *program)) {
+            ++stats.deduplicated;
+            return existing;
+        }
+        ++it;
+    }
+    bucket.push_back(program);
+    return program;
+}
+
+void ProgramRegistry::define(const std::string& name, std::shared_ptr<const CompiledMachine> program) {
+    std::lock_guard<std::mutex> lock(mutex);
+    names[name] = internLocked(std::move(program));
+}
+
+void ProgramRegistry::undefine(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    names.erase(name);
+}
+
+std::shared_ptr<const CompiledMachine> ProgramRegistry::resolve(const std::string& reference, const std::string& directory) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = names.find(reference);
+        if (it != names.end()) {
+            return it->second;
+        }
+    }
+    const std::filesystem::path path(reference);
+    return load(path.is_relative() && !directory.empty() ? (std::filesystem::path(directory) / path).string() : reference);
+}
+
+std::shared_ptr<const CompiledMachine> ProgramRegistry::load(const std::string& fileName) {
+    std::error_code error;
+    const std::filesystem::path path = std::filesystem::weakly_canonical(fileName, error);
+    const auto modificationTime = std::filesystem::last_write_time(path, error);
+    const std::uintmax_t size = error ? 0 : std::filesystem::file_size(path, error);
+    if (error) {
+        throw std::runtime_error("Unknown machine reference: " + fileName);
+    }
+
+    const FileVersion version{path.string(), modificationTime, size};
+    std::optional<LoadedFile> loaded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = files.find(path.string());
+        if (it != files.end() && it->second.modificationTime == modificationTime && it->second.size == size) {
+            loaded = it->second;
+        }
+    }
+    // The files it refers to are checked outside the lock, which is not held across file system calls.
+    if (loaded && isCurrent(loaded->references)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++stats.fileHits;
+        }
+        FileRecorder::record({version});
+        FileRecorder::record(loaded->references);
+        return loaded->program;
+    }
+
+    // Parsed outside the lock; a concurrent load of the same file interns to the same program.
+    thread_local std::set<std::string> loading; ///< Files whose USE lines this thread is resolving.
+    if (!loading.insert(path.string()).second) {
+        throw std::runtime_error("Circular machine reference: " + fileName);
+    }
+    struct Loading {
+        std::string path;
+        ~Loading() { loading.erase(path); }
+    } guard{path.string()};
+
+    std::shared_ptr<const CompiledMachine> program;
+    std::vector<FileVersion> references;
+    const bool binary = CompiledMachine::isBinaryFile(path.string());
+    if (binary) {
+        program = CompiledMachine::load(path.string());
+    } else {
+        FileRecorder recorder;
+        std::ifstream file(path);
+        std::string machineType;
+        std::getline(file, machineType);
+        if (!machineType.empty() && machineType.back() == '\r') {
+            machineType.pop_back();
+        }
+        if (machineType != "REGULAR") {
+            throw std::runtime_error("Only REGULAR machines can be referenced, got " + machineType + " in " + fileName);
+        }
+        RegularMachineParser parser(file);
+        program = parser.parseBlock(path.parent_path().string())->getProgram(); // Interned by the parser.
+        references = recorder.getFiles();
+    }
+    FileRecorder::record({version});
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.fileLoads;
+    if (binary) {
+        program = internLocked(std::move(program));
+    }
+    files[path.string()] = LoadedFile{modificationTime, size, program, std::move(references)};
+    return program;
+}
+
+ProgramRegistry::Stats ProgramRegistry::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats current = stats;
+    current.programs = 0;
+    current.bytes = 0;
+    for (const auto& [key, bucket] : programs) {
+        for (const auto& weak : bucket) {
+            if (auto program = weak.lock()) {
+                ++current.programs;
+                current.bytes += program->size();
+            }
+        }
+    }
+    return current;
+}
+
+void ProgramRegistry::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    programs.clear();
+    names.clear();
+    files.clear();
+    stats = Stats();
+}
@@ -0,0 +1,121 @@
+/**
+ * @file ProgramRegistry.h
+ * @brief Process-wide table of compiled programs, deduplicated by content.
+ */
+#ifndef TURING_MACHINE_PROGRAMREGISTRY_H
+#define TURING_MACHINE_PROGRAMREGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../compiled/CompiledMachine.h"
+
+/**
+ * @class ProgramRegistry
+ * @brief Hands out one shared CompiledMachine per distinct program.
+ *
+ * Composite parsers intern every regular block they read, so blocks repeated across the
+ * composites of a process share one image. A block may also be a "USE <reference>" line,
+ * naming a program defined with define() or a REGULAR description or binary machine file;
+ * files are parsed once and parsed again only when they, or files they refer to, change.
+ * A FileRecorder lists the files a parse depended on. The registry holds interned
+ * programs weakly: a program is freed when the last machine using it goes away, unless it is
+ * defined under a name or was loaded from a file, which keeps it until it is undefined, the
+ * file is loaded again after a change, or the registry is cleared. Safe to use from several
+ * threads.
+ */
+class ProgramRegistry {
+public:
+    struct Stats {
+        std::uint64_t interned = 0;     ///< Programs passed to intern().
+        std::uint64_t deduplicated = 0; ///< Of those, programs replaced by an identical one.
+        std::uint64_t fileLoads = 0;    ///< Referenced files parsed or mapped.
+        std::uint64_t fileHits = 0;     ///< References answered without reading the file.
+        std::size_t programs = 0;       ///< Distinct programs alive.
+        std::size_t bytes = 0;          ///< Size of their images.
+    };
+
+    /// A file a program was read from, as it was when it was read.
+    struct FileVersion {
+        std::string path;
+        std::filesystem::file_time_type modificationTime;
+        std::uintmax_t size = 0;
+    };
+
+    /**
+     * @class FileRecorder
+     * @brief Collects the files that resolve() and load() read, or answer from, on this thread
+     * while the recorder is alive, with the files those refer to in turn. Recorders nest; an
+     * inner one passes its files on to the outer one when it goes away.
+     */
+    class FileRecorder {
+    public:
+        FileRecorder();
+        ~FileRecorder();
+
+        FileRecorder(const FileRecorder&) = delete;
+        FileRecorder& operator=(const FileRecorder&) = delete;
+
+        const std::vector<FileVersion>& getFiles() const { return files; }
+
+    private:
+        friend class ProgramRegistry;
+
+        static void record(const std::vector<FileVersion>& versions);
+
+        FileRecorder* outer;
+        std::vector<FileVersion> files;
+    };
+
+    /// Whether every file still has the modification time and size it was read with.
+    static bool isCurrent(const std::vector<FileVersion>& files);
+
+    /// The registry the parsers use.
+    static ProgramRegistry& global();
+
+    /// Returns the registered program identical to `program`, registering it if there is none.
+    std::shared_ptr<const CompiledMachine> intern(std::shared_ptr<const CompiledMachine> program);
+
+    /// Makes `USE name` refer to the program; it stays alive until undefined or cleared.
+    void define(const std::string& name, std::shared_ptr<const CompiledMachine> program);
+    void undefine(const std::string& name);
+
+    /**
+     * The program a USE line refers to: a defined name, otherwise a file path relative to
+     * `directory`, the directory of the file holding the line, or to the working directory if
+     * it is empty. Throws std::runtime_error when neither exists.
+     */
+    std::shared_ptr<const CompiledMachine> resolve(const std::string& reference, const std::string& directory = {});
+
+    /// Parses a REGULAR description, or maps a binary machine file, and interns the program.
+    std::shared_ptr<const CompiledMachine> load(const std::string& fileName);
+
+    Stats getStats() const;
+
+    /// Forgets every name, file and interned program; machines keep the programs they use.
+    void clear();
+
+private:
+    struct LoadedFile {
+        std::filesystem::file_time_type modificationTime;
+        std::uintmax_t size = 0;
+        std::shared_ptr<const CompiledMachine> program;
+        std::vector<FileVersion> references; ///< Files its own USE lines read.
+    };
+
+    std::shared_ptr<const CompiledMachine> internLocked(std::shared_ptr<const CompiledMachine> program);
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::uint64_t, std::vector<std::weak_ptr<const CompiledMachine>>> programs; ///< By image hash.
+    std::map<std::string, std::shared_ptr<const CompiledMachine>> names;
+    std::map<std::string, LoadedFile> files;                                                      ///< By canonical path; holds their programs.
+    Stats stats;
+};
+
+#endif //TURING_MACHINE_PROGRAMREGISTRY_H
@@ -0,0 +1,53 @@
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "LineChannel.h"
+
+LineChannel::LineChannel(int fd) : fd(fd) {}
+
+LineChannel::~LineChannel() {
+    ::close(fd);
+}
+
+bool LineChannel::readLine(std::string& line) {
+    while (true) {
+        std::size_t newline = buffer.find('\n', scanned);
+        if (newline != std::string::npos) {
+            line.assign(buffer, 0, newline);
+            buffer.erase(0, newline + 1);
+            scanned = 0;
+            return true;
+        }
+        scanned = buffer.size();
+
+        char chunk[4096];
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<std::size_t>(received));
+    }
+}
+
+bool LineChannel::write(const std::string& message) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    std::size_t sent = 0;
+    while (sent < message.size()) {
+        ssize_t written = ::send(fd, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        sent += static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+void LineChannel::shutdown() {
+    ::shutdown(fd, SHUT_RDWR);
+}
@@ -0,0 +1,39 @@
+/**
+ * @file LineChannel.h
+ * @brief Newline-delimited messages over a connected stream socket.
+ */
+#ifndef TURING_MACHINE_LINECHANNEL_H
+#define TURING_MACHINE_LINECHANNEL_H
+
+#include <mutex>
+#include <string>
+
+/**
+ * @class LineChannel
+ * @brief Owns a connected socket; one thread reads lines while any number of threads write them.
+ */
+class LineChannel {
+public:
+    explicit LineChannel(int fd);
+    ~LineChannel();
+
+    LineChannel(const LineChannel&) = delete;
+    LineChannel& operator=(const LineChannel&) = delete;
+
+    /// Reads the next line without its newline; false once the peer closed the connection.
+    bool readLine(std::string& line);
+
+    /// Writes a whole message atomically with respect to other writers; false if the peer is gone.
+    bool write(const std::string& message);
+
+    /// Ends both directions, waking a thread blocked in readLine().
+    void shutdown();
+
+private:
+    int fd;
+    std::string buffer;      ///< Bytes received after the last line returned.
+    std::size_t scanned = 0; ///< Prefix of the buffer known to contain no newline.
+    std::mutex writeMutex;
+};
+
+#endif //TURING_MACHINE_LINECHANNEL_H
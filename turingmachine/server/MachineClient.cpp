@@ -0,0 +1,54 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "MachineClient.h"
+#include "LineChannel.h"
+
+MachineClient::MachineClient(const std::string& socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to create socket: " + std::string(std::strerror(errno)));
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        std::string reason = std::strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Unable to connect to " + socketPath + ": " + reason);
+    }
+    channel = std::make_unique<LineChannel>(fd);
+}
+
+MachineClient::~MachineClient() = default;
+
+void MachineClient::send(const MachineRequest& request) {
+    if (!channel->write(MachineProtocol::formatRequest(request))) {
+        throw std::runtime_error("Connection closed by the server");
+    }
+}
+
+MachineResponse MachineClient::receive() {
+    std::string line;
+    if (!channel->readLine(line)) {
+        throw std::runtime_error("Connection closed by the server");
+    }
+    return MachineProtocol::parseResponse(line);
+}
+
+MachineResponse MachineClient::run(const MachineRequest& request) {
+    send(request);
+    return receive();
+}
+
+bool MachineClient::ping() {
+    std::string line;
+    return channel->write("PING\n") && channel->readLine(line) && line == "PONG";
+}
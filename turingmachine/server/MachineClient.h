@@ -0,0 +1,45 @@
+/**
+ * @file MachineClient.h
+ * @brief Client side of the MachineServer protocol.
+ */
+#ifndef TURING_MACHINE_MACHINECLIENT_H
+#define TURING_MACHINE_MACHINECLIENT_H
+
+#include <memory>
+#include <string>
+#include "MachineProtocol.h"
+
+class LineChannel;
+
+/**
+ * @class MachineClient
+ * @brief One connection to a MachineServer.
+ *
+ * Requests may be pipelined: send() any number of them and collect the responses with
+ * receive(), matching them by id. A client is meant to be used by one thread.
+ */
+class MachineClient {
+public:
+    /// Connects to the server; throws std::runtime_error when nothing listens on the path.
+    explicit MachineClient(const std::string& socketPath);
+    ~MachineClient();
+
+    MachineClient(const MachineClient&) = delete;
+    MachineClient& operator=(const MachineClient&) = delete;
+
+    void send(const MachineRequest& request);
+
+    /// Waits for the next response; throws std::runtime_error if the server closed the connection.
+    MachineResponse receive();
+
+    /// Sends a request and waits for its response; no other request may be outstanding.
+    MachineResponse run(const MachineRequest& request);
+
+    /// Whether the server answers a PING.
+    bool ping();
+
+private:
+    std::unique_ptr<LineChannel> channel;
+};
+
+#endif //TURING_MACHINE_MACHINECLIENT_H
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <stdexcept>
+#include "MachineProtocol.h"
+
+namespace {
+
+/// Cuts the next space-separated field off the front of `rest`.
+std::string nextField(std::string& rest, const std::string& line) {
+    if (rest.empty()) {
+        throw std::invalid_argument("Malformed message: " + line);
+    }
+    std::size_t space = rest.find(' ');
+    std::string field = rest.substr(0, space);
+    rest = space == std::string::npos ? std::string() : rest.substr(space + 1);
+    return field;
+}
+
+std::uint64_t parseNumber(const std::string& field, const std::string& line) {
+    if (field.empty() || field.find_first_not_of("0123456789") != std::string::npos) {
+        throw std::invalid_argument("Malformed message: " + line);
+    }
+    return std::stoull(field);
+}
+
+}
+
+std::string MachineProtocol::formatRequest(const MachineRequest& request) {
+    std::string line = "RUN " + std::to_string(request.id) + " " + std::to_string(request.maxSteps) + " " + request.machineFile;
+    if (request.tape) {
+        line += " " + *request.tape;
+    }
+    return line + "\n";
+}
+
+MachineRequest MachineProtocol::parseRequest(const std::string& line) {
+    std::string rest = line;
+    if (nextField(rest, line) != "RUN") {
+        throw std::invalid_argument("Unknown command: " + line.substr(0, line.find(' ')));
+    }
+    MachineRequest request;
+    request.id = parseNumber(nextField(rest, line), line);
+    request.maxSteps = parseNumber(nextField(rest, line), line);
+
+    std::size_t space = rest.find(' ');
+    request.machineFile = rest.substr(0, space);
+    if (request.machineFile.empty()) {
+        throw std::invalid_argument("Malformed message: " + line);
+    }
+    if (space != std::string::npos) {
+        request.tape = rest.substr(space + 1);
+    }
+    return request;
+}
+
+std::string MachineProtocol::formatResponse(const MachineResponse& response) {
+    if (!response.ok) {
+        std::string message = response.tape;
+        std::replace(message.begin(), message.end(), '\n', ' ');
+        return "ERR " + std::to_string(response.id) + " " + message + "\n";
+    }
+    return "OK " + std::to_string(response.id) + " " + statusName(response.status) + " " + std::to_string(response.steps)
+           + " " + std::to_string(response.microseconds) + " " + response.tape + "\n";
+}
+
+MachineResponse MachineProtocol::parseResponse(const std::string& line) {
+    std::string rest = line;
+    std::string kind = nextField(rest, line);
+    MachineResponse response;
+    if (kind == "ERR") {
+        response.id = parseNumber(nextField(rest, line), line);
+        response.tape = rest;
+        return response;
+    }
+    if (kind != "OK") {
+        throw std::invalid_argument("Malformed message: " + line);
+    }
+    response.ok = true;
+    response.id = parseNumber(nextField(rest, line), line);
+    response.status = parseStatus(nextField(rest, line));
+    response.steps = parseNumber(nextField(rest, line), line);
+    response.microseconds = parseNumber(nextField(rest, line), line);
+    response.tape = rest;
+    return response;
+}
+
+std::string MachineProtocol::statusName(TuringMachine::Status status) {
+    switch (status) {
+        case TuringMachine::Status::Halted: return "halted";
+        case TuringMachine::Status::Running: return "limit";
+        case TuringMachine::Status::NoTransition: return "stuck";
+    }
+    return "stuck";
+}
+
+TuringMachine::Status MachineProtocol::parseStatus(const std::string& name) {
+    if (name == "halted") {
+        return TuringMachine::Status::Halted;
+    }
+    if (name == "limit") {
+        return TuringMachine::Status::Running;
+    }
+    if (name == "stuck") {
+        return TuringMachine::Status::NoTransition;
+    }
+    throw std::invalid_argument("Unknown status: " + name);
+}
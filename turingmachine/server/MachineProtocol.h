@@ -0,0 +1,58 @@
+/**
+ * @file MachineProtocol.h
+ * @brief Line-based protocol spoken between tmserver and its clients.
+ *
+ * Every message is one line. A client sends
+ *
+ *     RUN <id> <max-steps> <machine-file>[ <tape>]
+ *
+ * where max-steps 0 means no limit and a missing tape runs the tape of the description.
+ * Everything after the space that follows the file name is the tape, blanks included. The
+ * server answers each request, in completion order, with
+ *
+ *     OK <id> <halted|limit|stuck> <steps> <microseconds> <tape>
+ *     ERR <id> <message>
+ *
+ * PING is answered with PONG.
+ */
+#ifndef TURING_MACHINE_MACHINEPROTOCOL_H
+#define TURING_MACHINE_MACHINEPROTOCOL_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "../machines/TuringMachine.h"
+
+struct MachineRequest {
+    std::uint64_t id = 0;
+    std::uint64_t maxSteps = 0;      ///< 0 runs until the machine stops.
+    std::string machineFile;         ///< Path of the description, as seen by the server.
+    std::optional<std::string> tape; ///< Input tape; the description's tape when empty.
+};
+
+struct MachineResponse {
+    std::uint64_t id = 0;
+    bool ok = false;
+    TuringMachine::Status status = TuringMachine::Status::Running;
+    std::uint64_t steps = 0;
+    std::uint64_t microseconds = 0; ///< Time spent running, excluding the queue.
+    std::string tape;               ///< The final tape, or the error message when not ok.
+};
+
+/**
+ * @class MachineProtocol
+ * @brief Formats and parses protocol lines; parse errors throw std::invalid_argument.
+ */
+class MachineProtocol {
+public:
+    static std::string formatRequest(const MachineRequest& request);
+    static MachineRequest parseRequest(const std::string& line);
+
+    static std::string formatResponse(const MachineResponse& response);
+    static MachineResponse parseResponse(const std::string& line);
+
+    static std::string statusName(TuringMachine::Status status);
+    static TuringMachine::Status parseStatus(const std::string& name);
+};
+
+#endif //TURING_MACHINE_MACHINEPROTOCOL_H
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "MachineServer.h"
+#include "LineChannel.h"
+#include "../trace/Trace.h"
+
+namespace {
+
+sockaddr_un socketAddress(const std::string& socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return address;
+}
+
+/// Whether a server is already accepting connections on the path.
+bool isListening(const sockaddr_un& address) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    bool connected = ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    ::close(fd);
+    return connected;
+}
+
+}
+
+MachineServer::MachineServer(std::string socketPath, std::size_t threads)
+        : socketPath(std::move(socketPath)), pool(threads) {
+}
+
+MachineServer::~MachineServer() {
+    stop();
+}
+
+void MachineServer::start() {
+    if (running) {
+        return;
+    }
+
+    sockaddr_un address = socketAddress(socketPath);
+    if (isListening(address)) {
+        throw std::runtime_error("Socket is already in use: " + socketPath);
+    }
+    ::unlink(socketPath.c_str()); // A socket file left behind by a server that did not stop cleanly.
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        throw std::runtime_error("Unable to create socket: " + std::string(std::strerror(errno)));
+    }
+    if (::bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(listenFd, SOMAXCONN) != 0) {
+        std::string reason = std::strerror(errno);
+        ::close(listenFd);
+        listenFd = -1;
+        throw std::runtime_error("Unable to listen on " + socketPath + ": " + reason);
+    }
+
+    cancelling = false;
+    running = true;
+    acceptor = std::thread(&MachineServer::acceptConnections, this);
+}
+
+void MachineServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    // Shutting the listening socket down wakes the blocked accept().
+    ::shutdown(listenFd, SHUT_RDWR);
+    acceptor.join();
+    ::close(listenFd);
+    listenFd = -1;
+    ::unlink(socketPath.c_str());
+
+    cancelling = true;
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    for (auto& connection : connections) {
+        connection->channel->shutdown();
+    }
+    for (auto& connection : connections) {
+        connection->reader.join();
+    }
+    pool.wait();
+    connections.clear();
+}
+
+void MachineServer::acceptConnections() {
+    while (running) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (running) {
+                std::cerr << "Unable to accept connection: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        auto connection = std::make_unique<Connection>();
+        connection->channel = std::make_shared<LineChannel>(fd);
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        reapFinishedConnections();
+        connection->reader = std::thread(&MachineServer::serve, this, std::ref(*connection));
+        connections.push_back(std::move(connection));
+    }
+}
+
+void MachineServer::reapFinishedConnections() {
+    for (auto it = connections.begin(); it != connections.end();) {
+        if ((*it)->finished) {
+            (*it)->reader.join();
+            it = connections.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MachineServer::serve(Connection& connection) {
+    std::shared_ptr<LineChannel> channel = connection.channel;
+    std::string line;
+    while (channel->readLine(line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (line == "PING") {
+            channel->write("PONG\n");
+            continue;
+        }
+
+        MachineRequest request;
+        try {
+            request = MachineProtocol::parseRequest(line);
+        } catch (const std::invalid_argument& e) {
+            MachineResponse error;
+            error.tape = e.what();
+            channel->write(MachineProtocol::formatResponse(error));
+            continue;
+        }
+
+        // Responses go straight back from the worker; the channel outlives the connection if needed.
+        pool.submit([this, channel, request = std::move(request)]() {
+            channel->write(MachineProtocol::formatResponse(execute(request)));
+        });
+    }
+    connection.finished = true;
+}
+
+MachineResponse MachineServer::execute(const MachineRequest& request) {
+    TM_TRACE_SCOPE("request");
+    MachineResponse response;
+    response.id = request.id;
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        auto machine = factory.getMachine(request.machineFile);
+        if (request.tape) {
+            machine->setInput(*request.tape);
+        }
+
+        std::uint64_t maxSteps = request.maxSteps == 0 ? TuringMachine::UNLIMITED : request.maxSteps;
+        std::uint64_t limit = stepLimit.load(std::memory_order_relaxed);
+        if (limit != 0 && limit < maxSteps) {
+            maxSteps = limit;
+        }
+        // Slices keep a machine that never stops from holding up stop().
+        std::uint64_t remaining = maxSteps;
+        do {
+            if (cancelling.load(std::memory_order_relaxed)) {
+                throw std::runtime_error("Request cancelled: the server is stopping");
+            }
+            const std::uint64_t slice = std::min(remaining, SLICE_STEPS);
+            response.status = machine->advance(slice);
+            if (remaining != TuringMachine::UNLIMITED) {
+                remaining -= slice;
+            }
+        } while (response.status == TuringMachine::Status::Running && remaining != 0);
+        response.steps = machine->getStepCount();
+        response.tape = machine->getOutput();
+        response.ok = true;
+    } catch (const std::exception& e) {
+        response.tape = e.what();
+    }
+    response.microseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+    requestCount.fetch_add(1, std::memory_order_relaxed);
+    return response;
+}
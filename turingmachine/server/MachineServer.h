@@ -0,0 +1,84 @@
+/**
+ * @file MachineServer.h
+ * @brief Long-lived server running machines for clients on a Unix domain socket.
+ */
+#ifndef TURING_MACHINE_MACHINESERVER_H
+#define TURING_MACHINE_MACHINESERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MachineProtocol.h"
+#include "../factory/TuringMachineFactory.h"
+#include "../concurrency/ThreadPool.h"
+
+class LineChannel;
+
+/**
+ * @class MachineServer
+ * @brief Accepts MachineProtocol requests and runs them on a thread pool.
+ *
+ * Machines come from one TuringMachineFactory, so a description is parsed and compiled on
+ * its first request and stays resident for later ones. Each connection has a reader thread
+ * that queues its requests; the pool runs them concurrently and writes every response back
+ * as soon as it is ready, so responses can come back in a different order than the requests.
+ *
+ * Machines run in slices of SLICE_STEPS steps, so stop() cancels requests that would never
+ * end after at most one slice; their responses report the cancellation as an error.
+ */
+class MachineServer {
+public:
+    static constexpr std::uint64_t SLICE_STEPS = 1 << 20;
+
+    /// Prepares a server on the socket path with the given number of workers (0 for one per core).
+    explicit MachineServer(std::string socketPath, std::size_t threads = 0);
+    ~MachineServer();
+
+    MachineServer(const MachineServer&) = delete;
+    MachineServer& operator=(const MachineServer&) = delete;
+
+    /// Binds the socket, replacing a stale socket file, and starts accepting connections.
+    void start();
+
+    /// Stops accepting, closes every connection, cancels the requests being run and waits for them.
+    void stop();
+
+    /// Caps the steps of every request, including those asking for no limit; 0 removes the cap.
+    void setStepLimit(std::uint64_t limit) { stepLimit.store(limit, std::memory_order_relaxed); }
+
+    /// Runs one request in the calling thread.
+    MachineResponse execute(const MachineRequest& request);
+
+    const std::string& getSocketPath() const { return socketPath; }
+    std::uint64_t getRequestCount() const { return requestCount.load(std::memory_order_relaxed); }
+    std::size_t getCacheSize() const { return factory.getCacheSize(); }
+
+private:
+    struct Connection {
+        std::shared_ptr<LineChannel> channel;
+        std::thread reader;
+        std::atomic<bool> finished{false};
+    };
+
+    void acceptConnections();
+    void serve(Connection& connection);
+    void reapFinishedConnections();
+
+    std::string socketPath;
+    TuringMachineFactory factory;
+    ThreadPool pool; ///< Declared after the factory, so it is drained before the factory goes away.
+    int listenFd = -1;
+    std::atomic<bool> running{false};
+    std::atomic<bool> cancelling{false}; ///< Set by stop() to end the requests being run.
+    std::thread acceptor;
+    std::mutex connectionsMutex;
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::atomic<std::uint64_t> requestCount{0};
+    std::atomic<std::uint64_t> stepLimit{0};
+};
+
+#endif //TURING_MACHINE_MACHINESERVER_H
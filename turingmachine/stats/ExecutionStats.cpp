@@ -0,0 +1,91 @@
+#include <algorithm>
+#include "ExecutionStats.h"
+
+namespace {
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            const char* digits = "0123456789abcdef";
+            out << "\\u00" << digits[(c >> 4) & 0xF] << digits[c & 0xF];
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}
+
+void ExecutionStats::reset(std::size_t stateCount, std::size_t transitionCount) {
+    steps = 0;
+    headTravel = 0;
+    minHeadOffset = 0;
+    maxHeadOffset = 0;
+    tapeGrowth = 0;
+    stateHits.assign(stateCount, 0);
+    transitionHits.assign(transitionCount, 0);
+}
+
+void ExecutionStats::bind(std::size_t stateCount, std::size_t transitionCount) {
+    if (stateHits.size() != stateCount || transitionHits.size() != transitionCount) {
+        stateHits.assign(stateCount, 0);
+        transitionHits.assign(transitionCount, 0);
+    }
+}
+
+std::vector<std::size_t> ExecutionStats::hottestTransitions(std::size_t top) const {
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < transitionHits.size(); ++i) {
+        if (transitionHits[i] != 0) {
+            indices.push_back(i);
+        }
+    }
+
+    auto hotter = [this](std::size_t a, std::size_t b) {
+        return transitionHits[a] != transitionHits[b] ? transitionHits[a] > transitionHits[b] : a < b;
+    };
+    if (top != 0 && top < indices.size()) {
+        std::partial_sort(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(top), indices.end(), hotter);
+        indices.resize(top);
+    } else {
+        std::sort(indices.begin(), indices.end(), hotter);
+    }
+    return indices;
+}
+
+void ExecutionStats::writeJson(std::ostream& out, const Labels& labels, std::size_t top) const {
+    out << "{\n";
+    out << "  \"steps\": " << steps << ",\n";
+    out << "  \"headTravel\": " << headTravel << ",\n";
+    out << "  \"minHeadOffset\": " << minHeadOffset << ",\n";
+    out << "  \"maxHeadOffset\": " << maxHeadOffset << ",\n";
+    out << "  \"tapeGrowth\": " << tapeGrowth << ",\n";
+
+    out << "  \"states\": [";
+    bool first = true;
+    for (std::size_t state = 0; state < stateHits.size(); ++state) {
+        if (stateHits[state] == 0) {
+            continue;
+        }
+        out << (first ? "\n    " : ",\n    ") << "{\"state\": ";
+        writeJsonString(out, labels.state ? labels.state(state) : std::to_string(state));
+        out << ", \"hits\": " << stateHits[state] << "}";
+        first = false;
+    }
+    out << (first ? "],\n" : "\n  ],\n");
+
+    out << "  \"transitions\": [";
+    first = true;
+    for (std::size_t index : hottestTransitions(top)) {
+        out << (first ? "\n    " : ",\n    ") << "{\"transition\": ";
+        writeJsonString(out, labels.transition ? labels.transition(index) : std::to_string(index));
+        out << ", \"hits\": " << transitionHits[index] << "}";
+        first = false;
+    }
+    out << (first ? "]\n" : "\n  ]\n");
+    out << "}\n";
+}
@@ -0,0 +1,61 @@
+/**
+ * @file ExecutionStats.h
+ * @brief Per-run counters collected by the machines when profiling is enabled.
+ */
+#ifndef TURING_MACHINE_EXECUTIONSTATS_H
+#define TURING_MACHINE_EXECUTIONSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @struct ExecutionStats
+ * @brief Counters of one execution, kept in flat arrays indexed by state id and transition index.
+ *
+ * Head offsets are relative to the head position when the counters were last reset.
+ */
+struct ExecutionStats {
+    /// Names the states and transitions of the program the counters refer to.
+    struct Labels {
+        std::function<std::string(std::size_t)> state;
+        std::function<std::string(std::size_t)> transition;
+    };
+
+    std::uint64_t steps = 0;         ///< Transitions taken.
+    std::uint64_t headTravel = 0;    ///< Cells moved by all heads together.
+    std::int64_t minHeadOffset = 0;  ///< Leftmost head offset reached.
+    std::int64_t maxHeadOffset = 0;  ///< Rightmost head offset reached.
+    std::uint64_t tapeGrowth = 0;    ///< Cells appended to the tape.
+    std::vector<std::uint64_t> stateHits;      ///< Steps taken in each state, by state id.
+    std::vector<std::uint64_t> transitionHits; ///< Times each transition was taken, by transition index.
+
+    /// Clears every counter and sizes the arrays for a program.
+    void reset(std::size_t stateCount, std::size_t transitionCount);
+
+    /// Sizes the arrays for a program, clearing them only if the program changed shape.
+    void bind(std::size_t stateCount, std::size_t transitionCount);
+
+    void recordHeadOffset(std::int64_t offset) {
+        if (offset < minHeadOffset) {
+            minHeadOffset = offset;
+        }
+        if (offset > maxHeadOffset) {
+            maxHeadOffset = offset;
+        }
+    }
+
+    /// Indices of the most frequently taken transitions, most frequent first; top 0 lists all.
+    std::vector<std::size_t> hottestTransitions(std::size_t top = 0) const;
+
+    /**
+     * Writes the counters as JSON. States and transitions that were never hit are left out,
+     * and at most `top` transitions are listed when top is not zero.
+     */
+    void writeJson(std::ostream& out, const Labels& labels, std::size_t top = 0) const;
+};
+
+#endif //TURING_MACHINE_EXECUTIONSTATS_H
@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <iomanip>
+#include "LatencySummary.h"
+
+namespace {
+
+std::uint64_t percentile(const std::vector<std::uint64_t>& sorted, std::size_t percent) {
+    // Nearest rank: the smallest value with at least `percent` of the values at or below it.
+    std::size_t rank = (percent * sorted.size() + 99) / 100;
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+}
+
+LatencySummary LatencySummary::of(std::vector<std::uint64_t>& nanoseconds) {
+    LatencySummary summary;
+    summary.count = nanoseconds.size();
+    if (nanoseconds.empty()) {
+        return summary;
+    }
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    summary.p50 = percentile(nanoseconds, 50);
+    summary.p90 = percentile(nanoseconds, 90);
+    summary.p99 = percentile(nanoseconds, 99);
+    summary.max = nanoseconds.back();
+    return summary;
+}
+
+void LatencySummary::writeMicroseconds(std::ostream& out) const {
+    auto micros = [](std::uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1e3; };
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1)
+        << "p50 " << micros(p50) << "  p90 " << micros(p90) << "  p99 " << micros(p99) << "  max " << micros(max);
+    out.flags(flags);
+    out.precision(precision);
+}
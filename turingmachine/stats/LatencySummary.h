@@ -0,0 +1,31 @@
+/**
+ * @file LatencySummary.h
+ * @brief Percentiles of a set of request latencies, as reported by the benchmark tools.
+ */
+#ifndef TURING_MACHINE_LATENCYSUMMARY_H
+#define TURING_MACHINE_LATENCYSUMMARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+ * @struct LatencySummary
+ * @brief Nearest-rank percentiles of latencies measured in nanoseconds.
+ */
+struct LatencySummary {
+    std::size_t count = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p90 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t max = 0;
+
+    /// Summarises the latencies; the vector is sorted in place.
+    static LatencySummary of(std::vector<std::uint64_t>& nanoseconds);
+
+    /// Writes "p50 .. p90 .. p99 .. max .." in microseconds.
+    void writeMicroseconds(std::ostream& out) const;
+};
+
+#endif //TURING_MACHINE_LATENCYSUMMARY_H
@@ -3,6 +3,10 @@
 #include<string>
 #include<iostream>
 #include<vector>
+#include<memory>
+#include<type_traits>
+#include<algorithm>
+#include "NodePool.h"
 
 template<typename T>
 struct LinkedNode{
@@ -17,23 +21,36 @@ struct LinkedNode{
 
 template<typename T>
 class DoublyLinkedList{
+public:
+    using Pool = NodePool<LinkedNode<T>>;
+
 private:
 
     LinkedNode<T>* head;
     LinkedNode<T>* tail;
+    std::shared_ptr<Pool> pool; ///< Allocates the nodes; may be shared with other lists.
+    std::vector<std::shared_ptr<Pool>> adoptedPools; ///< Pools of nodes spliced in from other lists.
 
 public:
 
     DoublyLinkedList();
+    explicit DoublyLinkedList(std::shared_ptr<Pool> pool);
     DoublyLinkedList(const DoublyLinkedList& other);
     DoublyLinkedList& operator=(const DoublyLinkedList& other);
+    DoublyLinkedList(DoublyLinkedList&& other) noexcept;
+    DoublyLinkedList& operator=(DoublyLinkedList&& other) noexcept;
     ~DoublyLinkedList();
 
+    void swap(DoublyLinkedList& other) noexcept;
+
     bool empty() const;
 
     void push_back(const T&);
     void push_front(const T&);
 
+    //appends a contiguous range, linking the new nodes in one pass
+    void append(const T* first, const T* last);
+
     void pop_back();
     void pop_front();
 
@@ -44,8 +61,11 @@ public:
     T& back();
     const T& back() const;
 
+    //releases all nodes; the pool keeps their memory for reuse
     void free();
 
+    const std::shared_ptr<Pool>& getPool() const;
+
 public:
     class Iterator{
     private:
@@ -54,7 +74,7 @@ public:
         LinkedNode<T>* currentNode;
 
     public:
-        bool valid(){
+        bool valid() const{
             return currentNode != nullptr;
         }
 
@@ -147,21 +167,61 @@ public:
     void delete_after(Iterator);
     void delete_at(Iterator);
 
+    //moves nodes of another list in front of the given position without copying them, O(1)
+    void splice(Iterator position, DoublyLinkedList& other);
+    void splice(Iterator position, DoublyLinkedList& other, Iterator first, Iterator last);
+
     //custom
     DoublyLinkedList makeList(const std::vector<T>&);
 
 private:
     void copyFrom(const DoublyLinkedList& other);
+    void adoptPoolsOf(const DoublyLinkedList& other);
+
+    Pool& nodePool(){
+        if(!pool){
+            pool = std::make_shared<Pool>();
+        }
+        return *pool;
+    }
+
+    //nodes are always returned to the pool whose memory they live in
+    Pool& poolOf(const LinkedNode<T>* node){
+        for(const auto& adopted : adoptedPools){
+            if(adopted->owns(node)){
+                return *adopted;
+            }
+        }
+        return nodePool();
+    }
 };
 
 template<typename T>
 void DoublyLinkedList<T>::free() {
+    if (pool.use_count() == 1 && adoptedPools.empty()) {
+        // Sole owner of the pool and no spliced-in nodes: release everything in bulk.
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (LinkedNode<T>* cur = head; cur != nullptr; cur = cur->next) {
+                cur->value.~T();
+            }
+        }
+        pool->releaseAll();
+        head = tail = nullptr;
+        return;
+    }
+
     while (head != nullptr) {
         LinkedNode<T>* temp = head;
         head = head->next;
-        delete temp;
+        poolOf(temp).destroy(temp);
     }
     tail = nullptr;
+    adoptedPools.clear();
+}
+
+template<typename T>
+const std::shared_ptr<typename DoublyLinkedList<T>::Pool>& DoublyLinkedList<T>::getPool() const {
+    return pool;
 }
 
 template<typename T>
@@ -173,12 +233,17 @@ void DoublyLinkedList<T>::copyFrom(const DoublyLinkedList<T>& other) {
 }
 
 template<typename T>
-DoublyLinkedList<T>::DoublyLinkedList(){
+DoublyLinkedList<T>::DoublyLinkedList() : pool(std::make_shared<Pool>()){
     head = tail = nullptr;
 }
 
 template<typename T>
-DoublyLinkedList<T>::DoublyLinkedList(const DoublyLinkedList<T>& other){
+DoublyLinkedList<T>::DoublyLinkedList(std::shared_ptr<Pool> _pool) : pool(std::move(_pool)){
+    head = tail = nullptr;
+}
+
+template<typename T>
+DoublyLinkedList<T>::DoublyLinkedList(const DoublyLinkedList<T>& other) : pool(std::make_shared<Pool>()){
     copyFrom(other);
 }
 
@@ -191,11 +256,45 @@ DoublyLinkedList<T>& DoublyLinkedList<T>::operator=(const DoublyLinkedList<T>& o
     return *this;
 }
 
+template<typename T>
+DoublyLinkedList<T>::DoublyLinkedList(DoublyLinkedList<T>&& other) noexcept
+        : head(other.head), tail(other.tail), pool(std::move(other.pool)), adoptedPools(std::move(other.adoptedPools)){
+    other.head = other.tail = nullptr;
+    other.adoptedPools.clear();
+}
+
+template<typename T>
+DoublyLinkedList<T>& DoublyLinkedList<T>::operator=(DoublyLinkedList<T>&& other) noexcept{
+    if(this != &other){
+        free();
+        head = other.head;
+        tail = other.tail;
+        pool = std::move(other.pool);
+        adoptedPools = std::move(other.adoptedPools);
+        other.head = other.tail = nullptr;
+        other.adoptedPools.clear();
+    }
+    return *this;
+}
+
 template<typename T>
 DoublyLinkedList<T>::~DoublyLinkedList(){
     free();
 }
 
+template<typename T>
+void DoublyLinkedList<T>::swap(DoublyLinkedList<T>& other) noexcept{
+    std::swap(head, other.head);
+    std::swap(tail, other.tail);
+    pool.swap(other.pool);
+    adoptedPools.swap(other.adoptedPools);
+}
+
+template<typename T>
+void swap(DoublyLinkedList<T>& first, DoublyLinkedList<T>& second) noexcept{
+    first.swap(second);
+}
+
 template<typename T>
 T& DoublyLinkedList<T>::front(){
     if(empty()){
@@ -235,19 +334,37 @@ bool DoublyLinkedList<T>::empty() const{
 template<typename T>
 void DoublyLinkedList<T>::push_back(const T& value) {
     if (empty()) {
-        head = tail = new LinkedNode<T>(value);
+        head = tail = nodePool().create(value);
     } else {
-        tail->next = new LinkedNode<T>(value, nullptr, tail);
+        tail->next = nodePool().create(value, nullptr, tail);
         tail = tail->next;
     }
 }
 
+template<typename T>
+void DoublyLinkedList<T>::append(const T* first, const T* last) {
+    if (first == last) {
+        return;
+    }
+    Pool& nodes = nodePool();
+    LinkedNode<T>* previous = tail;
+    if (previous == nullptr) {
+        previous = head = nodes.create(*first++);
+    }
+    for (; first != last; ++first) {
+        LinkedNode<T>* node = nodes.create(*first, nullptr, previous);
+        previous->next = node;
+        previous = node;
+    }
+    tail = previous;
+}
+
 template<typename T>
 void DoublyLinkedList<T>::push_front(const T& value) {
     if (empty()) {
-        head = tail = new LinkedNode<T>(value);
+        head = tail = nodePool().create(value);
     } else {
-        head->prev = new LinkedNode<T>(value, head, nullptr);
+        head->prev = nodePool().create(value, head, nullptr);
         head = head->prev;
     }
 }
@@ -267,7 +384,7 @@ void DoublyLinkedList<T>::pop_back() {
         head = nullptr;
     }
 
-    delete toDelete;
+    poolOf(toDelete).destroy(toDelete);
 }
 
 template<typename T>
@@ -285,7 +402,7 @@ void DoublyLinkedList<T>::pop_front() {
         tail = nullptr;
     }
 
-    delete toDelete;
+    poolOf(toDelete).destroy(toDelete);
 }
 
 
@@ -293,7 +410,7 @@ template<typename T>
 void DoublyLinkedList<T>::push_after(Iterator it, const T& value) {
     if (!it.valid()) throw std::runtime_error("Invalid iterator");
 
-    LinkedNode<T>* newNode = new LinkedNode<T>(value, it.currentNode->next, it.currentNode);
+    LinkedNode<T>* newNode = nodePool().create(value, it.currentNode->next, it.currentNode);
 
     if (it.currentNode->next) {
         it.currentNode->next->prev = newNode;
@@ -334,7 +451,7 @@ void DoublyLinkedList<T>::delete_at(Iterator it) {
     it.currentNode->prev->next = it.currentNode->next;
     it.currentNode->next->prev = it.currentNode->prev;
 
-    delete it.currentNode;
+    poolOf(it.currentNode).destroy(it.currentNode);
 }
 
 template<typename T>
@@ -351,6 +468,67 @@ void DoublyLinkedList<T>::delete_after(Iterator it) {
     delete_at(++it);
 }
 
+template<typename T>
+void DoublyLinkedList<T>::adoptPoolsOf(const DoublyLinkedList<T>& other) {
+    // Spliced nodes stay in the memory of the pool that created them, so keep that pool alive.
+    auto adopt = [this](const std::shared_ptr<Pool>& candidate) {
+        if (candidate && candidate != pool
+            && std::find(adoptedPools.begin(), adoptedPools.end(), candidate) == adoptedPools.end()) {
+            adoptedPools.push_back(candidate);
+        }
+    };
+    adopt(other.pool);
+    for (const auto& adopted : other.adoptedPools) {
+        adopt(adopted);
+    }
+}
+
+template<typename T>
+void DoublyLinkedList<T>::splice(Iterator position, DoublyLinkedList<T>& other) {
+    splice(position, other, other.begin(), other.end());
+}
+
+template<typename T>
+void DoublyLinkedList<T>::splice(Iterator position, DoublyLinkedList<T>& other, Iterator first, Iterator last) {
+    if (first == last) {
+        return;
+    }
+    if (this != &other) {
+        adoptPoolsOf(other);
+    }
+
+    LinkedNode<T>* firstNode = first.currentNode;
+    LinkedNode<T>* lastNode = last.valid() ? last.currentNode->prev : other.tail;
+
+    // Unlink [firstNode, lastNode] from the other list.
+    if (firstNode->prev) {
+        firstNode->prev->next = lastNode->next;
+    } else {
+        other.head = lastNode->next;
+    }
+    if (lastNode->next) {
+        lastNode->next->prev = firstNode->prev;
+    } else {
+        other.tail = firstNode->prev;
+    }
+
+    // Link it in front of position, or at the back when position is end().
+    LinkedNode<T>* before = position.valid() ? position.currentNode->prev : tail;
+    LinkedNode<T>* after = position.valid() ? position.currentNode : nullptr;
+    firstNode->prev = before;
+    lastNode->next = after;
+    if (before) {
+        before->next = firstNode;
+    } else {
+        head = firstNode;
+    }
+    if (after) {
+        after->prev = lastNode;
+    } else {
+        tail = lastNode;
+    }
+}
+
 template<typename T>
 DoublyLinkedList<T> DoublyLinkedList<T>::makeList(const std::vector<T>& container) {
     DoublyLinkedList<T> list;
@@ -0,0 +1,110 @@
+#ifndef TURING_MACHINE_NODEPOOL_H
+#define TURING_MACHINE_NODEPOOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @class NodePool
+ * @brief Slab allocator for fixed-size list nodes.
+ *
+ * Nodes are carved out of slabs that grow geometrically and are requested from an upstream
+ * memory resource. Freed nodes go to an intrusive free list. releaseAll() makes every slot
+ * available again in O(1) while keeping the slabs, so refilling a list after clearing it
+ * does not allocate.
+ */
+template<typename Node>
+class NodePool {
+public:
+    explicit NodePool(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : upstream(upstream), currentSlab(0), nextSlot(0), freeList(nullptr) {}
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool() {
+        for (const Slab& slab : slabs) {
+            upstream->deallocate(slab.slots, slab.size * sizeof(Slot), alignof(Slot));
+        }
+    }
+
+    template<typename... Args>
+    Node* create(Args&&... args) {
+        return new (allocate()) Node(std::forward<Args>(args)...);
+    }
+
+    void destroy(Node* node) {
+        node->~Node();
+        Slot* slot = reinterpret_cast<Slot*>(node);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    /// Returns every slot to the pool. Nodes with non-trivial destructors must be destroyed first.
+    void releaseAll() {
+        currentSlab = 0;
+        nextSlot = 0;
+        freeList = nullptr;
+    }
+
+    bool owns(const Node* node) const {
+        const auto* slot = reinterpret_cast<const Slot*>(node);
+        return std::any_of(slabs.begin(), slabs.end(), [slot](const Slab& slab) {
+            std::less<const Slot*> before;
+            return !before(slot, slab.slots) && before(slot, slab.slots + slab.size);
+        });
+    }
+
+    std::size_t capacity() const {
+        std::size_t total = 0;
+        for (const Slab& slab : slabs) {
+            total += slab.size;
+        }
+        return total;
+    }
+
+private:
+    static constexpr std::size_t FIRST_SLAB_SIZE = 64;
+    static constexpr std::size_t MAX_SLAB_SIZE = 64 * 1024;
+
+    union Slot {
+        Slot* next;
+        alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+
+    struct Slab {
+        Slot* slots;
+        std::size_t size;
+    };
+
+    void* allocate() {
+        if (freeList != nullptr) {
+            Slot* slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        while (currentSlab < slabs.size() && nextSlot == slabs[currentSlab].size) {
+            ++currentSlab;
+            nextSlot = 0;
+        }
+        if (currentSlab == slabs.size()) {
+            std::size_t size = slabs.empty() ? FIRST_SLAB_SIZE : std::min(slabs.back().size * 2, MAX_SLAB_SIZE);
+            void* memory = upstream->allocate(size * sizeof(Slot), alignof(Slot));
+            slabs.push_back(Slab{static_cast<Slot*>(memory), size});
+        }
+        return &slabs[currentSlab].slots[nextSlot++];
+    }
+
+    std::pmr::memory_resource* upstream;
+    std::vector<Slab> slabs;
+    std::size_t currentSlab; ///< Slab the bump pointer is in.
+    std::size_t nextSlot;    ///< Next never-used slot in the current slab.
+    Slot* freeList;
+};
+
+#endif //TURING_MACHINE_NODEPOOL_H
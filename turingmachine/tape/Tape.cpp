@@ -0,0 +1,351 @@
+#include "Tape.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Tape::Tape()
+        : block(0), head(nullptr), blockBegin(nullptr), blockEnd(nullptr), position(0), length(0), offset(0), loaded(0) {
+}
+
+Tape::Tape(std::string_view contents, std::size_t headPosition) : Tape() {
+    assign(contents, headPosition);
+}
+
+Tape::Tape(const Tape& other)
+        : block(0), head(nullptr), blockBegin(nullptr), blockEnd(nullptr), position(other.position),
+          length(other.length), source(other.source), offset(other.offset), loaded(other.loaded) {
+    for (const Block& stored : other.blocks) {
+        Block copy{std::unique_ptr<char[]>(new char[stored.size]), stored.size, stored.size};
+        std::memcpy(copy.cells.get(), stored.cells.get(), stored.size);
+        blocks.push_back(std::move(copy));
+    }
+    if (other.head != nullptr) {
+        locate();
+    }
+}
+
+Tape& Tape::operator=(const Tape& other) {
+    if (this != &other) {
+        Tape copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+Tape::Tape(Tape&& other) noexcept : Tape() {
+    swap(other);
+}
+
+Tape& Tape::operator=(Tape&& other) noexcept {
+    if (this != &other) {
+        swap(other);
+        other.reset();
+    }
+    return *this;
+}
+
+void Tape::swap(Tape& other) noexcept {
+    blocks.swap(other.blocks);
+    std::swap(block, other.block);
+    std::swap(head, other.head);
+    std::swap(blockBegin, other.blockBegin);
+    std::swap(blockEnd, other.blockEnd);
+    std::swap(position, other.position);
+    std::swap(length, other.length);
+    source.swap(other.source);
+    std::swap(offset, other.offset);
+    std::swap(loaded, other.loaded);
+}
+
+void Tape::assign(std::string_view contents, std::size_t headPosition) {
+    reset();
+    append(contents.data(), contents.data() + contents.size());
+    finishLoad(headPosition);
+}
+
+void Tape::load(std::istream& in, std::size_t headPosition) {
+    reset();
+    // istream::getline scans the stream buffer in bulk, unlike reading one character at a time.
+    std::unique_ptr<char[]> chunk(new char[LOAD_CHUNK_SIZE]);
+    bool full = true;
+    while (full) {
+        in.getline(chunk.get(), LOAD_CHUNK_SIZE);
+        const auto count = static_cast<std::size_t>(in.gcount());
+        const bool delimited = in.good() && count != 0;
+        full = in.fail() && !in.eof() && count == LOAD_CHUNK_SIZE - 1;
+        append(chunk.get(), chunk.get() + (delimited ? count - 1 : count));
+        if (full) {
+            in.clear(in.rdstate() & ~std::ios::failbit);
+        }
+    }
+    if (length != 0 && blocks.back().cells[blocks.back().size - 1] == '\r') {
+        if (--blocks.back().size == 0) {
+            blocks.pop_back();
+        }
+        --length;
+    }
+    finishLoad(headPosition);
+}
+
+void Tape::loadFile(const std::string& fileName, std::size_t headPosition) {
+#if defined(_WIN32)
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+    load(file, headPosition);
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Unable to read file: " + fileName);
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    if (size == 0 || !S_ISREG(info.st_mode)) {
+        // Pipes and other special files cannot be mapped; read them instead.
+        ::close(fd);
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Unable to open file: " + fileName);
+        }
+        load(file, headPosition);
+        return;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Unable to map file: " + fileName);
+    }
+    struct Unmap {
+        void* mapping;
+        std::size_t size;
+        ~Unmap() { munmap(mapping, size); }
+    } unmap{mapping, size};
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    const char* first = static_cast<const char*>(mapping);
+    const auto* newline = static_cast<const char*>(std::memchr(first, '\n', size));
+    const char* last = newline != nullptr ? newline : first + size;
+    if (last != first && last[-1] == '\r') {
+        --last;
+    }
+
+    reset();
+    // Drop the file pages already copied, so the mapping does not double the footprint.
+    const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const char* released = first;
+    while (first != last) {
+        const char* next = first + std::min<std::size_t>(LOAD_CHUNK_SIZE, static_cast<std::size_t>(last - first));
+        append(first, next);
+        first = next;
+        const std::size_t done = static_cast<std::size_t>(first - released) / pageSize * pageSize;
+        if (done != 0) {
+            madvise(const_cast<char*>(released), done, MADV_DONTNEED);
+            released += done;
+        }
+    }
+    finishLoad(headPosition);
+#endif
+}
+
+void Tape::append(const char* first, const char* last) {
+    appendCells(first, last);
+    length += static_cast<std::size_t>(last - first);
+}
+
+void Tape::appendCells(const char* first, const char* last) {
+    while (first != last) {
+        const auto count = static_cast<std::size_t>(last - first);
+        if (blocks.empty() || blocks.back().size == BLOCK_SIZE) {
+            // Only a first block starts small; later ones are filled anyway.
+            const std::size_t capacity = blocks.empty() ? std::min(count, BLOCK_SIZE) : BLOCK_SIZE;
+            blocks.push_back({std::unique_ptr<char[]>(new char[capacity]), 0, capacity});
+        }
+        Block& back = blocks.back();
+        if (back.size == back.capacity) {
+            const std::size_t capacity = std::min(BLOCK_SIZE, std::max(2 * back.capacity, back.size + count));
+            std::unique_ptr<char[]> grown(new char[capacity]);
+            std::memcpy(grown.get(), back.cells.get(), back.size);
+            if (head != nullptr && block == blocks.size() - 1) {
+                head = grown.get() + (head - blockBegin);
+                blockEnd = grown.get() + (blockEnd - blockBegin);
+                blockBegin = grown.get();
+            }
+            back.cells = std::move(grown);
+            back.capacity = capacity;
+        }
+        const std::size_t copied = std::min(count, back.capacity - back.size);
+        std::memcpy(back.cells.get() + back.size, first, copied);
+        back.size += copied;
+        first += copied;
+    }
+}
+
+void Tape::appendBlanks(std::size_t count) {
+    char blanks[256];
+    std::memset(blanks, BLANK, sizeof(blanks));
+    while (count != 0) {
+        const std::size_t chunk = std::min(count, sizeof(blanks));
+        appendCells(blanks, blanks + chunk);
+        count -= chunk;
+    }
+}
+
+void Tape::finishLoad(std::size_t headPosition) {
+    position = 0;
+    setHeadPosition(headPosition);
+}
+
+void Tape::setHeadPosition(std::size_t headPosition) {
+    if (length == 0) {
+        if (headPosition == 0) {
+            return;
+        }
+        ensureCell();
+    }
+    while (source && headPosition < offset) {
+        loadBlockLeft();
+    }
+    while (source && offset + loaded <= headPosition) {
+        loadBlockRight();
+    }
+    releaseSource();
+    if (length <= headPosition) {
+        appendBlanks(headPosition + 1 - length);
+        length = headPosition + 1;
+    }
+    position = headPosition;
+    locate();
+}
+
+void Tape::locate() {
+    const std::size_t index = position - offset;
+    block = index / BLOCK_SIZE;
+    Block& stored = blocks[block];
+    blockBegin = stored.cells.get();
+    blockEnd = blockBegin + stored.size;
+    head = blockBegin + index % BLOCK_SIZE;
+}
+
+void Tape::stepLeft() {
+    // The head left the first cell of its block; a mapped tape may have to load the block before.
+    if (block == 0) {
+        loadBlockLeft();
+        releaseSource();
+    }
+    locate();
+}
+
+void Tape::stepRight() {
+    if (block + 1 == blocks.size()) {
+        // Past the last loaded cell: load the next block of a mapped tape, or append a blank.
+        if (source) {
+            loadBlockRight();
+            releaseSource();
+        } else {
+            const char blank = BLANK;
+            appendCells(&blank, &blank + 1);
+            ++length;
+        }
+    }
+    locate();
+}
+
+void Tape::ensureCell() {
+    if (length == 0) {
+        const char blank = BLANK;
+        appendCells(&blank, &blank + 1);
+        position = 0;
+        length = 1;
+        locate();
+    }
+}
+
+std::string Tape::toString() const {
+    std::string contents;
+    contents.reserve(length);
+    forEachChunk([&contents](const char* chunk, std::size_t count) {
+        contents.append(chunk, count);
+    });
+    return contents;
+}
+
+void Tape::writeTo(std::ostream& out) const {
+    forEachChunk([&out](const char* chunk, std::size_t count) {
+        out.write(chunk, static_cast<std::streamsize>(count));
+    });
+}
+
+void Tape::map(std::shared_ptr<const TapeSource> tapeSource, std::size_t headPosition) {
+    reset();
+    if (tapeSource->size() != 0) {
+        source = std::move(tapeSource);
+        length = source->size();
+        offset = std::min(headPosition, length - 1) / BLOCK_SIZE * BLOCK_SIZE;
+        loadBlockRight();
+        position = offset;
+        releaseSource();
+    }
+    setHeadPosition(headPosition);
+}
+
+void Tape::reset() {
+    blocks.clear();
+    block = 0;
+    head = nullptr;
+    blockBegin = nullptr;
+    blockEnd = nullptr;
+    position = 0;
+    length = 0;
+    source.reset();
+    offset = 0;
+    loaded = 0;
+}
+
+void Tape::loadBlockLeft() {
+    // Loaded blocks start at multiples of BLOCK_SIZE, so the one before is always whole.
+    const std::size_t first = offset - BLOCK_SIZE;
+    std::string_view cells = source->range(first, offset);
+    blocks.push_front({std::unique_ptr<char[]>(new char[BLOCK_SIZE]), BLOCK_SIZE, BLOCK_SIZE});
+    std::memcpy(blocks.front().cells.get(), cells.data(), BLOCK_SIZE);
+    if (head != nullptr) {
+        ++block;
+    }
+    offset = first;
+    loaded += BLOCK_SIZE;
+}
+
+void Tape::loadBlockRight() {
+    const std::size_t next = offset + loaded;
+    if (next < source->size()) {
+        std::string_view cells = source->block(next / BLOCK_SIZE);
+        appendCells(cells.data(), cells.data() + cells.size());
+        loaded += cells.size();
+    } else {
+        const char blank = BLANK;
+        appendCells(&blank, &blank + 1);
+        ++loaded;
+        ++length;
+    }
+}
+
+void Tape::releaseSource() {
+    // Once every cell is loaded the tape no longer differs from an ordinary one.
+    if (source && offset == 0 && loaded >= source->size()) {
+        source.reset();
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef TURING_MACHINE_TAPE_H
+#define TURING_MACHINE_TAPE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "TapeSource.h"
+
+/**
+ * @class Tape
+ * @brief A semi-infinite tape with a read/write head.
+ *
+ * The tape is bounded on the left: moving left from the first cell keeps the head in place.
+ * Moving right past the last cell appends a blank. The head position is tracked as an index,
+ * so reading it is O(1).
+ *
+ * Cells are stored in blocks of BLOCK_SIZE contiguous chars, so a tape takes about one byte per
+ * cell; only the last block may be shorter, and it grows as cells are appended.
+ *
+ * A tape mapped from a TapeSource holds only a window of whole blocks around the cells the
+ * head has visited; the rest is read from the source, which copies of the tape share.
+ */
+class Tape {
+public:
+    static constexpr char BLANK = ' ';
+    /// Cells per block; the blocks of a mapped tape line up with the blocks of its source.
+    static constexpr std::size_t BLOCK_SIZE = TapeSource::BLOCK_SIZE;
+
+    Tape();
+    explicit Tape(std::string_view contents, std::size_t headPosition = 0);
+    Tape(const Tape& other);
+    Tape& operator=(const Tape& other);
+    /// Moves keep the cells in place, so the head stays on the same cell.
+    Tape(Tape&& other) noexcept;
+    Tape& operator=(Tape&& other) noexcept;
+
+    void swap(Tape& other) noexcept;
+
+    void assign(std::string_view contents, std::size_t headPosition = 0);
+
+    /**
+     * Replaces the contents with the first line of a stream, written as in the description
+     * files. The line is read in large chunks straight into the cells, so a tape of any length
+     * is never held as a string; a trailing '\r' is dropped.
+     */
+    void load(std::istream& in, std::size_t headPosition = 0);
+
+    /// Like load() on the first line of a file, which is memory-mapped where the platform allows.
+    void loadFile(const std::string& fileName, std::size_t headPosition = 0);
+
+    /**
+     * Replaces the contents with a mapped tape file, loading only the block under the head.
+     * Neighbouring blocks are loaded when the head first reaches them, so memory grows with
+     * the part of the tape the machine visits rather than with its length.
+     */
+    void map(std::shared_ptr<const TapeSource> source, std::size_t headPosition = 0);
+
+    /// Reads the symbol under the head. The tape must not be empty.
+    char read() const {
+        return *head;
+    }
+
+    /// Writes a symbol under the head. The tape must not be empty.
+    void write(char symbol) {
+        *head = symbol;
+    }
+
+    void moveLeft() {
+        if (position > 0) {
+            --position;
+            if (head != blockBegin) {
+                --head;
+            } else {
+                stepLeft();
+            }
+        }
+    }
+
+    void moveRight() {
+        ++position;
+        if (++head == blockEnd) {
+            stepRight();
+        }
+    }
+
+    /// Moves the head to an absolute position, extending the tape with blanks if needed.
+    void setHeadPosition(std::size_t headPosition);
+    std::size_t getHeadPosition() const { return position; }
+
+    /// Adds a blank cell under the head if the tape has no cells yet.
+    void ensureCell();
+
+    bool empty() const { return length == 0; }
+    std::size_t size() const { return length; }
+    /// Cells held in memory, which is size() unless part of a mapped tape is not loaded yet.
+    std::size_t loadedSize() const { return source ? loaded : length; }
+
+    std::string toString() const;
+    void writeTo(std::ostream& out) const;
+
+    /**
+     * Calls visit(const char* cells, std::size_t count) on consecutive pieces of the tape, in
+     * order, so the tape can be written or encoded without building a string. Only the first
+     * `limit` cells are visited.
+     */
+    template<typename Visit>
+    void forEachChunk(Visit&& visit, std::size_t limit = static_cast<std::size_t>(-1)) const;
+
+private:
+    friend class TapeCodec;
+
+    static constexpr std::size_t LOAD_CHUNK_SIZE = 1 << 20;
+
+    /// Contiguous cells; every block but the last holds BLOCK_SIZE of them.
+    struct Block {
+        std::unique_ptr<char[]> cells;
+        std::size_t size = 0;     ///< Cells in use.
+        std::size_t capacity = 0; ///< Cells allocated, below BLOCK_SIZE only while the last block grows.
+    };
+
+    void reset();
+    void append(const char* first, const char* last);
+    void finishLoad(std::size_t headPosition);
+
+    /// Stores cells after the loaded ones, without counting them in length or loaded.
+    void appendCells(const char* first, const char* last);
+    void appendBlanks(std::size_t count);
+    /// Points the head at the cell at `position`, which must be loaded.
+    void locate();
+    void stepLeft();
+    void stepRight();
+
+    void loadBlockLeft();
+    void loadBlockRight();
+    void releaseSource();
+
+    std::deque<Block> blocks;   ///< The loaded cells, from `offset` on.
+    std::size_t block;          ///< Index of the block under the head.
+    char* head;                 ///< The cell under the head; null while the tape has none.
+    char* blockBegin;           ///< First cell of the block under the head.
+    char* blockEnd;             ///< Past the last used cell of the block under the head.
+    std::size_t position;
+    std::size_t length;
+    std::shared_ptr<const TapeSource> source; ///< Backs the cells not loaded yet; null once every cell is.
+    std::size_t offset;                       ///< Index of the first loaded cell.
+    std::size_t loaded;                       ///< Loaded cells while there is a source.
+};
+
+template<typename Visit>
+void Tape::forEachChunk(Visit&& visit, std::size_t limit) const {
+    std::size_t left = std::min(limit, length);
+    if (source && offset != 0 && left != 0) {
+        const std::size_t count = std::min(offset, left);
+        visit(source->data(), count);
+        left -= count;
+    }
+    for (const Block& stored : blocks) {
+        if (left == 0) {
+            return;
+        }
+        const std::size_t count = std::min(stored.size, left);
+        visit(static_cast<const char*>(stored.cells.get()), count);
+        left -= count;
+    }
+    if (source && offset + loaded < source->size() && left != 0) {
+        std::string_view rest = source->range(offset + loaded, offset + loaded + std::min(left, source->size() - offset - loaded));
+        visit(rest.data(), rest.size());
+    }
+}
+
+#endif //TURING_MACHINE_TAPE_H
@@ -0,0 +1,282 @@
+#include "TapeCodec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#ifdef TM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr char RLE_MAGIC[4] = {'\x89', 'T', 'M', 'R'};
+constexpr char DEFLATE_MAGIC[4] = {'\x89', 'T', 'M', 'Z'};
+
+bool startsCompressed(std::istream& in) {
+    return in.peek() == std::char_traits<char>::to_int_type(RLE_MAGIC[0]);
+}
+
+/// Hands out the bytes of a stream one at a time, reading it a chunk at a time.
+class ChunkReader {
+public:
+    ChunkReader(std::istream& in, std::size_t chunkSize) : in(in), chunk(new char[chunkSize]), chunkSize(chunkSize) {}
+
+    bool next(char& byte) {
+        if (position == available) {
+            in.read(chunk.get(), static_cast<std::streamsize>(chunkSize));
+            available = static_cast<std::size_t>(in.gcount());
+            position = 0;
+            if (available == 0) {
+                return false;
+            }
+        }
+        byte = chunk[position++];
+        return true;
+    }
+
+private:
+    std::istream& in;
+    std::unique_ptr<char[]> chunk;
+    std::size_t chunkSize;
+    std::size_t position = 0;
+    std::size_t available = 0;
+};
+
+}
+
+bool TapeCodec::isAvailable(Format format) {
+#ifdef TM_HAVE_ZLIB
+    constexpr bool haveZlib = true;
+#else
+    constexpr bool haveZlib = false;
+#endif
+    return haveZlib || format != Format::Deflate;
+}
+
+TapeCodec::Format TapeCodec::parseFormat(const std::string& name) {
+    for (Format format : {Format::Raw, Format::Rle, Format::Deflate}) {
+        if (formatName(format) == name) {
+            return format;
+        }
+    }
+    throw std::invalid_argument("Unknown tape format: " + name);
+}
+
+std::string TapeCodec::formatName(Format format) {
+    switch (format) {
+        case Format::Raw: return "raw";
+        case Format::Rle: return "rle";
+        case Format::Deflate: return "deflate";
+    }
+    return "";
+}
+
+void TapeCodec::write(const Tape& tape, std::ostream& out, Format format) {
+    switch (format) {
+        case Format::Raw:
+            tape.writeTo(out);
+            return;
+        case Format::Rle:
+            writeRle(tape, out);
+            return;
+        case Format::Deflate:
+#ifdef TM_HAVE_ZLIB
+            writeDeflate(tape, out);
+            return;
+#else
+            throw std::invalid_argument("Deflate-compressed tapes need a build with zlib");
+#endif
+    }
+}
+
+void TapeCodec::read(std::istream& in, Tape& tape, std::size_t headPosition) {
+    if (!startsCompressed(in)) {
+        tape.load(in, headPosition);
+        return;
+    }
+
+    char magic[sizeof(RLE_MAGIC)];
+    if (!in.read(magic, sizeof(magic))) {
+        throw std::runtime_error("Corrupted compressed tape");
+    }
+    tape.reset();
+    if (std::memcmp(magic, RLE_MAGIC, sizeof(magic)) == 0) {
+        readRle(in, tape);
+    } else if (std::memcmp(magic, DEFLATE_MAGIC, sizeof(magic)) == 0) {
+#ifdef TM_HAVE_ZLIB
+        readDeflate(in, tape);
+#else
+        throw std::runtime_error("Deflate-compressed tapes need a build with zlib");
+#endif
+    } else {
+        throw std::runtime_error("Unknown compressed tape format");
+    }
+    tape.finishLoad(headPosition);
+}
+
+void TapeCodec::readFile(const std::string& fileName, Tape& tape, std::size_t headPosition) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+    if (!startsCompressed(file)) {
+        file.close();
+        tape.loadFile(fileName, headPosition);
+        return;
+    }
+    try {
+        read(file, tape, headPosition);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(std::string(e.what()) + ": " + fileName);
+    }
+}
+
+void TapeCodec::writeRle(const Tape& tape, std::ostream& out) {
+    out.write(RLE_MAGIC, sizeof(RLE_MAGIC));
+    std::string encoded;
+    encoded.reserve(CHUNK_SIZE + 16);
+    char symbol = 0;
+    std::uint64_t run = 0;
+    auto endRun = [&]() {
+        std::uint64_t rest = run;
+        do {
+            auto byte = static_cast<unsigned char>(rest & 0x7F);
+            rest >>= 7;
+            encoded.push_back(static_cast<char>(rest != 0 ? byte | 0x80 : byte));
+        } while (rest != 0);
+        encoded.push_back(symbol);
+        if (encoded.size() >= CHUNK_SIZE) {
+            out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+            encoded.clear();
+        }
+    };
+
+    tape.forEachChunk([&](const char* cells, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (run != 0 && cells[i] == symbol) {
+                ++run;
+                continue;
+            }
+            if (run != 0) {
+                endRun();
+            }
+            symbol = cells[i];
+            run = 1;
+        }
+    });
+    if (run != 0) {
+        endRun();
+    }
+    out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+}
+
+void TapeCodec::readRle(std::istream& in, Tape& tape) {
+    ChunkReader reader(in, CHUNK_SIZE);
+    std::unique_ptr<char[]> chunk(new char[CHUNK_SIZE]);
+    std::size_t used = 0;
+    char byte;
+    while (reader.next(byte)) {
+        std::uint64_t run = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            run |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+            if (shift + 7 >= 64 || !reader.next(byte)) {
+                throw std::runtime_error("Corrupted compressed tape");
+            }
+        }
+        char symbol;
+        if (!reader.next(symbol)) {
+            throw std::runtime_error("Corrupted compressed tape");
+        }
+
+        while (run != 0) {
+            const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(run, CHUNK_SIZE - used));
+            std::memset(chunk.get() + used, symbol, count);
+            used += count;
+            run -= count;
+            if (used == CHUNK_SIZE) {
+                tape.append(chunk.get(), chunk.get() + used);
+                used = 0;
+            }
+        }
+    }
+    tape.append(chunk.get(), chunk.get() + used);
+}
+
+#ifdef TM_HAVE_ZLIB
+
+void TapeCodec::writeDeflate(const Tape& tape, std::ostream& out) {
+    z_stream stream{};
+    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        throw std::runtime_error("Unable to start compressing the tape");
+    }
+    struct End {
+        z_stream& stream;
+        ~End() { deflateEnd(&stream); }
+    } end{stream};
+
+    out.write(DEFLATE_MAGIC, sizeof(DEFLATE_MAGIC));
+    std::unique_ptr<unsigned char[]> output(new unsigned char[CHUNK_SIZE]);
+    auto compress = [&](const char* cells, std::size_t count, int flush) {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(cells));
+        stream.avail_in = static_cast<uInt>(count);
+        do {
+            stream.next_out = output.get();
+            stream.avail_out = static_cast<uInt>(CHUNK_SIZE);
+            deflate(&stream, flush);
+            out.write(reinterpret_cast<const char*>(output.get()),
+                      static_cast<std::streamsize>(CHUNK_SIZE - stream.avail_out));
+        } while (stream.avail_out == 0);
+    };
+
+    tape.forEachChunk([&](const char* cells, std::size_t count) {
+        // A mapped part of the tape can exceed what one call to deflate() takes.
+        while (count != 0) {
+            const std::size_t piece = std::min(count, CHUNK_SIZE);
+            compress(cells, piece, Z_NO_FLUSH);
+            cells += piece;
+            count -= piece;
+        }
+    });
+    compress(nullptr, 0, Z_FINISH);
+}
+
+void TapeCodec::readDeflate(std::istream& in, Tape& tape) {
+    z_stream stream{};
+    if (inflateInit(&stream) != Z_OK) {
+        throw std::runtime_error("Unable to start decompressing the tape");
+    }
+    struct End {
+        z_stream& stream;
+        ~End() { inflateEnd(&stream); }
+    } end{stream};
+
+    std::unique_ptr<char[]> input(new char[CHUNK_SIZE]);
+    std::unique_ptr<char[]> output(new char[CHUNK_SIZE]);
+    int status = Z_OK;
+    while (status != Z_STREAM_END) {
+        if (stream.avail_in == 0) {
+            in.read(input.get(), static_cast<std::streamsize>(CHUNK_SIZE));
+            stream.next_in = reinterpret_cast<Bytef*>(input.get());
+            stream.avail_in = static_cast<uInt>(in.gcount());
+            if (stream.avail_in == 0) {
+                throw std::runtime_error("Corrupted compressed tape");
+            }
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(output.get());
+        stream.avail_out = static_cast<uInt>(CHUNK_SIZE);
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END) {
+            throw std::runtime_error("Corrupted compressed tape");
+        }
+        tape.append(output.get(), output.get() + (CHUNK_SIZE - stream.avail_out));
+    }
+}
+
+#endif
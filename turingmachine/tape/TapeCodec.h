@@ -0,0 +1,59 @@
+#ifndef TURING_MACHINE_TAPECODEC_H
+#define TURING_MACHINE_TAPECODEC_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include "Tape.h"
+
+/**
+ * @class TapeCodec
+ * @brief Compressed encodings of a tape, for final tapes written to disk and for input tapes.
+ *
+ * Raw tapes are the characters of the tape, as in the description files. Compressed tapes
+ * start with a magic number whose first byte, 0x89, never begins a raw tape, so readers tell
+ * the formats apart on their own:
+ *  - Rle: "\x89TMR" followed by runs, each a LEB128 length and the repeated symbol.
+ *  - Deflate: "\x89TMZ" followed by a zlib stream of the raw tape; only built with zlib.
+ * Tapes are encoded and decoded in chunks, never as a whole string.
+ */
+class TapeCodec {
+public:
+    enum class Format {
+        Raw,
+        Rle,
+        Deflate
+    };
+
+    /// Whether the library was built with support for `format`.
+    static bool isAvailable(Format format);
+
+    /// The format named "raw", "rle" or "deflate"; throws std::invalid_argument otherwise.
+    static Format parseFormat(const std::string& name);
+    static std::string formatName(Format format);
+
+    /// Writes the tape in `format`; throws std::invalid_argument if it is not available.
+    static void write(const Tape& tape, std::ostream& out, Format format);
+
+    /**
+     * Replaces the contents of `tape` with a tape read from `in` in any format. A raw tape is
+     * read up to the end of its line, as Tape::load() does.
+     */
+    static void read(std::istream& in, Tape& tape, std::size_t headPosition = 0);
+
+    /// Like read() on a file; raw tapes are loaded with Tape::loadFile().
+    static void readFile(const std::string& fileName, Tape& tape, std::size_t headPosition = 0);
+
+private:
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    static void writeRle(const Tape& tape, std::ostream& out);
+    static void readRle(std::istream& in, Tape& tape);
+#ifdef TM_HAVE_ZLIB
+    static void writeDeflate(const Tape& tape, std::ostream& out);
+    static void readDeflate(std::istream& in, Tape& tape);
+#endif
+};
+
+#endif //TURING_MACHINE_TAPECODEC_H
@@ -0,0 +1,79 @@
+#include "TapeSource.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<const TapeSource> TapeSource::map(const std::string& fileName) {
+    std::shared_ptr<TapeSource> source(new TapeSource());
+#if defined(_WIN32)
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+    source->owned.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    source->cells = source->owned.data();
+    source->length = source->owned.size();
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open file: " + fileName);
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Unable to read file: " + fileName);
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    if (size == 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Unable to open file: " + fileName);
+        }
+        source->owned.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        source->cells = source->owned.data();
+        source->length = source->owned.size();
+    } else {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Unable to map file: " + fileName);
+        }
+        // Blocks are loaded where the heads go, not front to back.
+        madvise(mapping, size, MADV_RANDOM);
+        source->mapping = mapping;
+        source->mappingSize = size;
+        source->cells = static_cast<const char*>(mapping);
+        source->length = size;
+    }
+#endif
+    if (source->length != 0 && source->cells[source->length - 1] == '\n') {
+        --source->length;
+        if (source->length != 0 && source->cells[source->length - 1] == '\r') {
+            --source->length;
+        }
+    }
+    return source;
+}
+
+TapeSource::~TapeSource() {
+#if !defined(_WIN32)
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+#endif
+}
+
+std::string_view TapeSource::block(std::size_t index) const {
+    const std::size_t first = index * BLOCK_SIZE;
+    return range(first, std::min(first + BLOCK_SIZE, length));
+}
@@ -0,0 +1,49 @@
+#ifndef TURING_MACHINE_TAPESOURCE_H
+#define TURING_MACHINE_TAPESOURCE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @class TapeSource
+ * @brief A tape file mapped read-only, from which tapes load their cells block by block.
+ *
+ * The file holds one tape written as in the description files; a final line break is not part
+ * of it. Nothing is read up front: the pages of a block are only faulted in when a tape loads
+ * it, and a source can back any number of tapes at once.
+ */
+class TapeSource {
+public:
+    /// Cells loaded at a time; the blocks of a tape start at multiples of this.
+    static constexpr std::size_t BLOCK_SIZE = 4096;
+
+    static std::shared_ptr<const TapeSource> map(const std::string& fileName);
+
+    TapeSource(const TapeSource&) = delete;
+    TapeSource& operator=(const TapeSource&) = delete;
+    ~TapeSource();
+
+    std::size_t size() const { return length; }
+    const char* data() const { return cells; }
+
+    /// The cells of block `index`, shorter than BLOCK_SIZE only for the last block.
+    std::string_view block(std::size_t index) const;
+
+    /// The cells in [first, last).
+    std::string_view range(std::size_t first, std::size_t last) const {
+        return std::string_view(cells + first, last - first);
+    }
+
+private:
+    TapeSource() = default;
+
+    const char* cells = nullptr;
+    std::size_t length = 0;
+    void* mapping = nullptr;   ///< The whole file; cells points into it.
+    std::size_t mappingSize = 0;
+    std::string owned;         ///< The file contents where it cannot be mapped.
+};
+
+#endif //TURING_MACHINE_TAPESOURCE_H
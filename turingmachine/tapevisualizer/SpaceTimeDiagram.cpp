@@ -0,0 +1,357 @@
+#include "SpaceTimeDiagram.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include "../machines/RegularExecution.h"
+#include "../machines/RegularTuringMachine.h"
+#include "../tape/Tape.h"
+
+#ifdef TM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+constexpr std::size_t HEIGHT_DIGITS = 20; ///< Room left for the height, enough for any 64-bit number.
+
+constexpr unsigned char WHITE[3] = {255, 255, 255};
+constexpr unsigned char HEAD[3] = {214, 39, 40};
+constexpr unsigned char START[3] = {190, 190, 190};
+constexpr unsigned char PALETTE[][3] = {
+        {31, 119, 180}, {255, 127, 14}, {44, 160, 44}, {148, 103, 189},
+        {140, 86, 75}, {227, 119, 194}, {127, 127, 127}, {23, 190, 207},
+};
+
+const unsigned char* colourOf(char symbol) {
+    if (symbol == ' ') {
+        return WHITE;
+    }
+    if (symbol == '>') {
+        return START;
+    }
+    return PALETTE[static_cast<unsigned char>(symbol) % (sizeof(PALETTE) / sizeof(PALETTE[0]))];
+}
+
+void putBigEndian(unsigned char* out, std::uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+/// Reads the unsigned number following `key` in a line of JSON.
+std::optional<std::string> fieldOf(const std::string& line, const char* key) {
+    const std::size_t start = line.find(key);
+    if (start == std::string::npos) {
+        return std::nullopt;
+    }
+    const std::size_t first = start + std::strlen(key);
+    const std::size_t last = line.find_first_not_of("0123456789", first);
+    if (last == first) {
+        return std::nullopt;
+    }
+    return line.substr(first, last == std::string::npos ? std::string::npos : last - first);
+}
+
+}
+
+/// The deflate stream of the pixel rows, written out as IDAT chunks.
+struct SpaceTimeDiagram::Png {
+#ifdef TM_HAVE_ZLIB
+    z_stream stream{};
+    std::unique_ptr<unsigned char[]> output{new unsigned char[CHUNK_SIZE]};
+
+    Png() {
+        if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            throw std::runtime_error("Unable to start compressing the image");
+        }
+    }
+
+    ~Png() {
+        deflateEnd(&stream);
+    }
+
+    static void writeChunk(std::ostream& out, const char* type, const unsigned char* data, std::size_t size) {
+        unsigned char field[4];
+        putBigEndian(field, static_cast<std::uint32_t>(size));
+        out.write(reinterpret_cast<const char*>(field), 4);
+        out.write(type, 4);
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+        if (size != 0) {
+            crc = crc32(crc, data, static_cast<uInt>(size)); // A null buffer would restart the checksum.
+        }
+        putBigEndian(field, static_cast<std::uint32_t>(crc));
+        out.write(reinterpret_cast<const char*>(field), 4);
+    }
+
+    void compress(std::ostream& out, const unsigned char* data, std::size_t size, int flush) {
+        stream.next_in = const_cast<Bytef*>(data);
+        stream.avail_in = static_cast<uInt>(size);
+        do {
+            stream.next_out = output.get();
+            stream.avail_out = static_cast<uInt>(CHUNK_SIZE);
+            deflate(&stream, flush);
+            if (stream.avail_out != CHUNK_SIZE) {
+                writeChunk(out, "IDAT", output.get(), CHUNK_SIZE - stream.avail_out);
+            }
+        } while (stream.avail_out == 0);
+    }
+#endif
+};
+
+bool SpaceTimeDiagram::isAvailable(Format format) {
+#ifdef TM_HAVE_ZLIB
+    constexpr bool haveZlib = true;
+#else
+    constexpr bool haveZlib = false;
+#endif
+    return haveZlib || format != Format::Png;
+}
+
+SpaceTimeDiagram::Format SpaceTimeDiagram::formatOf(const std::string& fileName) {
+    const std::string extension = ".png";
+    if (fileName.size() >= extension.size()) {
+        std::string end = fileName.substr(fileName.size() - extension.size());
+        std::transform(end.begin(), end.end(), end.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (end == extension) {
+            return Format::Png;
+        }
+    }
+    return Format::Ppm;
+}
+
+SpaceTimeDiagram::SpaceTimeDiagram(const std::string& fileName, const Options& options)
+        : fileName(fileName), options(options) {
+    if (options.columns == 0 || options.columns > std::numeric_limits<std::uint32_t>::max() / 3
+        || options.cellsPerColumn == 0 || options.stepsPerRow == 0) {
+        throw std::invalid_argument("Space-time diagrams need at least one column, cell and step per pixel");
+    }
+    if (!isAvailable(options.format)) {
+        throw std::invalid_argument("PNG images need a build with zlib");
+    }
+    file.open(fileName, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open or create file: " + fileName);
+    }
+    sums.resize(3 * options.columns);
+    row.resize(1 + 3 * options.columns); // The first byte is the PNG filter type, 0 for none.
+
+    // The height is written once the last row is in; its place is kept in the header until then.
+    if (options.format == Format::Ppm) {
+        const std::string header = "P6\n" + std::to_string(options.columns) + " ";
+        file << header << std::string(HEIGHT_DIGITS, ' ') << "\n255\n";
+        heightOffset = static_cast<std::streamoff>(header.size());
+        return;
+    }
+#ifdef TM_HAVE_ZLIB
+    png = std::make_unique<Png>();
+    file.write("\x89PNG\r\n\x1a\n", 8);
+    unsigned char header[13] = {};
+    putBigEndian(header, static_cast<std::uint32_t>(options.columns));
+    header[8] = 8; // Bits per channel.
+    header[9] = 2; // RGB.
+    Png::writeChunk(file, "IHDR", header, sizeof(header));
+    heightOffset = 8 + 8 + 4; // Signature, chunk length and type, width.
+#endif
+}
+
+SpaceTimeDiagram::~SpaceTimeDiagram() {
+    try {
+        finish();
+    } catch (const std::exception&) {
+        // Callers that care about a failed write call finish() themselves.
+    }
+}
+
+void SpaceTimeDiagram::addRow(const Tape* tape, std::size_t firstHead, std::size_t lastHead) {
+    if (finished) {
+        throw std::logic_error("Rows added to a finished space-time diagram");
+    }
+    const std::size_t perColumn = options.cellsPerColumn;
+    const std::size_t drawn = options.columns <= std::numeric_limits<std::size_t>::max() / perColumn
+                              ? options.columns * perColumn : std::numeric_limits<std::size_t>::max();
+    std::fill(sums.begin(), sums.end(), 0);
+    std::size_t position = 0;
+    if (tape != nullptr) {
+        tape->forEachChunk([&](const char* cells, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                const unsigned char* colour = colourOf(cells[i]);
+                std::uint64_t* sum = &sums[3 * ((position + i) / perColumn)];
+                sum[0] += colour[0];
+                sum[1] += colour[1];
+                sum[2] += colour[2];
+            }
+            position += count;
+        }, drawn);
+    }
+
+    // Cells past the end of the tape are blank.
+    unsigned char* pixel = row.data() + 1;
+    for (std::size_t column = 0; column < options.columns; ++column, pixel += 3) {
+        const std::size_t firstCell = column * perColumn;
+        const std::size_t filled = position > firstCell ? std::min(position - firstCell, perColumn) : 0;
+        const std::uint64_t blank = static_cast<std::uint64_t>(perColumn - filled) * 255;
+        for (std::size_t channel = 0; channel < 3; ++channel) {
+            pixel[channel] = static_cast<unsigned char>((sums[3 * column + channel] + blank) / perColumn);
+        }
+    }
+    if (firstHead > lastHead) {
+        std::swap(firstHead, lastHead);
+    }
+    const std::size_t lastColumn = std::min(lastHead / perColumn, options.columns - 1);
+    for (std::size_t column = firstHead / perColumn; column <= lastColumn; ++column) {
+        std::memcpy(row.data() + 1 + 3 * column, HEAD, 3);
+    }
+
+    if (png) {
+        writePixels(row.data(), row.size());
+    } else {
+        writePixels(row.data() + 1, row.size() - 1);
+    }
+    ++rows;
+}
+
+void SpaceTimeDiagram::writePixels(const unsigned char* pixels, std::size_t size) {
+#ifdef TM_HAVE_ZLIB
+    if (png) {
+        png->compress(file, pixels, size, Z_NO_FLUSH);
+        return;
+    }
+#endif
+    file.write(reinterpret_cast<const char*>(pixels), static_cast<std::streamsize>(size));
+}
+
+void SpaceTimeDiagram::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
+    if (png) {
+#ifdef TM_HAVE_ZLIB
+        png->compress(file, nullptr, 0, Z_FINISH);
+        Png::writeChunk(file, "IEND", nullptr, 0);
+        if (rows > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Too many rows for a PNG image: " + fileName);
+        }
+        // Rewrite the header with the height, and its checksum with it.
+        unsigned char header[4 + 13];
+        file.seekp(heightOffset - 8);
+        std::memcpy(header, "IHDR", 4);
+        putBigEndian(header + 4, static_cast<std::uint32_t>(options.columns));
+        putBigEndian(header + 8, static_cast<std::uint32_t>(rows));
+        header[12] = 8;
+        header[13] = 2;
+        header[14] = header[15] = header[16] = 0;
+        unsigned char crc[4];
+        putBigEndian(crc, static_cast<std::uint32_t>(crc32(0, header, sizeof(header))));
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(crc), sizeof(crc));
+#endif
+    } else {
+        file.seekp(heightOffset);
+        file << rows;
+    }
+    file.close();
+    if (file.fail()) {
+        throw std::runtime_error("Unable to write file: " + fileName);
+    }
+}
+
+std::size_t SpaceTimeDiagram::getRowCount() const {
+    return rows;
+}
+
+TuringMachine::Status SpaceTimeDiagram::record(TuringMachine& machine, const std::string& fileName,
+                                               const Options& options, std::uint64_t maxSteps) {
+    SpaceTimeDiagram diagram(fileName, options);
+    auto* regular = dynamic_cast<RegularTuringMachine*>(&machine);
+
+    TuringMachine::Status status = TuringMachine::Status::Running;
+    std::uint64_t remaining = maxSteps;
+    while (status == TuringMachine::Status::Running && remaining != 0) {
+        const std::uint64_t slice = std::min(options.stepsPerRow, remaining);
+        const std::uint64_t before = machine.getStepCount();
+        const std::size_t start = machine.getHeadPosition();
+        std::size_t firstHead = start;
+        std::size_t lastHead = start;
+        if (regular != nullptr) {
+            RegularExecution::HeadRange range{start, start};
+            status = regular->getExecution().run(slice, range);
+            firstHead = range.first;
+            lastHead = range.last;
+        } else {
+            // The head moves one cell at a time, so it visited every cell between two samples.
+            const std::uint64_t sample = std::max<std::uint64_t>(1, slice / 8);
+            for (std::uint64_t done = 0; done < slice && status == TuringMachine::Status::Running; done += sample) {
+                status = machine.advance(std::min(sample, slice - done));
+                const std::size_t head = machine.getHeadPosition();
+                firstHead = std::min(firstHead, head);
+                lastHead = std::max(lastHead, head);
+            }
+        }
+        const std::uint64_t taken = machine.getStepCount() - before;
+        if (taken == 0) {
+            break;
+        }
+        if (regular != nullptr) {
+            diagram.addRow(&regular->getExecution().getTape(), firstHead, lastHead);
+        } else {
+            Tape tape(machine.getOutput());
+            diagram.addRow(&tape, firstHead, lastHead);
+        }
+        if (remaining != TuringMachine::UNLIMITED) {
+            remaining -= std::min(taken, remaining);
+        }
+    }
+    diagram.finish();
+    return status;
+}
+
+std::size_t SpaceTimeDiagram::fromTrace(std::istream& trace, const std::string& fileName, const Options& options) {
+    SpaceTimeDiagram diagram(fileName, options);
+    std::optional<std::string> thread;
+    std::optional<std::size_t> previous;
+    std::size_t firstHead = 0;
+    std::size_t lastHead = 0;
+    std::uint64_t samples = 0;
+
+    std::string line;
+    while (std::getline(trace, line)) {
+        if (line.find("\"ph\":\"C\"") == std::string::npos) {
+            continue;
+        }
+        const auto tid = fieldOf(line, "\"tid\":");
+        const auto head = fieldOf(line, "\"head\":");
+        if (!head) {
+            throw std::runtime_error("Trace sample without a head position: " + line);
+        }
+        if (!thread) {
+            thread = tid;
+        } else if (tid != thread) {
+            continue;
+        }
+
+        const std::size_t position = std::stoull(*head);
+        const std::size_t from = previous.value_or(position);
+        const std::size_t low = std::min(from, position);
+        const std::size_t high = std::max(from, position);
+        firstHead = samples == 0 ? low : std::min(firstHead, low);
+        lastHead = samples == 0 ? high : std::max(lastHead, high);
+        previous = position;
+        if (++samples == options.stepsPerRow) {
+            diagram.addRow(nullptr, firstHead, lastHead);
+            samples = 0;
+        }
+    }
+    if (samples != 0) {
+        diagram.addRow(nullptr, firstHead, lastHead);
+    }
+    diagram.finish();
+    return diagram.getRowCount();
+}
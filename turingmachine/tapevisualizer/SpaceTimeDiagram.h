@@ -0,0 +1,95 @@
+#ifndef TURING_MACHINE_SPACETIMEDIAGRAM_H
+#define TURING_MACHINE_SPACETIMEDIAGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../machines/TuringMachine.h"
+
+class Tape;
+
+/**
+ * @class SpaceTimeDiagram
+ * @brief Draws a whole run as an image: time goes down, one pixel row per step, and the tape
+ * goes across, one pixel column per cell. The cells the head visited are drawn red.
+ *
+ * Rows are written to the file as they are added and only the current row is kept in memory,
+ * so the image height is not limited. For long runs, Options merge several steps into a row
+ * and several cells into a column; a row then shows the tape at its last step and every cell
+ * the head visited during its steps. Images are binary PPM (P6), or PNG when built with zlib.
+ */
+class SpaceTimeDiagram {
+public:
+    enum class Format {
+        Ppm,
+        Png
+    };
+
+    struct Options {
+        std::size_t columns = 1024;     ///< Width of the image; cells past the last column are not drawn.
+        std::size_t cellsPerColumn = 1; ///< Cells merged into one column, their colours averaged.
+        std::uint64_t stepsPerRow = 1;  ///< Steps, or trace samples, merged into one row.
+        Format format = Format::Ppm;
+    };
+
+    /// Whether the library was built with support for `format`.
+    static bool isAvailable(Format format);
+
+    /// PNG for file names ending in ".png", PPM otherwise.
+    static Format formatOf(const std::string& fileName);
+
+    /// Creates the image file; throws std::invalid_argument for bad options, std::runtime_error if it cannot be written.
+    SpaceTimeDiagram(const std::string& fileName, const Options& options);
+    ~SpaceTimeDiagram();
+
+    SpaceTimeDiagram(const SpaceTimeDiagram&) = delete;
+    SpaceTimeDiagram& operator=(const SpaceTimeDiagram&) = delete;
+
+    /**
+     * Adds the next row: the cells of `tape`, or blank cells if it is null, with the cells from
+     * `firstHead` to `lastHead` marked as visited by the head.
+     */
+    void addRow(const Tape* tape, std::size_t firstHead, std::size_t lastHead);
+
+    /// Writes the rest of the image and its final height; nothing can be added afterwards.
+    void finish();
+
+    std::size_t getRowCount() const;
+
+    /**
+     * Runs the machine for at most maxSteps, adding a row every stepsPerRow steps. REGULAR
+     * machines report exactly the cells the head visits, and their statistics, if enabled, keep
+     * counting. Other machines are sampled a few times per row and drawn with
+     * the cells between the sampled head positions.
+     */
+    static TuringMachine::Status record(TuringMachine& machine, const std::string& fileName, const Options& options,
+                                        std::uint64_t maxSteps = TuringMachine::UNLIMITED);
+
+    /**
+     * Draws the head samples of a trace written by Trace::writeChromeJson, one row for every
+     * stepsPerRow samples of the first thread that recorded any. Traces do not hold the tape,
+     * so only the head is drawn. Returns the number of rows.
+     */
+    static std::size_t fromTrace(std::istream& trace, const std::string& fileName, const Options& options);
+
+private:
+    struct Png;
+
+    void writePixels(const unsigned char* pixels, std::size_t size);
+
+    std::string fileName;
+    std::ofstream file;
+    Options options;
+    std::vector<std::uint64_t> sums; ///< Colour sums of the current row, three per column.
+    std::vector<unsigned char> row;  ///< Pixels of the current row, preceded by the PNG filter byte.
+    std::size_t rows = 0;
+    std::streamoff heightOffset = 0; ///< Where the height goes once it is known.
+    std::unique_ptr<Png> png;
+    bool finished = false;
+};
+
+#endif //TURING_MACHINE_SPACETIMEDIAGRAM_H
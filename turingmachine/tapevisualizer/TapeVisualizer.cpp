@@ -1,50 +1,204 @@
+#include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <sstream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <string_view>
 #include "TapeVisualizer.h"
+#include "../tape/Tape.h"
 #include <stdexcept>
 
-TapeVisualizer::TapeVisualizer(const std::string& tapeFilePath) : tapeFilePath(tapeFilePath) {}
+namespace {
 
-void TapeVisualizer::generateGraphvizFile(const std::string& outputFilePath) const {
-    std::ifstream tapeFile(tapeFilePath);
-    std::ofstream outFile(outputFilePath);
+constexpr std::size_t CHUNK_SIZE = 64 * 1024;
 
-    if (!tapeFile.is_open() || !outFile.is_open()) {
-        throw std::runtime_error("Error opening files.");
+/// Collects the output and hands it to the stream in large pieces.
+class BufferedWriter {
+public:
+    explicit BufferedWriter(std::ostream& out) : out(out) {
+        buffer.reserve(CHUNK_SIZE + 256);
+    }
+
+    ~BufferedWriter() {
+        flush();
+    }
+
+    BufferedWriter& operator<<(std::string_view text) {
+        buffer.append(text);
+        if (buffer.size() >= CHUNK_SIZE) {
+            flush();
+        }
+        return *this;
+    }
+
+    BufferedWriter& operator<<(std::size_t value) {
+        return *this << std::string_view(std::to_string(value));
+    }
+
+    void flush() {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
     }
 
-    std::string tapeContent;
-    std::getline(tapeFile, tapeContent);
+private:
+    std::ostream& out;
+    std::string buffer;
+};
+
+std::string cellLabel(char symbol) {
+    switch (symbol) {
+        case '>':
+            return "&#9658;"; // right-pointing triangle
+        case '"':
+        case '\\':
+        case '{':
+        case '}':
+        case '|':
+        case '<':
+            return std::string("\\") + symbol; // Record label syntax.
+        default:
+            return std::string(1, symbol);
+    }
+}
+
+/// Turns the cells of a tape, fed in order, into the nodes of the graph.
+class GraphvizRenderer {
+public:
+    GraphvizRenderer(std::ostream& out, const TapeVisualizer::Options& options) : writer(out), options(options) {
+        if (options.window != 0) {
+            const std::size_t head = options.head.value_or(0);
+            first = head - std::min(head, options.window);
+            last = options.window < std::numeric_limits<std::size_t>::max() - head ? head + options.window + 1
+                                                                                    : std::numeric_limits<std::size_t>::max();
+        }
+        writer << "digraph G {\n";
+        writer << "    rankdir=LR;\n"; // Ensure horizontal layout
+        writer << "    node [shape=record];\n";
+        writer << "    edge [color=white, arrowsize=0.01];\n"; // Set edge color to white and make arrows very small
+    }
 
-    outFile << "digraph G {\n";
-    outFile << "    rankdir=LR;\n"; // Ensure horizontal layout
-    outFile << "    node [shape=record];\n";
-    outFile << "    edge [color=white, arrowsize=0.01];\n"; // Set edge color to white and make arrows very small
+    void add(const char* cells, std::size_t count) {
+        const std::size_t end = position + count;
+        const std::size_t before = std::min(end, std::max(position, first)) - position;
+        const std::size_t inside = std::min(end, std::max(position + before, last)) - position - before;
+        skippedBefore += before;
+        skippedAfter += count - before - inside;
+        position += before;
+        for (std::size_t i = before; i < before + inside; ++i, ++position) {
+            cell(cells[i], options.head && position == *options.head);
+        }
+        position = end;
+    }
+
+    void finish() {
+        flushRun();
+        if (nodes == 0 && skippedBefore != 0) {
+            elision(skippedBefore);
+        }
+        if (skippedAfter != 0) {
+            elision(skippedAfter);
+        }
+        writer << "}\n";
+        writer.flush();
+    }
 
-    std::stringstream ss(tapeContent);
-    char symbol;
-    int index = 0;
+private:
+    void cell(char symbol, bool isHead) {
+        if (nodes == 0 && skippedBefore != 0) {
+            elision(skippedBefore);
+        }
+        if (options.minRun == 0) {
+            node(cellLabel(symbol), isHead);
+            return;
+        }
+        // The head always gets a node of its own.
+        if (runLength != 0 && (symbol != runSymbol || isHead || runHead)) {
+            flushRun();
+        }
+        runSymbol = symbol;
+        runHead = isHead;
+        ++runLength;
+    }
 
-    while (ss >> std::noskipws >> symbol) {
-        std::string label;
-        if (symbol == '>') {
-            label = "&#9658;"; // right-pointing triangle
-        } else if (symbol == ' ') {
-            label = " "; // Space symbol
+    void flushRun() {
+        if (runLength > 1 && runLength >= options.minRun) {
+            node(cellLabel(runSymbol) + " ×" + std::to_string(runLength), false);
         } else {
-            label = std::string(1, symbol);
+            for (std::size_t i = 0; i < runLength; ++i) {
+                node(cellLabel(runSymbol), runHead);
+            }
         }
+        runLength = 0;
+        runHead = false;
+    }
+
+    void elision(std::size_t cells) {
+        node("… " + std::to_string(cells) + (cells == 1 ? " cell" : " cells"), false, ", shape=plaintext");
+    }
 
-        outFile << "    node" << index << " [label=\"" << label << "\"];\n";
-        if (index > 0) {
-            outFile << "    node" << (index - 1) << " -> node" << index << ";\n";
+    void node(const std::string& label, bool isHead, std::string_view attributes = {}) {
+        writer << "    node" << nodes << " [label=\"" << label << "\"" << attributes;
+        if (isHead) {
+            writer << ", style=filled, fillcolor=lightblue";
         }
-        ++index;
+        writer << "];\n";
+        if (nodes > 0) {
+            writer << "    node" << (nodes - 1) << " -> node" << nodes << ";\n";
+        }
+        ++nodes;
+    }
+
+    BufferedWriter writer;
+    const TapeVisualizer::Options& options;
+    std::size_t first = 0;                                     ///< First cell of the window.
+    std::size_t last = std::numeric_limits<std::size_t>::max(); ///< One past the last cell of the window.
+    std::size_t position = 0;                                  ///< Index of the next cell fed in.
+    std::size_t skippedBefore = 0;
+    std::size_t skippedAfter = 0;
+    std::size_t nodes = 0;
+    char runSymbol = 0;
+    std::size_t runLength = 0;
+    bool runHead = false;
+};
+
+}
+
+TapeVisualizer::TapeVisualizer(const std::string& tapeFilePath) : tapeFilePath(tapeFilePath) {}
+
+void TapeVisualizer::generateGraphvizFile(const std::string& outputFilePath) const {
+    generateGraphvizFile(outputFilePath, Options{});
+}
+
+void TapeVisualizer::generateGraphvizFile(const std::string& outputFilePath, const Options& options) const {
+    std::ifstream tapeFile(tapeFilePath, std::ios::binary);
+    std::ofstream outFile(outputFilePath);
+
+    if (!tapeFile.is_open() || !outFile.is_open()) {
+        throw std::runtime_error("Error opening files.");
     }
 
-    outFile << "}\n";
+    GraphvizRenderer renderer(outFile, options);
+    std::unique_ptr<char[]> chunk(new char[CHUNK_SIZE]);
+    while (tapeFile.read(chunk.get(), static_cast<std::streamsize>(CHUNK_SIZE)) || tapeFile.gcount() > 0) {
+        const auto count = static_cast<std::size_t>(tapeFile.gcount());
+        const auto* newline = static_cast<const char*>(std::memchr(chunk.get(), '\n', count));
+        if (newline != nullptr) {
+            renderer.add(chunk.get(), static_cast<std::size_t>(newline - chunk.get()));
+            break;
+        }
+        renderer.add(chunk.get(), count);
+    }
+    renderer.finish();
+}
 
-    tapeFile.close();
-    outFile.close();
+void TapeVisualizer::writeGraphviz(const Tape& tape, std::ostream& out, Options options) {
+    if (!options.head && !tape.empty()) {
+        options.head = tape.getHeadPosition();
+    }
+    GraphvizRenderer renderer(out, options);
+    tape.forEachChunk([&renderer](const char* cells, std::size_t count) {
+        renderer.add(cells, count);
+    });
+    renderer.finish();
 }
@@ -2,14 +2,37 @@
 #define TURING_MACHINE_TAPEVISUALIZER_H
 
 
+#include <cstddef>
+#include <optional>
+#include <ostream>
 #include <string>
 
+class Tape;
+
+/**
+ * @class TapeVisualizer
+ * @brief Draws a tape as a Graphviz graph, one record node per cell.
+ *
+ * Tapes are read and drawn as a stream, so their length is not limited by memory. For tapes
+ * too long to lay out, Options restrict the drawing to a window around the head and merge
+ * runs of equal cells into single "×N" nodes; the cells left out are counted in "…" nodes.
+ */
 class TapeVisualizer {
 public:
+    struct Options {
+        std::optional<std::size_t> head; ///< Cell drawn highlighted; the window is centred on it.
+        std::size_t window = 0;          ///< Cells drawn on each side of the head; 0 draws the whole tape.
+        std::size_t minRun = 0;          ///< Runs of at least this many equal cells become one node; 0 never merges.
+    };
 
     explicit TapeVisualizer(const std::string& tapeFilePath);
 
     void generateGraphvizFile(const std::string& outputFilePath) const;
+    /// Draws the first line of the tape file as `options` ask, reading it a chunk at a time.
+    void generateGraphvizFile(const std::string& outputFilePath, const Options& options) const;
+
+    /// Draws a tape held in memory; the head is the tape's own unless `options` set one.
+    static void writeGraphviz(const Tape& tape, std::ostream& out, Options options);
 
 private:
     std::string tapeFilePath;
@@ -0,0 +1,156 @@
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Trace.h"
+
+namespace {
+
+struct Event {
+    const char* name;
+    char phase;              ///< 'X' for a complete event, 'C' for a sample.
+    std::uint64_t timestamp; ///< Nanoseconds on the steady clock.
+    std::uint64_t duration;
+    std::uint64_t state;
+    std::uint64_t head;
+};
+
+constexpr std::size_t CHUNK_SIZE = 4096;
+
+/// Events are appended by one thread and published through count, so readers never lock.
+struct Chunk {
+    Event events[CHUNK_SIZE];
+    std::atomic<std::size_t> count{0};
+    std::atomic<Chunk*> next{nullptr};
+};
+
+struct ThreadBuffer {
+    Chunk* first;
+    Chunk* last;
+    std::uint32_t threadId;
+
+    explicit ThreadBuffer(std::uint32_t id) : first(new Chunk()), last(first), threadId(id) {}
+    ~ThreadBuffer() { release(); }
+
+    void release() {
+        for (Chunk* chunk = first; chunk != nullptr;) {
+            Chunk* next = chunk->next.load(std::memory_order_acquire);
+            delete chunk;
+            chunk = next;
+        }
+        first = last = nullptr;
+    }
+
+    void append(const Event& event) {
+        std::size_t index = last->count.load(std::memory_order_relaxed);
+        if (index == CHUNK_SIZE) {
+            auto* chunk = new Chunk();
+            last->next.store(chunk, std::memory_order_release);
+            last = chunk;
+            index = 0;
+        }
+        last->events[index] = event;
+        last->count.store(index + 1, std::memory_order_release);
+    }
+};
+
+/// Owns the buffers, so the events of finished threads are kept until they are exported.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::uint64_t origin = 0;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(shared.buffers.size() + 1)));
+        buffer = shared.buffers.back().get();
+    }
+    return *buffer;
+}
+
+void writeMicroseconds(std::ostream& out, std::uint64_t nanoseconds) {
+    out << nanoseconds / 1000 << '.' << (nanoseconds % 1000) / 100 << (nanoseconds % 100) / 10 << nanoseconds % 10;
+}
+
+}
+
+std::atomic<bool> Trace::recording{false};
+std::atomic<std::uint64_t> Trace::sampleMask{(1u << 16) - 1};
+
+void Trace::start() {
+    Registry& shared = registry();
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (shared.origin == 0) {
+            shared.origin = now();
+        }
+    }
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop() {
+    recording.store(false, std::memory_order_relaxed);
+}
+
+void Trace::setSampleInterval(std::uint64_t interval) {
+    std::uint64_t rounded = 1;
+    while (rounded < interval && rounded < (std::uint64_t(1) << 62)) {
+        rounded <<= 1;
+    }
+    sampleMask.store(rounded - 1, std::memory_order_relaxed);
+}
+
+void Trace::complete(const char* name, std::uint64_t begin, std::uint64_t end) {
+    threadBuffer().append(Event{name, 'X', begin, end - begin, 0, 0});
+}
+
+void Trace::sample(const char* name, std::uint64_t state, std::uint64_t head) {
+    threadBuffer().append(Event{name, 'C', now(), 0, state, head});
+}
+
+void Trace::writeChromeJson(std::ostream& out) {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& buffer : shared.buffers) {
+        for (const Chunk* chunk = buffer->first; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)) {
+            const std::size_t count = chunk->count.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < count; ++i) {
+                const Event& event = chunk->events[i];
+                const std::uint64_t timestamp = event.timestamp > shared.origin ? event.timestamp - shared.origin : 0;
+                out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"turing_machine\",\"ph\":\""
+                    << event.phase << "\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":";
+                writeMicroseconds(out, timestamp);
+                if (event.phase == 'X') {
+                    out << ",\"dur\":";
+                    writeMicroseconds(out, event.duration);
+                    out << "}";
+                } else {
+                    out << ",\"args\":{\"state\":" << event.state << ",\"head\":" << event.head << "}}";
+                }
+                first = false;
+            }
+        }
+    }
+    out << "\n]}\n";
+}
+
+void Trace::clear() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for (auto& buffer : shared.buffers) {
+        buffer->release();
+        buffer->first = buffer->last = new Chunk();
+    }
+    shared.origin = recording.load(std::memory_order_relaxed) ? now() : 0;
+}
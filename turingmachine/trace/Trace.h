@@ -0,0 +1,101 @@
+/**
+ * @file Trace.h
+ * @brief Compile-time switchable instrumentation exported as Chrome trace / Perfetto JSON.
+ *
+ * Instrumentation points use the TM_TRACE_* macros, which expand to nothing unless the
+ * library is built with TM_ENABLE_TRACING. When compiled in, events are recorded only between
+ * Trace::start() and Trace::stop(), into a buffer owned by the recording thread.
+ */
+#ifndef TURING_MACHINE_TRACE_H
+#define TURING_MACHINE_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @class Trace
+ * @brief Process-wide trace recorder.
+ *
+ * Every thread appends to its own chunked buffer without locking; the exporter reads the
+ * published part of each buffer, so a trace can be written while other threads still record.
+ */
+class Trace {
+public:
+    /// Whether the library was built with TM_ENABLE_TRACING.
+    static constexpr bool isCompiledIn() {
+#ifdef TM_ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static void start();
+    static void stop();
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    /// Records one sample every `interval` steps of a run loop; rounded up to a power of two.
+    static void setSampleInterval(std::uint64_t interval);
+
+    static bool shouldSample(std::uint64_t step) {
+        return (step & sampleMask.load(std::memory_order_relaxed)) == 0 && isRecording();
+    }
+
+    static std::uint64_t now() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /// Records a complete event; name must be a string literal.
+    static void complete(const char* name, std::uint64_t begin, std::uint64_t end);
+
+    /// Records the current state and head position of a run loop.
+    static void sample(const char* name, std::uint64_t state, std::uint64_t head);
+
+    /// Writes every recorded event as a Chrome trace JSON object.
+    static void writeChromeJson(std::ostream& out);
+
+    /// Drops every recorded event; call it only while nothing is being traced.
+    static void clear();
+
+private:
+    static std::atomic<bool> recording;
+    static std::atomic<std::uint64_t> sampleMask;
+};
+
+/**
+ * @class TraceScope
+ * @brief Records the time between its construction and destruction as one event.
+ */
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), begin(Trace::isRecording() ? Trace::now() : 0) {}
+    ~TraceScope() {
+        if (begin != 0) {
+            Trace::complete(name, begin, Trace::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    std::uint64_t begin;
+};
+
+#define TM_TRACE_CONCAT_INNER(a, b) a##b
+#define TM_TRACE_CONCAT(a, b) TM_TRACE_CONCAT_INNER(a, b)
+
+#ifdef TM_ENABLE_TRACING
+#define TM_TRACE_SCOPE(name) TraceScope TM_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TM_TRACE_SAMPLE(name, step, state, head) \
+    do { if (Trace::shouldSample(step)) Trace::sample(name, state, head); } while (0)
+#else
+#define TM_TRACE_SCOPE(name) ((void)0)
+#define TM_TRACE_SAMPLE(name, step, state, head) ((void)0)
+#endif
+
+#endif //TURING_MACHINE_TRACE_H